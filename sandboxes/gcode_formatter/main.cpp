@@ -0,0 +1,121 @@
+#include <array>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <string>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <libslic3r/GCodeWriter.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Measures the throughput of the G-code fixed point number formatting used by GCodeWriter
+// compared to the previous std::to_chars based formatter and to printf style formatting.
+//
+// Usage: gcode_formatter [number of moves, 10M by default]
+
+namespace Slic3r {
+
+// The formatter used by GCodeFormatter::emit_axis() before the table driven one:
+// the scaled integer is printed by std::to_chars, then the digits are moved to make space for the decimal point.
+static char* emit_axis_to_chars(char *ptr, char *end, const char axis, const double v, size_t digits)
+{
+    static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    *ptr++ = ' '; *ptr++ = axis;
+    char *base_ptr = ptr;
+    auto  v_int    = int64_t(std::round(v * pow_10[digits]));
+    ptr = std::to_chars(ptr, end - 1, v_int).ptr;
+    size_t writen_digits = (ptr - base_ptr) - (v_int < 0 ? 1 : 0);
+    if (writen_digits < digits) {
+        size_t remaining_digits = digits - writen_digits;
+        for (char *from_ptr = ptr - 1, *to_ptr = from_ptr + remaining_digits; from_ptr >= ptr - writen_digits; --to_ptr, --from_ptr)
+            *to_ptr = *from_ptr;
+        memset(ptr - writen_digits, '0', remaining_digits);
+        ptr += remaining_digits;
+    }
+    for (char *to_ptr = ptr, *from_ptr = to_ptr - 1; from_ptr >= ptr - digits; --to_ptr, --from_ptr)
+        *to_ptr = *from_ptr;
+    *(ptr - digits) = '.';
+    for (size_t i = 0; i < digits; ++i) {
+        if (*ptr != '0')
+            break;
+        ptr--;
+    }
+    if (*ptr == '.')
+        ptr--;
+    if ((ptr + 1) == base_ptr || *ptr == '-')
+        *(++ptr) = '0';
+    return ++ptr;
+}
+
+struct Move
+{
+    Vec2d  xy;
+    double e;
+};
+
+static std::vector<Move> random_moves(size_t num_moves)
+{
+    std::mt19937                           rng(0);
+    std::uniform_real_distribution<double> coord(0., 256.);
+    std::uniform_real_distribution<double> extrusion(-0.8, 0.2);
+    std::vector<Move>                      moves(num_moves);
+    for (Move &move : moves)
+        move = { Vec2d(coord(rng), coord(rng)), std::max(0., extrusion(rng)) };
+    return moves;
+}
+
+template<class Fn>
+static void measure(const char *name, const std::vector<Move> &moves, Fn fn)
+{
+    Benchmark b;
+    size_t    num_chars = 0;
+    b.start();
+    for (const Move &move : moves)
+        num_chars += fn(move);
+    b.stop();
+    const double sec = b.getElapsedSec();
+    std::cout << name << ": " << sec << " s, " << double(moves.size()) / sec * 1e-6 << " M moves/s, " << num_chars << " chars" << std::endl;
+}
+
+} // namespace Slic3r
+
+int main(const int argc, const char *argv[])
+{
+    using namespace Slic3r;
+
+    const size_t            num_moves = argc > 1 ? size_t(std::stoull(argv[1])) : size_t(10000000);
+    const std::vector<Move> moves     = random_moves(num_moves);
+
+    measure("GCodeG1Formatter", moves, [](const Move &move) {
+        GCodeG1Formatter w;
+        w.emit_xy(move.xy);
+        if (move.e > 0.)
+            w.emit_e(move.e);
+        return w.string().size();
+    });
+
+    measure("std::to_chars", moves, [](const Move &move) {
+        char  buf[256] = { 'G', '1' };
+        char *ptr      = buf + 2;
+        ptr = emit_axis_to_chars(ptr, buf + sizeof(buf), 'X', move.xy.x(), GCodeFormatter::XYZF_EXPORT_DIGITS);
+        ptr = emit_axis_to_chars(ptr, buf + sizeof(buf), 'Y', move.xy.y(), GCodeFormatter::XYZF_EXPORT_DIGITS);
+        if (move.e > 0.)
+            ptr = emit_axis_to_chars(ptr, buf + sizeof(buf), 'E', move.e, GCodeFormatter::E_EXPORT_DIGITS);
+        *ptr++ = '\n';
+        return std::string(buf, ptr - buf).size();
+    });
+
+    measure("snprintf", moves, [](const Move &move) {
+        char buf[256];
+        int  len = move.e > 0. ?
+            snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f E%.5f\n", move.xy.x(), move.xy.y(), move.e) :
+            snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f\n", move.xy.x(), move.xy.y());
+        return std::string(buf, len).size();
+    });
+
+    return EXIT_SUCCESS;
+}
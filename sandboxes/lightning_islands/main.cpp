@@ -0,0 +1,78 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tbb/global_control.h>
+
+#include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/Fill/Lightning/Generator.hpp>
+#include <libslic3r/Fill/Lightning/TreeNode.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Measures the Lightning tree generator on layers of circular islands laid out in a grid, shrinking towards the bottom.
+// The islands of a layer are grown in parallel. The printed numbers of roots, nodes and the length of the trees
+// shall not depend on the number of threads.
+//
+// Usage: lightning_islands [number of threads, 1 by default] [number of islands, 60 by default] [number of layers, 100 by default]
+
+int main(const int argc, const char *argv[])
+{
+    using namespace Slic3r;
+
+    const size_t num_threads = argc > 1 ? size_t(std::stoul(argv[1])) : size_t(1);
+    const int    num_islands = argc > 2 ? std::stoi(argv[2]) : 60;
+    const int    num_layers  = argc > 3 ? std::stoi(argv[3]) : 100;
+    tbb::global_control control(tbb::global_control::max_allowed_parallelism, num_threads);
+
+    // The generator takes the line width, the layer height and the nozzle diameter from the object.
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    Model              model;
+    ModelObject       *object = model.add_object();
+    object->add_volume(TriangleMesh(its_make_cube(10., 10., 10.)));
+    object->add_instance();
+    Print print;
+    print.apply(model, config);
+    PrintObject *print_object = print.get_object(0);
+
+    const int             cols = int(std::ceil(std::sqrt(double(num_islands))));
+    const coord_t         wall = scaled<coord_t>(print_object->config().layer_height.value);
+    std::vector<Polygons> contours(num_layers), overhangs(num_layers);
+    for (int layer_id = 0; layer_id < num_layers; ++ layer_id)
+        for (int island_id = 0; island_id < num_islands; ++ island_id) {
+            const double radius = std::max(4., 30. - 2. * double(layer_id / 20)) * (1. - 0.05 * double(island_id % 4));
+            const Vec2d  center(70. * double(island_id % cols), 70. * double(island_id / cols));
+            Polygon      circle;
+            for (int i = 0; i < 256; ++ i)
+                circle.points.emplace_back(Point::new_scale(center.x() + radius * std::cos(2. * PI * i / 256), center.y() + radius * std::sin(2. * PI * i / 256)));
+            contours[layer_id].emplace_back(std::move(circle));
+        }
+    for (int layer_id = 0; layer_id < num_layers; ++ layer_id)
+        overhangs[layer_id] = layer_id + 1 < num_layers ?
+            diff(offset(contours[layer_id], -float(wall)), contours[layer_id + 1]) :
+            offset(contours[layer_id], -float(wall));
+
+    Benchmark b;
+    b.start();
+    FillLightning::Generator generator(print_object, contours, overhangs, []() {});
+    b.stop();
+
+    size_t num_roots = 0;
+    size_t num_nodes = 0;
+    double length    = 0.;
+    for (int layer_id = 0; layer_id < num_layers; ++ layer_id) {
+        const FillLightning::Layer &layer = generator.getTreesForLayer(size_t(layer_id));
+        num_roots += layer.tree_roots.size();
+        for (const FillLightning::NodeSPtr &root : layer.tree_roots)
+            root->visitNodes([&num_nodes](FillLightning::NodeSPtr) { ++ num_nodes; });
+        length += unscaled(total_length(layer.convertToLines(contours[layer_id], 0)));
+    }
+    std::cout << num_islands << " islands, " << num_layers << " layers, " << num_threads << " threads: " << b.getElapsedSec() << " s, " <<
+        num_roots << " roots, " << num_nodes << " nodes, " << length << " mm" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/RayPacketBVH.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Measures the first hits of rays cast from the surface of a finely tessellated sphere with a cube sticking out of it,
+// the way the seam placer estimates visibility: rays of a sample point are traced one by one through AABBTreeIndirect
+// and in packets through RayPacketBVH with each of the kernels supported by the CPU. Verifies that all of them hit
+// the same triangles.
+//
+// Usage: ray_packet_kernel [number of sample points, 30000 by default]
+
+namespace Slic3r {
+
+static const char* kernel_name(RayPacketKernel kernel)
+{
+    switch (kernel) {
+    case RayPacketKernel::SSE:  return "SSE";
+    case RayPacketKernel::AVX2: return "AVX2";
+    case RayPacketKernel::NEON: return "NEON";
+    default:                    return "Scalar";
+    }
+}
+
+} // namespace Slic3r
+
+int main(const int argc, const char *argv[])
+{
+    using namespace Slic3r;
+
+    const size_t num_samples     = argc > 1 ? size_t(std::stoul(argv[1])) : size_t(30000);
+    const size_t rays_per_sample = 25;
+
+    // About 500k triangles.
+    indexed_triangle_set its = its_make_sphere(50., PI / 360.);
+    its_merge(its, its_make_cube(20., 20., 120.));
+
+    // Rays from the sphere surface, either into the sphere or out of it.
+    std::mt19937                    rng(0);
+    std::normal_distribution<float> normal;
+    std::vector<Vec3f>              samples, origins, dirs;
+    for (size_t i = 0; i < num_samples; ++ i)
+        samples.emplace_back(49.9f * Vec3f(normal(rng), normal(rng), normal(rng)).normalized());
+    // Neighbour samples close to each other, as the samples of the consecutive triangles of a mesh.
+    std::sort(samples.begin(), samples.end(), [](const Vec3f &l, const Vec3f &r) {
+        const int lz = int(std::floor(l.z())), rz = int(std::floor(r.z()));
+        return lz < rz || (lz == rz && std::atan2(l.y(), l.x()) < std::atan2(r.y(), r.x()));
+    });
+    for (const Vec3f &origin : samples) {
+        for (size_t j = 0; j < rays_per_sample; ++ j) {
+            origins.emplace_back(origin);
+            dirs.emplace_back(Vec3f(normal(rng), normal(rng), normal(rng)).normalized());
+        }
+    }
+    std::cout << its.indices.size() << " triangles, " << origins.size() << " rays" << std::endl;
+
+    Benchmark b;
+    b.start();
+    const auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    b.stop();
+    std::cout << "AABBTreeIndirect build: " << b.getElapsedSec() << " s" << std::endl;
+    b.start();
+    std::vector<int> reference(origins.size(), -1);
+    for (size_t i = 0; i < origins.size(); ++ i) {
+        igl::Hit hit;
+        if (AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, Vec3d(origins[i].cast<double>()), Vec3d(dirs[i].cast<double>()), hit))
+            reference[i] = hit.id;
+    }
+    b.stop();
+    std::cout << "AABBTreeIndirect: " << b.getElapsedSec() << " s" << std::endl;
+
+    b.start();
+    const RayPacketBVH bvh(its);
+    b.stop();
+    std::cout << "RayPacketBVH build: " << b.getElapsedSec() << " s, " << bvh.num_nodes() << " nodes" << std::endl;
+    for (RayPacketKernel kernel : { RayPacketKernel::Scalar, RayPacketKernel::SSE, RayPacketKernel::AVX2, RayPacketKernel::NEON }) {
+        if (! set_ray_packet_kernel(kernel))
+            continue;
+        std::vector<int>   ids(origins.size());
+        std::vector<float> ts(origins.size());
+        b.start();
+        for (size_t begin = 0; begin < origins.size(); begin += RayPacketBVH::PacketSize) {
+            RayPacketBVH::Packet packet;
+            for (size_t i = begin; i < std::min(origins.size(), begin + RayPacketBVH::PacketSize); ++ i)
+                packet.push_back(origins[i], dirs[i]);
+            bvh.first_hits(packet, ids.data() + begin, ts.data() + begin);
+        }
+        b.stop();
+        // The rays grazing a shared edge may hit either of the two triangles.
+        size_t different = 0;
+        for (size_t i = 0; i < ids.size(); ++ i)
+            if (ids[i] != reference[i])
+                ++ different;
+        std::cout << kernel_name(kernel) << ": " << b.getElapsedSec() << " s, " << different << " different hits" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tbb/global_control.h>
+
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/TriangleMeshSlicer.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Measures slice_mesh() of a finely tessellated sphere with each of the kernels intersecting the facets with the slicing planes
+// supported by the CPU, and verifies that all the kernels produce the same layers.
+//
+// Usage: slice_facet_kernel [number of threads, 1 by default] [layer height, 0.05 by default]
+
+namespace Slic3r {
+
+static const char* kernel_name(SliceFacetKernel kernel)
+{
+    switch (kernel) {
+    case SliceFacetKernel::AVX2: return "AVX2";
+    case SliceFacetKernel::NEON: return "NEON";
+    default:                     return "Scalar";
+    }
+}
+
+} // namespace Slic3r
+
+int main(const int argc, const char *argv[])
+{
+    using namespace Slic3r;
+
+    const size_t num_threads  = argc > 1 ? size_t(std::stoul(argv[1])) : size_t(1);
+    const float  layer_height = argc > 2 ? std::stof(argv[2]) : 0.05f;
+    tbb::global_control control(tbb::global_control::max_allowed_parallelism, num_threads);
+
+    // About 2M triangles.
+    const indexed_triangle_set its = its_make_sphere(50., PI / 720.);
+    std::vector<float> zs;
+    for (float z = -50.f + 0.5f * layer_height; z < 50.f; z += layer_height)
+        zs.emplace_back(z);
+    std::cout << its.indices.size() << " triangles, " << zs.size() << " layers, " << num_threads << " threads" << std::endl;
+
+    const std::vector<Vec3i> face_edge_ids = its_face_edge_ids(its);
+    MeshSlicingParams params;
+    params.face_edge_ids = &face_edge_ids;
+
+    std::vector<Polygons> reference;
+    for (SliceFacetKernel kernel : { SliceFacetKernel::Scalar, SliceFacetKernel::AVX2, SliceFacetKernel::NEON }) {
+        if (! set_slice_facet_kernel(kernel))
+            continue;
+        Benchmark b;
+        b.start();
+        std::vector<Polygons> layers = slice_mesh(its, zs, params);
+        b.stop();
+        std::cout << kernel_name(kernel) << ": " << b.getElapsedSec() << " s";
+        if (reference.empty())
+            reference = std::move(layers);
+        else
+            std::cout << (layers == reference ? ", same layers" : ", DIFFERENT LAYERS");
+        std::cout << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -48,12 +48,15 @@ using namespace nlohmann;
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
 #include "libslic3r/Platform.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SLAPrint.hpp"
+#include "libslic3r/SliceCache.hpp"
+#include "libslic3r/Fill/FillCache.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/AMF.hpp"
 #include "libslic3r/Format/3mf.hpp"
@@ -1384,6 +1387,15 @@ int CLI::run(int argc, char **argv)
     std::string temp_path = wxFileName::GetTempDir().utf8_str().data();
     set_temporary_dir(temp_path);
 
+    // Reuse the slices of the objects already sliced with the same layers, see SliceCache.
+    if (const ConfigOptionInt *slice_cache_size_option = m_config.option<ConfigOptionInt>("slice_cache_size"); slice_cache_size_option && slice_cache_size_option->value > 0)
+        SliceCache::get_instance().set_max_memory(size_t(slice_cache_size_option->value) << 20);
+    if (const ConfigOptionString *slice_cache_dir_option = m_config.option<ConfigOptionString>("slice_cache_dir"); slice_cache_dir_option && ! slice_cache_dir_option->value.empty())
+        SliceCache::get_instance().set_dir(slice_cache_dir_option->value);
+    // Reuse the infill of the surfaces already filled by other objects, see FillCache.
+    if (const ConfigOptionInt *infill_cache_size_option = m_config.option<ConfigOptionInt>("infill_cache_size"); infill_cache_size_option && infill_cache_size_option->value > 0)
+        FillCache::get_instance().set_max_memory(size_t(infill_cache_size_option->value) << 20);
+
     m_extra_config.apply(m_config, true);
     m_extra_config.normalize_fdm();
 
@@ -6203,6 +6215,9 @@ int CLI::run(int argc, char **argv)
                                     }
                                     BOOST_LOG_TRIVIAL(info) << "process finished, will export gcode temporily to " << outfile << std::endl;
                                     temp_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                                    // The slicing data are exported from the layers after the G-code export, keep them in that case.
+                                    const ConfigOptionBool *release_layers_option = m_config.option<ConfigOptionBool>("release_layers_after_export");
+                                    print_fff->set_release_layers_after_export(release_layers_option && release_layers_option->value && !export_slicedata);
                                     if (is_bbl_vendor_preset) {
                                         outfile = print_fff->export_gcode(outfile, gcode_result, nullptr);
                                     }
@@ -6228,6 +6243,18 @@ int CLI::run(int argc, char **argv)
                                         flush_and_exit(CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER);
                                     }
 
+                                    if (const ConfigOptionBool *binary_gcode_option = m_config.option<ConfigOptionBool>("export_binary_gcode"); binary_gcode_option && binary_gcode_option->value) {
+                                        std::string binary_outfile = boost::filesystem::path(outfile).replace_extension(".bgcode").string();
+                                        try {
+                                            BinaryGCode::convert_ascii_to_binary(outfile, binary_outfile);
+                                        } catch (const std::exception &ex) {
+                                            BOOST_LOG_TRIVIAL(error) << "plate " << index + 1 << ": failed to convert " << outfile << " to binary G-code " << binary_outfile << ": " << ex.what();
+                                            record_exit_reson(outfile_dir, CLI_SLICING_ERROR, index + 1, cli_errors[CLI_SLICING_ERROR], sliced_info);
+                                            flush_and_exit(CLI_SLICING_ERROR);
+                                        }
+                                        BOOST_LOG_TRIVIAL(info) << "plate " << index + 1 << ": binary G-code exported to " << binary_outfile;
+                                    }
+
                                     //outfile_final = (dynamic_cast<Print*>(print))->print_statistics().finalize_output_path(outfile);
                                     //m_fff_print->export_gcode(m_temp_output_path, m_gcode_result, [this](const ThumbnailsParams& params) { return this->render_thumbnails(params); });
                                 }/* else {
@@ -377,6 +377,11 @@ void AppConfig::set_defaults()
         set("max_recent_count", "18");
     }
 
+    // Size of the G-code of the last export of a plate kept in memory in MB, 0 disables the cache.
+    if (get("gcode_layer_cache_size").empty()) {
+        set("gcode_layer_cache_size", "0");
+    }
+
     if (get("staff_pick_switch").empty()) {
         set_bool("staff_pick_switch", true);
     }
@@ -57,6 +57,20 @@ public:
     double retract_length_toolchange() const;
     double retract_restart_extra_toolchange() const;
 
+    // State of the extruder axis, saved and restored by GCodeWriter::get_state() / set_state().
+    struct State
+    {
+        double E;
+        double absolute_E;
+        double retracted;
+        double restart_extra;
+    };
+    State  get_state() const { return { m_E, m_absolute_E, m_retracted, m_restart_extra }; }
+    void   set_state(const State &state) { m_E = state.E; m_absolute_E = state.absolute_E; m_retracted = state.retracted; m_restart_extra = state.restart_extra; }
+    // State of the axes shared by the filaments of a single extruder multi-material machine.
+    static void get_shared_state(std::vector<double> &E, std::vector<double> &retracted) { E = m_share_E; retracted = m_share_retracted; }
+    static void set_shared_state(const std::vector<double> &E, const std::vector<double> &retracted) { m_share_E = E; m_share_retracted = retracted; }
+
 private:
     // Private constructor to create a key for a search in std::set.
     Extruder(unsigned int id) : m_id(id) {}
@@ -10,6 +10,7 @@
 #include "../Surface.hpp"
 
 #include "FillBase.hpp"
+#include "FillCache.hpp"
 #include "FillRectilinear.hpp"
 #include "FillLightning.hpp"
 #include "FillConcentricInternal.hpp"
@@ -552,6 +553,7 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
     std::vector<SurfaceFill>     surface_fills = group_fills(*this, lock_param);
 	const Slic3r::BoundingBox bbox 			= this->object()->bounding_box();
 	const auto                resolution 	= this->object()->print()->config().resolution.value;
+	FillCache                &fill_cache    = FillCache::get_instance();
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
 	{
@@ -687,6 +689,8 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 		if (surface_fill.params.pattern == ipGrid || surface_fill.params.pattern == ipFloatingConcentric)
 			params.can_reverse = false;
 		LayerRegion* layerm = this->m_regions[surface_fill.region_id];
+		// Surfaces filled the same way by another object, for example by a copy of this object, are cloned from the cache.
+		const bool use_fill_cache = fill_cache.enabled() && FillCache::pattern_cacheable(surface_fill.params.pattern);
 		for (ExPolygon& expoly : surface_fill.expolygons) {
 
       f->no_overlap_expolygons = intersection_ex(surface_fill.no_overlap_expolygons, ExPolygons() = {expoly}, ApplySafetyOffset::Yes);
@@ -699,7 +703,16 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 			f->spacing = surface_fill.params.spacing;
 			surface_fill.surface.expolygon = std::move(expoly);
 			// BBS: make fill
-			f->fill_surface_extrusion(&surface_fill.surface, params, m_regions[surface_fill.region_id]->fills.entities);
+			ExtrusionEntitiesPtr &fills = m_regions[surface_fill.region_id]->fills.entities;
+			if (use_fill_cache) {
+				FillCache::Key key(surface_fill.params.pattern, *f, params, surface_fill.surface);
+				if (! fill_cache.get(key, fills)) {
+					size_t first = fills.size();
+					f->fill_surface_extrusion(&surface_fill.surface, params, fills);
+					fill_cache.put(key, fills, first);
+				}
+			} else
+				f->fill_surface_extrusion(&surface_fill.surface, params, fills);
 		}
     }
 
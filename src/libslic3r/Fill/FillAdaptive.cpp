@@ -15,6 +15,7 @@
 #include <cmath>
 #include <algorithm>
 #include <numeric>
+#include <string_view>
 
 // Boost pool: Don't use mutexes to synchronize memory allocation.
 #define BOOST_POOL_NO_MT
@@ -24,6 +25,11 @@
 #include <boost/geometry/geometries/point.hpp>
 #include <boost/geometry/geometries/segment.hpp>
 #include <boost/geometry/index/rtree.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <ankerl/unordered_dense.h>
+
+#include <tbb/parallel_for.h>
 
 
 namespace Slic3r {
@@ -259,14 +265,18 @@ struct Octree
     // Octree will allocate its Cubes from the pool. The pool only supports deletion of the complete pool,
     // perfect for building up our octree.
     boost::object_pool<Cube>    pool;
+    // The subtrees of the root cube are built in parallel, each of them allocates its Cubes from its own pool.
+    std::array<boost::object_pool<Cube>, 8> child_pools;
     Cube*                       root_cube { nullptr };
     Vec3d                       origin;
     std::vector<CubeProperties> cubes_properties;
+    // Hash of the mesh, of the overhang triangles and of the parameters the octree was built from.
+    uint64_t                    inputs_hash { 0 };
 
     Octree(const Vec3d &origin, const std::vector<CubeProperties> &cubes_properties)
         : root_cube(pool.construct(origin)), origin(origin), cubes_properties(cubes_properties) {}
 
-    void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth);
+    void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth, boost::object_pool<Cube> &cube_pool);
 };
 
 void OctreeDeleter::operator()(Octree *p) {
@@ -1462,6 +1472,40 @@ static void transform_center(Cube *current_cube, const Eigen::Matrix3d &rot)
             transform_center(child, rot);
 }
 
+// Hash of the inputs of build_octree() to find out whether an octree built before may be reused.
+static uint64_t octree_inputs_hash(const indexed_triangle_set &triangle_mesh, const std::vector<Vec3d> &overhang_triangles, coordf_t line_spacing, bool support_overhangs_only)
+{
+    auto hash_data = [](const auto &data) -> uint64_t {
+        return ankerl::unordered_dense::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(typename std::decay_t<decltype(data)>::value_type)));
+    };
+    size_t seed = 0;
+    boost::hash_combine(seed, hash_data(triangle_mesh.vertices));
+    boost::hash_combine(seed, hash_data(triangle_mesh.indices));
+    boost::hash_combine(seed, hash_data(overhang_triangles));
+    boost::hash_combine(seed, line_spacing);
+    boost::hash_combine(seed, support_overhangs_only);
+    return uint64_t(seed);
+}
+
+// Slightly expanded bounding box of a child cube to cope with triangles touching a cube wall and other numeric errors.
+// We will rather densify the octree a bit more than necessary instead of missing a triangle.
+static BoundingBoxf3 child_bbox(const Cube &cube, const BoundingBoxf3 &cube_bbox, size_t child_idx)
+{
+    const Vec3d  &child_center_dir = child_centers[child_idx];
+    BoundingBoxf3 bbox;
+    for (int k = 0; k < 3; ++ k) {
+        if (child_center_dir[k] == -1.) {
+            bbox.min[k] = cube_bbox.min[k];
+            bbox.max[k] = cube.center[k] + EPSILON;
+        } else {
+            bbox.min[k] = cube.center[k] - EPSILON;
+            bbox.max[k] = cube_bbox.max[k];
+        }
+    }
+    return bbox;
+}
+
 OctreePtr build_octree(
     // Mesh is rotated to the coordinate system of the octree.
     const indexed_triangle_set  &triangle_mesh,
@@ -1469,38 +1513,61 @@ OctreePtr build_octree(
     // rotated to the coordinate system of the octree.
     const std::vector<Vec3d>    &overhang_triangles, 
     coordf_t                     line_spacing,
-    bool                         support_overhangs_only)
+    bool                         support_overhangs_only,
+    OctreePtr                  &&previous)
 {
     assert(line_spacing > 0);
     assert(! std::isnan(line_spacing));
 
+    const uint64_t inputs_hash = octree_inputs_hash(triangle_mesh, overhang_triangles, line_spacing, support_overhangs_only);
+    if (previous && previous->inputs_hash == inputs_hash)
+        return std::move(previous);
+    // Release the memory of the previous octree before building a new one.
+    previous.reset();
+
     BoundingBox3Base<Vec3f>     bbox(triangle_mesh.vertices);
     Vec3d                       cube_center      = bbox.center().cast<double>();
     std::vector<CubeProperties> cubes_properties = make_cubes_properties(double(bbox.size().maxCoeff()), line_spacing);
     auto                        octree           = OctreePtr(new Octree(cube_center, cubes_properties));
+    octree->inputs_hash = inputs_hash;
 
     if (cubes_properties.size() > 1) {
         Octree *octree_ptr = octree.get();
         double edge_length_half = 0.5 * cubes_properties.back().edge_length;
         Vec3d  diag_half(edge_length_half, edge_length_half, edge_length_half);
         int    max_depth = int(cubes_properties.size()) - 1;
-        auto process_triangle = [octree_ptr, max_depth, diag_half](const Vec3d &a, const Vec3d &b, const Vec3d &c) {
-            octree_ptr->insert_triangle(
-                a, b, c,
-                octree_ptr->root_cube,
-                BoundingBoxf3(octree_ptr->root_cube->center - diag_half, octree_ptr->root_cube->center + diag_half),
-                max_depth);
-        };
         auto up_vector = support_overhangs_only ? Vec3d(transform_to_octree() * Vec3d(0., 0., 1.)) : Vec3d();
-        for (auto &tri : triangle_mesh.indices) {
-            auto a = triangle_mesh.vertices[tri[0]].cast<double>();
-            auto b = triangle_mesh.vertices[tri[1]].cast<double>();
-            auto c = triangle_mesh.vertices[tri[2]].cast<double>();
-            if (! support_overhangs_only || is_overhang_triangle(a, b, c, up_vector))
-                process_triangle(a, b, c);
-        }
-        for (size_t i = 0; i < overhang_triangles.size(); i += 3)
-            process_triangle(overhang_triangles[i], overhang_triangles[i + 1], overhang_triangles[i + 2]);
+        Cube         *root_cube = octree_ptr->root_cube;
+        BoundingBoxf3 root_bbox(root_cube->center - diag_half, root_cube->center + diag_half);
+        // The children of the root cube are independent of each other, thus each of their subtrees is built by its own task
+        // from its own pool. The shape of the octree does not depend on the order of the inserted triangles.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, 8, 1), [octree_ptr, &triangle_mesh, &overhang_triangles, support_overhangs_only, &up_vector, root_cube, &root_bbox, max_depth](const tbb::blocked_range<size_t> &range) {
+            for (size_t child_idx = range.begin(); child_idx < range.end(); ++ child_idx) {
+                const BoundingBoxf3       bbox         = child_bbox(*root_cube, root_bbox, child_idx);
+                const int                 depth        = max_depth - 1;
+                const Vec3d               child_center = root_cube->center + (child_centers[child_idx] * (octree_ptr->cubes_properties[depth].edge_length / 2.));
+                boost::object_pool<Cube> &cube_pool    = octree_ptr->child_pools[child_idx];
+                Cube                     *child        = nullptr;
+                auto process_triangle = [octree_ptr, &bbox, depth, &child_center, &cube_pool, &child](const Vec3d &a, const Vec3d &b, const Vec3d &c) {
+                    if (triangle_AABB_intersects(a, b, c, bbox)) {
+                        if (! child)
+                            child = cube_pool.construct(child_center);
+                        if (depth > 0)
+                            octree_ptr->insert_triangle(a, b, c, child, bbox, depth, cube_pool);
+                    }
+                };
+                for (auto &tri : triangle_mesh.indices) {
+                    auto a = triangle_mesh.vertices[tri[0]].cast<double>();
+                    auto b = triangle_mesh.vertices[tri[1]].cast<double>();
+                    auto c = triangle_mesh.vertices[tri[2]].cast<double>();
+                    if (! support_overhangs_only || is_overhang_triangle(a, b, c, up_vector))
+                        process_triangle(a, b, c);
+                }
+                for (size_t i = 0; i < overhang_triangles.size(); i += 3)
+                    process_triangle(overhang_triangles[i], overhang_triangles[i + 1], overhang_triangles[i + 2]);
+                root_cube->children[child_idx] = child;
+            }
+        });
         {
             // Transform the octree to world coordinates to reduce computation when extracting infill lines.
             auto rot = transform_to_world().toRotationMatrix();
@@ -1512,7 +1579,7 @@ OctreePtr build_octree(
     return octree;
 }
 
-void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth)
+void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth, boost::object_pool<Cube> &cube_pool)
 {
     assert(current_cube);
     assert(depth > 0);
@@ -1523,27 +1590,15 @@ void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cub
     // const double r2_cube = Slic3r::sqr(0.5 * this->cubes_properties[depth].height + EPSILON);
 
     for (size_t i = 0; i < 8; ++ i) {
-        const Vec3d &child_center_dir = child_centers[i];
-        // Calculate a slightly expanded bounding box of a child cube to cope with triangles touching a cube wall and other numeric errors.
-        // We will rather densify the octree a bit more than necessary instead of missing a triangle.
-        BoundingBoxf3 bbox;
-        for (int k = 0; k < 3; ++ k) {
-            if (child_center_dir[k] == -1.) {
-                bbox.min[k] = current_bbox.min[k];
-                bbox.max[k] = current_cube->center[k] + EPSILON;
-            } else {
-                bbox.min[k] = current_cube->center[k] - EPSILON;
-                bbox.max[k] = current_bbox.max[k];
-            }
-        }
-        Vec3d child_center = current_cube->center + (child_center_dir * (this->cubes_properties[depth].edge_length / 2.));
+        const BoundingBoxf3 bbox = child_bbox(*current_cube, current_bbox, i);
+        Vec3d child_center = current_cube->center + (child_centers[i] * (this->cubes_properties[depth].edge_length / 2.));
         //if (dist2_to_triangle(a, b, c, child_center) < r2_cube) {
         // dist2_to_triangle and r2_cube are commented out too.
         if (triangle_AABB_intersects(a, b, c, bbox)) {
             if (! current_cube->children[i])
-                current_cube->children[i] = this->pool.construct(child_center);
+                current_cube->children[i] = cube_pool.construct(child_center);
             if (depth > 0)
-                this->insert_triangle(a, b, c, current_cube->children[i], bbox, depth);
+                this->insert_triangle(a, b, c, current_cube->children[i], bbox, depth, cube_pool);
         }
     }
 }
@@ -38,6 +38,7 @@ Eigen::Quaterniond              transform_to_world();
 // Inverse roation of the above.
 Eigen::Quaterniond              transform_to_octree();
 
+// The subtrees of the root cube are built in parallel.
 FillAdaptive::OctreePtr         build_octree(
     // Mesh is rotated to the coordinate system of the octree.
     const indexed_triangle_set  &triangle_mesh,
@@ -46,7 +47,10 @@ FillAdaptive::OctreePtr         build_octree(
     const std::vector<Vec3d>    &overhang_triangles, 
     coordf_t                     line_spacing, 
     // If true, octree is densified below internal overhangs only.
-    bool                         support_overhangs_only);
+    bool                         support_overhangs_only,
+    // Octree built before, returned instead of building a new one if it was built from the same mesh,
+    // overhang triangles and parameters, for example if only the infill settings not driving the octree changed.
+    FillAdaptive::OctreePtr    &&previous = FillAdaptive::OctreePtr());
 
 //
 // Some of the algorithms used by class FillAdaptive were inspired by
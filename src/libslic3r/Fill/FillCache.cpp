@@ -0,0 +1,168 @@
+#include "FillCache.hpp"
+#include "FillBase.hpp"
+
+#include <string_view>
+
+#include <boost/functional/hash.hpp>
+
+#include <ankerl/unordered_dense.h>
+
+namespace Slic3r {
+
+FillCache::Key::Key(InfillPattern pattern, const Fill &fill, const FillParams &params, const Surface &surface) :
+    pattern(pattern),
+    layer_id(fill.layer_id), z(fill.z), spacing(fill.spacing), overlap(fill.overlap), angle(fill.angle),
+    link_max_length(fill.link_max_length), bounding_box(fill.bounding_box),
+    density(params.density), anchor_length(params.anchor_length), anchor_length_max(params.anchor_length_max),
+    resolution(params.resolution), filter_out_gap_fill(params.filter_out_gap_fill), dont_adjust(params.dont_adjust),
+    monotonic(params.monotonic), dont_sort(params.dont_sort), can_reverse(params.can_reverse),
+    using_internal_flow(params.using_internal_flow), extrusion_role(params.extrusion_role), flow(params.flow),
+    surface_type(surface.surface_type), thickness_layers(surface.thickness_layers), bridge_angle(surface.bridge_angle),
+    expolygon(surface.expolygon)
+{}
+
+bool FillCache::Key::operator==(const Key &rhs) const
+{
+    return pattern == rhs.pattern && layer_id == rhs.layer_id && z == rhs.z && spacing == rhs.spacing && overlap == rhs.overlap &&
+           angle == rhs.angle && link_max_length == rhs.link_max_length &&
+           bounding_box.min == rhs.bounding_box.min && bounding_box.max == rhs.bounding_box.max &&
+           density == rhs.density && anchor_length == rhs.anchor_length && anchor_length_max == rhs.anchor_length_max &&
+           resolution == rhs.resolution && filter_out_gap_fill == rhs.filter_out_gap_fill && dont_adjust == rhs.dont_adjust &&
+           monotonic == rhs.monotonic && dont_sort == rhs.dont_sort && can_reverse == rhs.can_reverse &&
+           using_internal_flow == rhs.using_internal_flow && extrusion_role == rhs.extrusion_role && flow == rhs.flow &&
+           surface_type == rhs.surface_type && thickness_layers == rhs.thickness_layers && bridge_angle == rhs.bridge_angle &&
+           expolygon == rhs.expolygon;
+}
+
+uint64_t FillCache::Key::hash() const
+{
+    auto hash_points = [](const Points &points) -> uint64_t {
+        return ankerl::unordered_dense::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(Point)));
+    };
+    // The surface is hashed by its contour only, the other parameters mostly repeat between the surfaces of a layer.
+    size_t seed = 0;
+    boost::hash_combine(seed, int(pattern));
+    boost::hash_combine(seed, layer_id);
+    boost::hash_combine(seed, z);
+    boost::hash_combine(seed, spacing);
+    boost::hash_combine(seed, angle);
+    boost::hash_combine(seed, density);
+    boost::hash_combine(seed, int(surface_type));
+    boost::hash_combine(seed, hash_points(expolygon.contour.points));
+    boost::hash_combine(seed, expolygon.holes.size());
+    return uint64_t(seed);
+}
+
+bool FillCache::pattern_cacheable(InfillPattern pattern)
+{
+    switch (pattern) {
+    case ipRectilinear:
+    case ipAlignedRectilinear:
+    case ipMonotonic:
+    case ipLine:
+    case ipGrid:
+    case ipTriangles:
+    case ipStars:
+    case ipCubic:
+    case ipHoneycomb:
+    case ip3DHoneycomb:
+    case ipGyroid:
+    case ipHilbertCurve:
+    case ipArchimedeanChords:
+    case ipOctagramSpiral:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Approximate heap size of the extrusions.
+static size_t fills_memory(const ExtrusionEntityCollection &fills)
+{
+    size_t out = sizeof(ExtrusionEntityCollection) + fills.entities.capacity() * sizeof(ExtrusionEntity*);
+    for (const ExtrusionEntity *entity : fills.entities) {
+        if (const auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(entity))
+            out += fills_memory(*collection);
+        else {
+            Points points;
+            entity->collect_points(points);
+            // The size of a path object is a guess, there are paths, multi-paths and loops.
+            out += sizeof(ExtrusionPath) + points.size() * sizeof(Point);
+        }
+    }
+    return out;
+}
+
+static size_t key_memory(const FillCache::Key &key)
+{
+    size_t out = key.expolygon.contour.points.capacity() * sizeof(Point) + key.expolygon.holes.capacity() * sizeof(Polygon);
+    for (const Polygon &hole : key.expolygon.holes)
+        out += hole.points.capacity() * sizeof(Point);
+    return out;
+}
+
+void FillCache::set_max_memory(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_max_memory = bytes;
+    // Evict the least recently used extrusions exceeding the new limit.
+    while (m_memory > m_max_memory && ! m_entries.empty()) {
+        m_memory -= m_entries.back().memory;
+        m_map.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+void FillCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_map.clear();
+    m_memory = 0;
+}
+
+bool FillCache::get(const Key &key, ExtrusionEntitiesPtr &out)
+{
+    std::shared_ptr<const ExtrusionEntityCollection> fills;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+            return false;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        fills = it->second->fills;
+    }
+    // Clone outside of the lock, the extrusions are kept alive by the shared pointer even if evicted in the meantime.
+    out.reserve(out.size() + fills->entities.size());
+    for (const ExtrusionEntity *entity : fills->entities)
+        out.emplace_back(entity->clone());
+    return true;
+}
+
+void FillCache::put(const Key &key, const ExtrusionEntitiesPtr &out, size_t first)
+{
+    assert(first <= out.size());
+    auto fills = std::make_shared<ExtrusionEntityCollection>();
+    fills->entities.reserve(out.size() - first);
+    for (size_t i = first; i < out.size(); ++ i)
+        fills->entities.emplace_back(out[i]->clone());
+    // The key is stored twice, by the entry and by the map.
+    const size_t memory = fills_memory(*fills) + sizeof(Entry) + 2 * key_memory(key);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (memory > m_max_memory || m_map.find(key) != m_map.end())
+        // Never cache extrusions, which would evict all the other extrusions and still would not fit.
+        // The same surface may have been filled by another thread in the meantime.
+        return;
+    while (m_memory + memory > m_max_memory && ! m_entries.empty()) {
+        m_memory -= m_entries.back().memory;
+        m_map.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front({ key, std::move(fills), memory });
+    m_map.emplace(m_entries.front().key, m_entries.begin());
+    m_memory += memory;
+}
+
+} // namespace Slic3r
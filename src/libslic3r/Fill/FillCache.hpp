@@ -0,0 +1,121 @@
+#ifndef slic3r_FillCache_hpp_
+#define slic3r_FillCache_hpp_
+
+#include "../libslic3r.h"
+#include "../BoundingBox.hpp"
+#include "../ExPolygon.hpp"
+#include "../ExtrusionEntityCollection.hpp"
+#include "../Flow.hpp"
+#include "../PrintConfig.hpp"
+#include "../Surface.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Slic3r {
+
+class Fill;
+struct FillParams;
+
+// Cache of the infill extrusions generated by Fill::fill_surface_extrusion(), keyed by the infill pattern, by the state
+// of the filler, by the fill parameters and by the filled surface. The layers of a PrintObject are stored in the object
+// coordinate system, therefore copies of the same part added to a plate as separate objects, or similar parts sharing
+// some of their cross sections, fill the same surfaces at the same Z with the same object bounding box. Only the first
+// of these objects generates the infill, the others clone the cached extrusions.
+//
+// Only the patterns, which are fully defined by the key, are cached, see pattern_cacheable().
+// The extrusions are held in memory up to a memory limit, the least recently used extrusions are dropped first.
+// The cache is disabled by default.
+class FillCache
+{
+public:
+    struct Key
+    {
+        InfillPattern   pattern { ipRectilinear };
+        // State of the filler.
+        size_t          layer_id { 0 };
+        coordf_t        z { 0 };
+        coordf_t        spacing { 0 };
+        coordf_t        overlap { 0 };
+        float           angle { 0 };
+        coord_t         link_max_length { 0 };
+        BoundingBox     bounding_box;
+        // Fill parameters.
+        float           density { 0 };
+        float           anchor_length { 0 };
+        float           anchor_length_max { 0 };
+        double          resolution { 0 };
+        double          filter_out_gap_fill { 0 };
+        bool            dont_adjust { false };
+        bool            monotonic { false };
+        bool            dont_sort { false };
+        bool            can_reverse { false };
+        bool            using_internal_flow { false };
+        ExtrusionRole   extrusion_role { erNone };
+        Flow            flow;
+        // Filled surface.
+        SurfaceType     surface_type { stInternal };
+        unsigned short  thickness_layers { 1 };
+        double          bridge_angle { -1 };
+        ExPolygon       expolygon;
+
+        Key() = default;
+        Key(InfillPattern pattern, const Fill &fill, const FillParams &params, const Surface &surface);
+
+        bool     operator==(const Key &rhs) const;
+        uint64_t hash() const;
+    };
+
+    static FillCache& get_instance()
+    {
+        static FillCache instance;
+        return instance;
+    }
+
+    FillCache(FillCache const&) = delete;
+    void operator=(FillCache const&) = delete;
+
+    // Only the patterns not depending on anything else than the Key are cached. Adaptive, support cubic and lightning
+    // infills depend on the octrees and generators of the object, concentric infills on the print configuration,
+    // zig zag infills on the symmetry axis and on the lock regions.
+    static bool pattern_cacheable(InfillPattern pattern);
+
+    // Maximum size of the extrusions held in memory, 0 disables the cache.
+    void        set_max_memory(size_t bytes);
+    size_t      max_memory() const { std::lock_guard<std::mutex> lock(m_mutex); return m_max_memory; }
+    // Size of the extrusions held in memory.
+    size_t      memory() const { std::lock_guard<std::mutex> lock(m_mutex); return m_memory; }
+    bool        enabled() const { std::lock_guard<std::mutex> lock(m_mutex); return m_max_memory > 0; }
+
+    // Returns true and appends clones of the cached extrusions to out if extrusions for the key are cached.
+    bool        get(const Key &key, ExtrusionEntitiesPtr &out);
+    // Caches clones of the extrusions out[first, end).
+    void        put(const Key &key, const ExtrusionEntitiesPtr &out, size_t first);
+    void        clear();
+
+private:
+    FillCache() = default;
+
+    struct KeyHash { size_t operator()(const Key &key) const { return size_t(key.hash()); } };
+    struct Entry
+    {
+        Key                                              key;
+        std::shared_ptr<const ExtrusionEntityCollection> fills;
+        size_t                                           memory;
+    };
+    using Entries = std::list<Entry>;
+
+    mutable std::mutex                                        m_mutex;
+    size_t                                                    m_max_memory { 0 };
+    size_t                                                    m_memory { 0 };
+    // Most recently used first.
+    Entries                                                   m_entries;
+    std::unordered_map<Key, Entries::iterator, KeyHash>       m_map;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_FillCache_hpp_
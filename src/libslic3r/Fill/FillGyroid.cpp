@@ -4,6 +4,10 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "FillGyroid.hpp"
 
@@ -48,12 +52,20 @@ static inline Polyline make_wave(
         points.emplace_back(Vec2d(width, f(width, z_sin, z_cos, vertical, flip)));
     }
 
-    // and construct the final polyline to return:
-    Polyline polyline;
-    polyline.points.reserve(points.size());
     for (auto& point : points) {
         point(1) += offset;
         point(1) = std::clamp(double(point.y()), 0., height);
+    }
+
+    // and construct the final polyline to return.
+    // The waves at the borders of the bounding box are clamped to the border, drop the inner points of the clamped
+    // straight runs, they are just passed to Clipper.
+    Polyline polyline;
+    polyline.points.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++ i) {
+        if (i > 0 && i + 1 < points.size() && points[i - 1].y() == points[i].y() && points[i].y() == points[i + 1].y())
+            continue;
+        Vec2d point = points[i];
         if (vertical)
             std::swap(point(0), point(1));
         polyline.points.emplace_back((point * scaleFactor).cast<coord_t>());
@@ -145,6 +157,105 @@ static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double
     return result;
 }
 
+// Cache of the unclipped gyroid waves. The waves depend on the Z of the layer, on the density, on the line spacing
+// and on the size of the bounding box aligned to the gyroid grid. They do not depend on the position of the bounding box
+// nor on the infill angle, as the expolygon is rotated and shifted to the pattern, not the other way around.
+// Regions, islands and objects of the same size printed at the same Z with the same infill then share the waves.
+// The least recently used waves are dropped once the cached waves exceed max_points.
+class GyroidWavesCache
+{
+public:
+    struct Key
+    {
+        double gridZ;
+        double density_adjusted;
+        double line_spacing;
+        double width;
+        double height;
+
+        bool operator==(const Key &rhs) const {
+            return gridZ == rhs.gridZ && density_adjusted == rhs.density_adjusted && line_spacing == rhs.line_spacing &&
+                   width == rhs.width && height == rhs.height;
+        }
+    };
+
+    static GyroidWavesCache& get_instance()
+    {
+        static GyroidWavesCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const Polylines> get(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+            return {};
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->waves;
+    }
+
+    void put(const Key &key, std::shared_ptr<const Polylines> waves)
+    {
+        size_t num_points = 0;
+        for (const Polyline &pl : *waves)
+            num_points += pl.size();
+        if (num_points > max_points)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_map.find(key) != m_map.end())
+            // Generated by another thread in the meantime.
+            return;
+        m_lru.push_front({ key, std::move(waves), num_points });
+        m_map.emplace(key, m_lru.begin());
+        m_points += num_points;
+        while (m_points > max_points) {
+            m_points -= m_lru.back().num_points;
+            m_map.erase(m_lru.back().key);
+            m_lru.pop_back();
+        }
+    }
+
+private:
+    GyroidWavesCache() = default;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const {
+            size_t seed = 0;
+            for (double v : { key.gridZ, key.density_adjusted, key.line_spacing, key.width, key.height })
+                seed ^= std::hash<double>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+    struct Entry
+    {
+        Key                              key;
+        std::shared_ptr<const Polylines> waves;
+        size_t                           num_points;
+    };
+
+    // Roughly 32MB of points.
+    static constexpr size_t max_points = 4 * 1024 * 1024;
+
+    std::mutex                                                    m_mutex;
+    // Most recently used first.
+    std::list<Entry>                                              m_lru;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_map;
+    size_t                                                        m_points { 0 };
+};
+
+static std::shared_ptr<const Polylines> gyroid_waves(double gridZ, double density_adjusted, double line_spacing, double width, double height)
+{
+    GyroidWavesCache::Key key { gridZ, density_adjusted, line_spacing, width, height };
+    std::shared_ptr<const Polylines> waves = GyroidWavesCache::get_instance().get(key);
+    if (! waves) {
+        waves = std::make_shared<const Polylines>(make_gyroid_waves(gridZ, density_adjusted, line_spacing, width, height));
+        GyroidWavesCache::get_instance().put(key, waves);
+    }
+    return waves;
+}
+
 // FIXME: needed to fix build on Mac on buildserver
 constexpr double FillGyroid::PatternTolerance;
 
@@ -168,20 +279,21 @@ void FillGyroid::_fill_surface_single(
     // align bounding box to a multiple of our grid module
     bb.merge(align_to_grid(bb.min, Point(2*M_PI*distance, 2*M_PI*distance)));
 
-    // generate pattern
-    Polylines polylines = make_gyroid_waves(
+    // generate pattern, shared with the other surfaces of the same size at the same Z
+    std::shared_ptr<const Polylines> waves = gyroid_waves(
         scale_(this->z),
         density_adjusted,
         this->spacing,
         ceil(bb.size()(0) / distance) + 1.,
         ceil(bb.size()(1) / distance) + 1.);
 
-	// shift the polyline to the grid origin
+	// clip the waves with the expolygon shifted to the grid origin, then shift the clipped polylines back
+	expolygon.translate(Point(- bb.min.x(), - bb.min.y()));
+	Polylines polylines = intersection_pl(*waves, expolygon);
+	expolygon.translate(bb.min);
 	for (Polyline &pl : polylines)
 		pl.translate(bb.min);
 
-	polylines = intersection_pl(polylines, expolygon);
-
     if (! polylines.empty()) {
 		// Remove very small bits, but be careful to not remove infill lines connecting thin walls!
         // The infill perimeter lines should be separated by around a single infill line width.
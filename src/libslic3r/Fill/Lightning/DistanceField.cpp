@@ -95,6 +95,41 @@ DistanceField::DistanceField(const coord_t& radius, const Polygons& current_outl
 #endif
 }
 
+DistanceField::DistanceField(coord_t cell_size, coord_t radius, const BoundingBox &unsupported_points_bbox, std::vector<UnsupportedCell> &&unsupported_points) :
+    m_cell_size(cell_size),
+    m_supporting_radius(radius),
+    m_supporting_radius2(Slic3r::sqr(int64_t(radius))),
+    m_unsupported_points(std::move(unsupported_points)),
+    m_unsupported_points_erased(m_unsupported_points.size(), false),
+    m_unsupported_points_bbox(unsupported_points_bbox)
+{
+    m_unsupported_points_grid.initialize(m_unsupported_points, [&self = std::as_const(*this)](const Point &p) -> Point { return self.to_grid_point(p); });
+    assert(m_unsupported_points.size() == m_unsupported_points_grid.size());
+}
+
+std::vector<DistanceField> DistanceField::split(size_t num_islands, const std::function<size_t(const Point &)> &island_of_point, std::vector<std::vector<size_t>> *island_cells) const
+{
+    std::vector<std::vector<UnsupportedCell>> island_points(num_islands);
+    if (island_cells)
+        island_cells->assign(num_islands, {});
+    for (size_t point_idx = 0; point_idx < m_unsupported_points.size(); ++point_idx)
+        if (! m_unsupported_points_erased[point_idx]) {
+            const UnsupportedCell &cell       = m_unsupported_points[point_idx];
+            const size_t           island_idx = island_of_point(cell.loc);
+            assert(island_idx < island_points.size());
+            island_points[island_idx].emplace_back(cell);
+            if (island_cells)
+                (*island_cells)[island_idx].emplace_back(point_idx);
+        }
+
+    // The grid is anchored at the same origin, because update() tests the grid locations, not the unsupported points.
+    std::vector<DistanceField> out;
+    out.reserve(num_islands);
+    for (size_t island_idx = 0; island_idx < num_islands; ++island_idx)
+        out.emplace_back(DistanceField(m_cell_size, m_supporting_radius, m_unsupported_points_bbox, std::move(island_points[island_idx])));
+    return out;
+}
+
 void DistanceField::update(const Point& to_node, const Point& added_leaf)
 {
     Vec2d       v  = (added_leaf - to_node).cast<double>();
@@ -8,6 +8,9 @@
 #include "../../Point.hpp"
 #include "../../Polygon.hpp"
 
+#include <functional>
+#include <vector>
+
 //#define LIGHTNING_DISTANCE_FIELD_DEBUG_OUTPUT
 
 namespace Slic3r::FillLightning
@@ -33,6 +36,21 @@ public:
      * layer.
      */
     DistanceField(const coord_t& radius, const Polygons& current_outline, const BoundingBox& current_outlines_bbox, const Polygons& current_overhang);
+
+    /*!
+     * Split the field into fields of separate islands of the infill area, so
+     * that the trees of the islands may be generated independently.
+     * The unsupported points keep their order and the fields keep the grid of
+     * this field, thus supporting the islands one after another yields the
+     * same trees as supporting the whole field, as long as the trees of one
+     * island do not reach into another island.
+     * \param num_islands Number of the islands.
+     * \param island_of_point Returns the index of the island an unsupported
+     * point belongs to.
+     * \param[out] island_cells If set, receives for each island the indices of
+     * the cells of this field the cells of the island field were taken from.
+     */
+    std::vector<DistanceField> split(size_t num_islands, const std::function<size_t(const Point &)> &island_of_point, std::vector<std::vector<size_t>> *island_cells = nullptr) const;
     
     /*!
      * Gets the next unsupported location to be supported by a new branch.
@@ -91,6 +109,11 @@ protected:
         coord_t dist_to_boundary;
     };
 
+    /*!
+     * Construct a field of already sampled and sorted unsupported points.
+     */
+    DistanceField(coord_t cell_size, coord_t radius, const BoundingBox &unsupported_points_bbox, std::vector<UnsupportedCell> &&unsupported_points);
+
     /*!
      * Cells which still need to be supported at some point.
      */
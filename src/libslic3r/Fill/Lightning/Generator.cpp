@@ -2,6 +2,7 @@
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
 #include "Generator.hpp"
+#include "DistanceField.hpp"
 #include "TreeNode.hpp"
 
 #include "../../ClipperUtils.hpp"
@@ -10,6 +11,12 @@
 
 #include "ExPolygon.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
 /* Possible future tasks/optimizations,etc.:
  * - Improve connecting heuristic to favor connecting to shorter trees
  * - Change which node of a tree is the root when that would be better in reconnectRoots.
@@ -134,22 +141,32 @@ void Generator::generateInitialInternalOverhangs(const PrintObject &print_object
 {
     m_overhang_per_layer.resize(print_object.layers().size());
 
-    Polygons infill_area_above;
-    //Iterate from top to bottom, to subtract the overhang areas above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
-    for (int layer_nr = int(print_object.layers().size()) - 1; layer_nr >= 0; --layer_nr) {
-        throw_on_cancel_callback();
-        Polygons infill_area_here;
-        for (const LayerRegion* layerm : print_object.get_layer(layer_nr)->regions())
-            for (const Surface& surface : layerm->fill_surfaces.surfaces)
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_area_here, to_polygons(surface.expolygon));
-
-        //Remove the part of the infill area that is already supported by the walls.
-        Polygons overhang = diff(offset(infill_area_here, -float(m_wall_supporting_radius)), infill_area_above);
+    std::vector<Polygons> infill_areas = collectInfillAreas(print_object, throw_on_cancel_callback);
+    //Subtract the overhang areas above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, infill_areas.size()), [this, &infill_areas, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_nr = range.begin(); layer_nr < range.end(); ++ layer_nr) {
+            throw_on_cancel_callback();
+            //Remove the part of the infill area that is already supported by the walls.
+            m_overhang_per_layer[layer_nr] = layer_nr + 1 < infill_areas.size() ?
+                diff(offset(infill_areas[layer_nr], -float(m_wall_supporting_radius)), infill_areas[layer_nr + 1]) :
+                offset(infill_areas[layer_nr], -float(m_wall_supporting_radius));
+        }
+    });
+}
 
-        m_overhang_per_layer[layer_nr] = overhang;
-        infill_area_above = std::move(infill_area_here);
-    }
+std::vector<Polygons> Generator::collectInfillAreas(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+{
+    std::vector<Polygons> infill_areas(print_object.layers().size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, infill_areas.size()), [&print_object, &infill_areas, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_nr = range.begin(); layer_nr < range.end(); ++ layer_nr) {
+            throw_on_cancel_callback();
+            for (const LayerRegion *layerm : print_object.get_layer(int(layer_nr))->regions())
+                for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                    if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
+                        append(infill_areas[layer_nr], to_polygons(surface.expolygon));
+        }
+    });
+    return infill_areas;
 }
 
 const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
@@ -158,107 +175,294 @@ const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
     return m_lightning_layers[layer_id];
 }
 
-void Generator::generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+// Infill island of a layer with the distance field of the overhang above it.
+// The trees never cross the outlines, thus the trees of the islands of a layer are generated independently.
+// Only a tree close to another island supports the overhang above the other island or shares the cells of the tree node
+// locator with it, therefore such islands are grouped into a single Island.
+struct Island
 {
-    m_lightning_layers.resize(print_object.layers().size());
-    bboxs.resize(print_object.layers().size());
-    std::vector<Polygons> infill_outlines(print_object.layers().size(), Polygons());
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(print_object.layers().size()) - 1; layer_id >= 0; layer_id--) {
-        throw_on_cancel_callback();
-        for (const LayerRegion *layerm : print_object.get_layer(layer_id)->regions())
-            for (const Surface &surface : layerm->fill_surfaces.surfaces)
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_outlines[layer_id], to_polygons(surface.expolygon));
+    ExPolygons                     area;
+    Polygons                       outlines;
+    BoundingBox                    bbox;
+    std::unique_ptr<DistanceField> distance_field;
+    // Indices of the cells of distance_field in the distance field of the whole layer, if the layer was split into islands.
+    std::vector<size_t>            cells;
+};
+
+// Locates the islands of a layer by a grid of the island bounding boxes.
+class IslandLocator
+{
+public:
+    explicit IslandLocator(const std::vector<Island> &islands) : m_islands(islands)
+    {
+        if (islands.size() < 2)
+            return;
+        for (const Island &island : islands)
+            m_bbox.merge(island.bbox);
+        // About a single island per cell if the islands are spread evenly.
+        const Vec2d size = m_bbox.size().cast<double>();
+        m_cell_size = std::max(locator_cell_size, coord_t(std::sqrt(size.x() * size.y() / double(islands.size()))));
+        m_cols      = size_t(m_bbox.size().x() / m_cell_size) + 1;
+        m_rows      = size_t(m_bbox.size().y() / m_cell_size) + 1;
+        m_cells.assign(m_cols * m_rows, {});
+        for (size_t island_idx = 0; island_idx < islands.size(); ++ island_idx) {
+            const BoundingBox &bbox = islands[island_idx].bbox;
+            const Point        min  = (bbox.min - m_bbox.min) / m_cell_size;
+            const Point        max  = (bbox.max - m_bbox.min) / m_cell_size;
+            for (coord_t row = min.y(); row <= max.y(); ++ row)
+                for (coord_t col = min.x(); col <= max.x(); ++ col)
+                    m_cells[size_t(row) * m_cols + size_t(col)].emplace_back(island_idx);
+        }
     }
 
-    // For various operations its beneficial to quickly locate nearby features on the polygon:
-    const size_t top_layer_id = print_object.layers().size() - 1;
-    EdgeGrid::Grid outlines_locator(get_extents(infill_outlines[top_layer_id]).inflated(SCALED_EPSILON));
-    outlines_locator.create(infill_outlines[top_layer_id], locator_cell_size);
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(top_layer_id); layer_id >= 0; layer_id--) {
-        throw_on_cancel_callback();
-        Layer             &current_lightning_layer = m_lightning_layers[layer_id];
-        const Polygons    &current_outlines        = infill_outlines[layer_id];
-        const BoundingBox &current_outlines_bbox   = get_extents(current_outlines);
-
-        bboxs[layer_id] = get_extents(current_outlines);
-
-        // register all trees propagated from the previous layer as to-be-reconnected
-        std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
-
-        current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
-        current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
-
-        // Initialize trees for next lower layer from the current one.
-        if (layer_id == 0)
-            return;
+    // Index of the island containing the point, or of the island with the closest bounding box.
+    // The first of the islands is returned if several of them qualify, as if the islands were searched in their order.
+    size_t island_index(const Point &pt) const
+    {
+        if (m_islands.size() < 2)
+            return 0;
+        if (m_bbox.contains(pt)) {
+            // All the islands with a bounding box containing the point are registered in the cell of the point, in their order.
+            const Point cell     = (pt - m_bbox.min) / m_cell_size;
+            size_t      bbox_idx = std::numeric_limits<size_t>::max();
+            for (size_t island_idx : m_cells[size_t(cell.y()) * m_cols + size_t(cell.x())])
+                if (const Island &island = m_islands[island_idx]; island.bbox.contains(pt)) {
+                    if (std::any_of(island.area.begin(), island.area.end(), [&pt](const ExPolygon &expoly) { return expoly.contains(pt); }))
+                        return island_idx;
+                    bbox_idx = std::min(bbox_idx, island_idx);
+                }
+            if (bbox_idx != std::numeric_limits<size_t>::max())
+                return bbox_idx;
+        }
+        // The point is outside of all the bounding boxes, which is rare as the points are sampled inside the islands.
+        size_t idx_min = 0;
+        double d2_min  = std::numeric_limits<double>::max();
+        const Vec2d p  = pt.cast<double>();
+        for (size_t island_idx = 0; island_idx < m_islands.size(); ++ island_idx) {
+            const BoundingBox &bbox = m_islands[island_idx].bbox;
+            if (double d2 = (p - p.cwiseMax(bbox.min.cast<double>()).cwiseMin(bbox.max.cast<double>())).squaredNorm(); d2 < d2_min) {
+                d2_min  = d2;
+                idx_min = island_idx;
+            }
+        }
+        return idx_min;
+    }
 
-        const Polygons &below_outlines      = infill_outlines[layer_id - 1];
-        BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
-        if (const BoundingBox &outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
-            below_outlines_bbox.merge(outlines_locator_bbox);
+private:
+    const std::vector<Island>        &m_islands;
+    BoundingBox                       m_bbox;
+    coord_t                           m_cell_size { 1 };
+    size_t                            m_cols { 0 };
+    size_t                            m_rows { 0 };
+    std::vector<std::vector<size_t>>  m_cells;
+};
+
+// Split the infill outlines of a layer into islands and calculate the distance fields of the overhang above the islands.
+static std::vector<Island> make_islands(const Polygons &outlines, const Polygons &overhang, const coord_t supporting_radius)
+{
+    std::vector<Island> islands;
+    ExPolygons          expolys = union_ex(outlines);
+    if (expolys.empty())
+        return islands;
+    if (expolys.size() == 1) {
+        islands.emplace_back();
+        islands.front().area = std::move(expolys);
+    } else {
+        // Islands closer than the supporting radius or than a diagonal of a cell of the tree node locator are grouped.
+        const coord_t            island_distance = std::max(supporting_radius, 2 * locator_cell_size);
+        const ExPolygons         groups          = union_ex(offset_ex(expolys, float(island_distance / 2)));
+        std::vector<BoundingBox> group_bboxes;
+        group_bboxes.reserve(groups.size());
+        for (const ExPolygon &group : groups)
+            group_bboxes.emplace_back(get_extents(group.contour));
+        islands.resize(groups.size());
+        for (ExPolygon &expoly : expolys) {
+            const Point &pt        = expoly.contour.points.front();
+            size_t       group_idx = 0;
+            while (group_idx + 1 < groups.size() && ! (group_bboxes[group_idx].contains(pt) && groups[group_idx].contains(pt)))
+                ++ group_idx;
+            islands[group_idx].area.emplace_back(std::move(expoly));
+        }
+        islands.erase(std::remove_if(islands.begin(), islands.end(), [](const Island &island) { return island.area.empty(); }), islands.end());
+    }
+    for (Island &island : islands) {
+        island.outlines = to_polygons(island.area);
+        island.bbox     = get_extents(island.area);
+    }
 
-        if (!current_lightning_layer.tree_roots.empty())
-            below_outlines_bbox.merge(get_extents(current_lightning_layer.tree_roots).inflated(SCALED_EPSILON));
+    // Sample the overhang of the whole layer and sort the unsupported points as if the layer was a single island,
+    // then split the distance field by the islands keeping the order of the unsupported points.
+    auto distance_field = std::make_unique<DistanceField>(supporting_radius, outlines, get_extents(outlines), overhang);
+    if (islands.size() == 1) {
+        islands.front().distance_field = std::move(distance_field);
+        return islands;
+    }
+    std::vector<std::vector<size_t>> island_cells;
+    std::vector<DistanceField> island_fields = distance_field->split(islands.size(), [locator = IslandLocator(islands)](const Point &pt) { return locator.island_index(pt); }, &island_cells);
+    for (size_t island_idx = 0; island_idx < islands.size(); ++ island_idx) {
+        islands[island_idx].distance_field = std::make_unique<DistanceField>(std::move(island_fields[island_idx]));
+        islands[island_idx].cells          = std::move(island_cells[island_idx]);
+    }
+    return islands;
+}
 
-        outlines_locator.set_bbox(below_outlines_bbox);
-        outlines_locator.create(below_outlines, locator_cell_size);
+// Trees of an island grown by Layer::generateNewTrees() and Layer::reconnectRoots().
+struct IslandTrees
+{
+    Layer                 layer;
+    // Trees propagated from the layer above to this island, in the order of the layer.
+    std::vector<NodeSPtr> old_roots;
+    // New trees in the order they were created and the cells of the distance field of the layer they were created for.
+    std::vector<NodeSPtr> new_roots;
+    std::vector<size_t>   new_root_cells;
+    // Roots replacing old_roots, see Layer::reconnectRoots().
+    std::vector<NodeSPtr> reconnected_roots;
+};
+
+// Order the trees of the islands as if the layer was a single island: Layer::generateNewTrees() appends the new trees
+// in the order of the unsupported cells of the layer, Layer::reconnectRoots() replaces the old roots in place
+// or removes them by moving the last root into their place. The trees of the next layer are propagated in this order.
+static std::vector<NodeSPtr> merge_island_trees(const std::vector<NodeSPtr> &old_roots, const std::vector<size_t> &old_root_islands,
+    const std::vector<Island> &islands, const std::vector<IslandTrees> &island_trees)
+{
+    std::vector<NodeSPtr> roots = old_roots;
+    {
+        std::vector<std::pair<size_t, const NodeSPtr*>> new_roots;
+        for (size_t island_idx = 0; island_idx < islands.size(); ++ island_idx) {
+            const IslandTrees &trees = island_trees[island_idx];
+            for (size_t i = 0; i < trees.new_roots.size(); ++ i)
+                new_roots.emplace_back(islands[island_idx].cells[trees.new_root_cells[i]], &trees.new_roots[i]);
+        }
+        std::sort(new_roots.begin(), new_roots.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+        for (const auto &new_root : new_roots)
+            roots.emplace_back(*new_root.second);
+    }
 
-        std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
-        for (auto& tree : current_lightning_layer.tree_roots)
-            tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, locator_cell_size / 2);
+    std::unordered_map<const Node*, size_t> root_position;
+    for (size_t i = 0; i < roots.size(); ++ i)
+        root_position.emplace(roots[i].get(), i);
+    std::vector<size_t> num_reconnected(islands.size(), 0);
+    for (size_t i = 0; i < old_roots.size(); ++ i) {
+        const NodeSPtr &reconnected = island_trees[old_root_islands[i]].reconnected_roots[num_reconnected[old_root_islands[i]] ++];
+        auto            it          = root_position.find(old_roots[i].get());
+        assert(it != root_position.end());
+        const size_t    pos         = it->second;
+        root_position.erase(it);
+        if (reconnected) {
+            roots[pos] = reconnected;
+            root_position[reconnected.get()] = pos;
+        } else {
+            if (pos + 1 < roots.size()) {
+                roots[pos] = std::move(roots.back());
+                root_position[roots[pos].get()] = pos;
+            }
+            roots.pop_back();
+        }
     }
+    return roots;
+}
+
+void Generator::generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+{
+    generateTrees(collectInfillAreas(print_object, throw_on_cancel_callback), throw_on_cancel_callback);
 }
 
 void Generator::generateTreesforSupport(std::vector<Polygons>& contours, const std::function<void()> &throw_on_cancel_callback)
 {
     if (contours.empty()) return;
 
-    m_lightning_layers.resize(contours.size());
-    bboxs.resize(contours.size());
+    generateTrees(contours, throw_on_cancel_callback);
+}
+
+void Generator::generateTrees(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback)
+{
+    m_lightning_layers.resize(infill_outlines.size());
+    bboxs.resize(infill_outlines.size());
+    if (infill_outlines.empty())
+        return;
 
     // For various operations its beneficial to quickly locate nearby features on the polygon:
-    const size_t top_layer_id = contours.size() - 1;
-    EdgeGrid::Grid outlines_locator(get_extents(contours[top_layer_id]).inflated(SCALED_EPSILON));
-    outlines_locator.create(contours[top_layer_id], locator_cell_size);
+    const size_t top_layer_id = infill_outlines.size() - 1;
+    EdgeGrid::Grid outlines_locator(get_extents(infill_outlines[top_layer_id]).inflated(SCALED_EPSILON));
+    outlines_locator.create(infill_outlines[top_layer_id], locator_cell_size);
+
+    // The islands of the layer below are prepared in parallel with the trees of the current layer.
+    std::vector<Island> islands = make_islands(infill_outlines[top_layer_id], m_overhang_per_layer[top_layer_id], m_supporting_radius);
+    std::vector<Island> islands_below;
 
     // For-each layer from top to bottom:
     for (int layer_id = int(top_layer_id); layer_id >= 0; layer_id--) {
-		throw_on_cancel_callback();
-        Layer& current_lightning_layer = m_lightning_layers[layer_id];
-        const Polygons& current_outlines = contours[layer_id];
-        const BoundingBox& current_outlines_bbox = get_extents(current_outlines);
-
-        bboxs[layer_id] = get_extents(current_outlines);
-
-        // register all trees propagated from the previous layer as to-be-reconnected
-        std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
-
-        current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
-        current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
-
-        // Initialize trees for next lower layer from the current one.
-        if (layer_id == 0)
-            return;
-
-        const Polygons& below_outlines = contours[layer_id - 1];
-        BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
-        if (const BoundingBox& outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
-            below_outlines_bbox.merge(outlines_locator_bbox);
-
-        if (!current_lightning_layer.tree_roots.empty())
-            below_outlines_bbox.merge(get_extents(current_lightning_layer.tree_roots).inflated(SCALED_EPSILON));
-
-        outlines_locator.set_bbox(below_outlines_bbox);
-        outlines_locator.create(below_outlines, locator_cell_size);
-
-        std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
-        for (auto& tree : current_lightning_layer.tree_roots)
-            tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, locator_cell_size / 2);
+        throw_on_cancel_callback();
+        tbb::task_group task_group;
+        if (layer_id > 0)
+            task_group.run([this, &infill_outlines, &islands_below, layer_id]() {
+                islands_below = make_islands(infill_outlines[layer_id - 1], m_overhang_per_layer[layer_id - 1], m_supporting_radius);
+            });
+        try {
+            Layer             &current_lightning_layer = m_lightning_layers[layer_id];
+            const Polygons    &current_outlines        = infill_outlines[layer_id];
+            const BoundingBox &current_outlines_bbox   = get_extents(current_outlines);
+
+            bboxs[layer_id] = current_outlines_bbox;
+
+            if (islands.empty()) {
+                // register all trees propagated from the previous layer as to-be-reconnected
+                std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
+
+                current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
+                current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
+            } else {
+                // Distribute the trees propagated from the previous layer to the islands and grow the trees of each island in parallel.
+                std::vector<IslandTrees> island_trees(islands.size());
+                std::vector<size_t>      old_root_islands;
+                old_root_islands.reserve(current_lightning_layer.tree_roots.size());
+                const IslandLocator      island_locator(islands);
+                for (const NodeSPtr &tree : current_lightning_layer.tree_roots) {
+                    old_root_islands.emplace_back(island_locator.island_index(tree->getLocation()));
+                    island_trees[old_root_islands.back()].old_roots.emplace_back(tree);
+                }
+                // The trees of the islands are located in the grid of the whole layer, as if the layer was a single island.
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, islands.size(), 1), [this, &islands, &island_trees, &current_outlines_bbox, &outlines_locator, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+                    for (size_t island_idx = range.begin(); island_idx < range.end(); ++ island_idx) {
+                        const Island &island = islands[island_idx];
+                        IslandTrees  &trees  = island_trees[island_idx];
+                        // register all trees propagated from the previous layer as to-be-reconnected
+                        trees.layer.tree_roots = trees.old_roots;
+                        trees.layer.generateNewTrees(*island.distance_field, island.outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback, &trees.new_root_cells);
+                        trees.new_roots.assign(trees.layer.tree_roots.begin() + trees.old_roots.size(), trees.layer.tree_roots.end());
+                        trees.layer.reconnectRoots(trees.old_roots, island.outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, &trees.reconnected_roots);
+                    }
+                });
+                current_lightning_layer.tree_roots = islands.size() == 1 ?
+                    std::move(island_trees.front().layer.tree_roots) :
+                    merge_island_trees(current_lightning_layer.tree_roots, old_root_islands, islands, island_trees);
+            }
+
+            // Initialize trees for next lower layer from the current one.
+            if (layer_id > 0) {
+                const Polygons &below_outlines      = infill_outlines[layer_id - 1];
+                BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
+                if (const BoundingBox &outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
+                    below_outlines_bbox.merge(outlines_locator_bbox);
+
+                if (!current_lightning_layer.tree_roots.empty())
+                    below_outlines_bbox.merge(get_extents(current_lightning_layer.tree_roots).inflated(SCALED_EPSILON));
+
+                outlines_locator.set_bbox(below_outlines_bbox);
+                outlines_locator.create(below_outlines, locator_cell_size);
+
+                std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
+                for (auto& tree : current_lightning_layer.tree_roots)
+                    tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, locator_cell_size / 2);
+            }
+        } catch (...) {
+            task_group.cancel();
+            task_group.wait();
+            throw;
+        }
+        task_group.wait();
+        islands = std::move(islands_below);
+        islands_below.clear();
     }
 }
 
@@ -74,12 +74,28 @@ protected:
      */
     void generateInitialInternalOverhangs(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
 
+    /*!
+     * Collect the sparse infill areas of all layers.
+     */
+    static std::vector<Polygons> collectInfillAreas(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+
     /*!
      * Calculate the tree structure of all layers.
      */
     void generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
     void generateTreesforSupport(std::vector<Polygons>& contours, const std::function<void()> &throw_on_cancel_callback);
 
+    /*!
+     * Calculate the tree structure of all layers filling the infill outlines.
+     *
+     * The layers are processed from the top to the bottom, as the trees of a
+     * layer are propagated from the layer above. The islands of a layer are
+     * processed in parallel, the distance fields of the layer below are
+     * calculated in parallel with the trees of the current layer. The trees
+     * and their order are the same as if each layer was processed as a whole.
+     */
+    void generateTrees(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback);
+
     float m_infill_extrusion_width;
 
     /*!
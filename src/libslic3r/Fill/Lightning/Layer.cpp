@@ -54,7 +54,21 @@ void Layer::generateNewTrees
 {
     DistanceField distance_field(supporting_radius, current_outlines, current_outlines_bbox, current_overhang);
     throw_on_cancel_callback();
+    this->generateNewTrees(distance_field, current_outlines, current_outlines_bbox, outlines_locator, supporting_radius, wall_supporting_radius, throw_on_cancel_callback);
+}
 
+void Layer::generateNewTrees
+(
+    DistanceField& distance_field,
+    const Polygons& current_outlines,
+    const BoundingBox& current_outlines_bbox,
+    const EdgeGrid::Grid& outlines_locator,
+    const coord_t supporting_radius,
+    const coord_t wall_supporting_radius,
+    const std::function<void()> &throw_on_cancel_callback,
+    std::vector<size_t> *new_tree_cells
+)
+{
     SparseNodeGrid tree_node_locator;
     fillLocator(tree_node_locator, current_outlines_bbox);
 
@@ -69,7 +83,8 @@ void Layer::generateNewTrees
 
         NodeSPtr new_parent;
         NodeSPtr new_child;
-        this->attach(unsupported_location, grounding_loc, new_child, new_parent);
+        if (this->attach(unsupported_location, grounding_loc, new_child, new_parent) && new_tree_cells)
+            new_tree_cells->emplace_back(unsupported_cell_idx);
         tree_node_locator.insert(std::make_pair(to_grid_point(new_child->getLocation(), current_outlines_bbox), new_child));
         if (new_parent)
             tree_node_locator.insert(std::make_pair(to_grid_point(new_parent->getLocation(), current_outlines_bbox), new_parent));
@@ -224,7 +239,8 @@ void Layer::reconnectRoots
     const BoundingBox& current_outlines_bbox,
     const EdgeGrid::Grid& outline_locator,
     const coord_t supporting_radius,
-    const coord_t wall_supporting_radius
+    const coord_t wall_supporting_radius,
+    std::vector<NodeSPtr> *reconnected_tree_roots
 )
 {
     constexpr coord_t tree_connecting_ignore_offset = 100;
@@ -233,9 +249,13 @@ void Layer::reconnectRoots
     fillLocator(tree_node_locator, current_outlines_bbox);
 
     const coord_t within_max_dist = outline_locator.resolution() * 2;
+    if (reconnected_tree_roots)
+        reconnected_tree_roots->clear();
     for (const auto &root_ptr : to_be_reconnected_tree_roots)
     {
         auto old_root_it = std::find(tree_roots.begin(), tree_roots.end(), root_ptr);
+        if (reconnected_tree_roots)
+            reconnected_tree_roots->emplace_back(root_ptr);
 
         if (root_ptr->getLastGroundingLocation())
         {
@@ -251,6 +271,8 @@ void Layer::reconnectRoots
 
                     tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
 
+                    if (reconnected_tree_roots)
+                        reconnected_tree_roots->back() = new_root;
                     *old_root_it = std::move(new_root); // replace old root with new root
                     continue;
                 }
@@ -282,6 +304,8 @@ void Layer::reconnectRoots
             new_root->addChild(attach_ptr);
             tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
 
+            if (reconnected_tree_roots)
+                reconnected_tree_roots->back() = new_root;
             *old_root_it = std::move(new_root); // replace old root with new root
         }
         else
@@ -297,6 +321,8 @@ void Layer::reconnectRoots
             ground.tree_node->addChild(attach_ptr);
 
             // remove old root
+            if (reconnected_tree_roots)
+                reconnected_tree_roots->back() = nullptr;
             *old_root_it = std::move(tree_roots.back());
             tree_roots.pop_back();
         }
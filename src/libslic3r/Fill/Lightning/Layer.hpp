@@ -17,6 +17,7 @@ namespace Slic3r::FillLightning
 {
 
 class Node;
+class DistanceField;
 using NodeSPtr = std::shared_ptr<Node>;
 using SparseNodeGrid = std::unordered_multimap<Point, std::weak_ptr<Node>, PointHash>;
 
@@ -48,6 +49,24 @@ public:
         const std::function<void()> &throw_on_cancel_callback
     );
 
+    /*!
+     * Same as above with the distance field of the overhang constructed in advance,
+     * for example in parallel with the trees of the layer above.
+     * \param[out] new_tree_cells If set, receives the index of the unsupported cell of the distance field each new tree
+     * appended to tree_roots was created for.
+     */
+    void generateNewTrees
+    (
+        DistanceField& distance_field,
+        const Polygons& current_outlines,
+        const BoundingBox& current_outlines_bbox,
+        const EdgeGrid::Grid& outline_locator,
+        coord_t supporting_radius,
+        coord_t wall_supporting_radius,
+        const std::function<void()> &throw_on_cancel_callback,
+        std::vector<size_t> *new_tree_cells = nullptr
+    );
+
     /*! Determine & connect to connection point in tree/outline.
      * \param min_dist_from_boundary_for_tree If the unsupported point is closer to the boundary than this then don't consider connecting it to a tree
      */
@@ -70,6 +89,11 @@ public:
      */
     bool attach(const Point& unsupported_location, const GroundingLocation& ground, NodeSPtr& new_child, NodeSPtr& new_root);
 
+    /*!
+     * \param[out] reconnected_tree_roots If set, receives the root replacing each of to_be_reconnected_tree_roots in tree_roots:
+     * the same root if it was kept, a new root if it was reconnected to the boundary, nullptr if it was attached to another tree
+     * and removed from tree_roots by moving the last root in its place.
+     */
     void reconnectRoots
     (
         std::vector<NodeSPtr>& to_be_reconnected_tree_roots,
@@ -77,7 +101,8 @@ public:
         const BoundingBox& current_outlines_bbox,
         const EdgeGrid::Grid& outline_locator,
         coord_t supporting_radius,
-        coord_t wall_supporting_radius
+        coord_t wall_supporting_radius,
+        std::vector<NodeSPtr> *reconnected_tree_roots = nullptr
     );
 
     Polylines convertToLines(const Polygons& limit_to_outline, coord_t line_overlap) const;
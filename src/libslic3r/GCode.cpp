@@ -25,6 +25,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/find.hpp>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/beast/core/detail/base64.hpp>
@@ -36,6 +37,7 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 // Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
 // We are using quite an old TBB 2017 U7. Before we update our build servers, let's use the old API, which is deprecated in up to date TBB.
@@ -1660,7 +1662,8 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
     BOOST_LOG_TRIVIAL(info) << "Exporting G-code finished" << log_memory_info();
     print->set_done(psGCodeExport);
     //BBS: set enable_label_object
-    result->label_object_enabled = m_enable_label_object;
+    if (result != nullptr)
+        result->label_object_enabled = m_enable_label_object;
 
     // Write the profiler measurements to file
     PROFILE_UPDATE();
@@ -3001,9 +3004,67 @@ void GCode::process_layers(
     std::vector<GCode::LayerResult> layers_results;
     layers_results.resize(layers_to_print.size());
 
+    auto layer_exported = [this](const std::vector<LayerToPrint> &layers) {
+        if (m_layer_exported_callback)
+            // The G-code of this print_z was generated, the rest of the pipeline only processes the G-code.
+            for (const LayerToPrint &layer_to_print : layers) {
+                if (layer_to_print.object_layer != nullptr)
+                    m_layer_exported_callback(*layer_to_print.object_layer);
+                if (layer_to_print.support_layer != nullptr)
+                    m_layer_exported_callback(*layer_to_print.support_layer);
+            }
+    };
+
+    // Layers of this export to be stored into m_layer_cache. The layers preceding the first changed layer are copied
+    // from the last export up to the last saved state of the generator, the export resumes from that state.
+    const bool                          cache_layers = this->layer_cache_enabled(print);
+    std::vector<GCodeLayerCache::Layer> cached_layers;
+    // Number of the leading layers of cached_layers with their G-code stored and the size of their G-code.
+    size_t                              num_cached_layers   = 0;
+    size_t                              cached_memory       = 0;
+    // The state of the generator is saved after the first layer flushing the cooling buffer at or after next_checkpoint.
+    size_t                              checkpoint_interval = 0;
+    size_t                              next_checkpoint     = 0;
+    if (cache_layers) {
+        std::vector<uint64_t> keys = this->layer_cache_keys(print, tool_ordering, print_object_instances_ordering, layers_to_print);
+        cached_layers.assign(keys.size(), {});
+        for (size_t i = 0; i < keys.size(); ++ i)
+            cached_layers[i].key = keys[i];
+        std::vector<GCodeLayerCache::Layer> &last_layers = m_layer_cache->m_layers;
+        // The memory limit may have been lowered since the last export.
+        size_t num_reused = 0;
+        size_t reused_memory = 0;
+        while (num_reused < std::min(last_layers.size(), keys.size()) && last_layers[num_reused].key == keys[num_reused] &&
+               reused_memory + GCodeLayerCache::layer_memory(last_layers[num_reused]) <= m_layer_cache->max_memory())
+            reused_memory += GCodeLayerCache::layer_memory(last_layers[num_reused ++]);
+        while (num_reused > 0 && ! last_layers[num_reused - 1].checkpoint)
+            -- num_reused;
+        for (; num_cached_layers < num_reused; ++ num_cached_layers) {
+            print.throw_if_canceled();
+            output_stream.write(last_layers[num_cached_layers].gcode);
+            cached_memory += GCodeLayerCache::layer_memory(last_layers[num_cached_layers]);
+            cached_layers[num_cached_layers] = std::move(last_layers[num_cached_layers]);
+            layer_exported(layers_to_print[num_cached_layers].second);
+        }
+        if (num_reused > 0) {
+            const LayerCheckpoint &checkpoint = *cached_layers[num_reused - 1].checkpoint;
+            this->restore_layer_checkpoint(checkpoint);
+            m_gcode_editer->set_parse_state(checkpoint.editor_parse);
+            m_gcode_editer->set_write_state(checkpoint.editor_write);
+            layer_to_print_idx = num_reused;
+            BOOST_LOG_TRIVIAL(info) << "G-code export: " << num_reused << " of " << layers_to_print.size() << " layers copied from the last export";
+        }
+        // The cache is not valid until this export finishes.
+        m_layer_cache->clear();
+        m_layer_cache->m_num_reused_layers = num_reused;
+        checkpoint_interval = std::max<size_t>(1, (layers_to_print.size() + GCodeLayerCache::max_checkpoints - 1) / GCodeLayerCache::max_checkpoints);
+        next_checkpoint     = layer_to_print_idx + checkpoint_interval - 1;
+    }
+
     // The pipeline is variable: The vase mode filter is optional.
     const auto generator = tbb::make_filter<void, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> GCode::LayerResult {
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx, &layer_exported,
+         &cached_layers, checkpoint_interval, &next_checkpoint](tbb::flow_control& fc) -> GCode::LayerResult {
             if (layer_to_print_idx == layers_to_print.size()) {
                 fc.stop();
                 return {};
@@ -3018,6 +3079,12 @@ void GCode::process_layers(
                 print.throw_if_canceled();
                 GCode::LayerResult res = this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, tool_ordering.get_most_used_extruder(), size_t(-1));
                 res.gcode_store_pos = layer_to_print_idx - 1;
+                // The G-code editor holds no G-code between the layers only after it flushed the preceding support layers.
+                if (! cached_layers.empty() && res.cooling_buffer_flush && res.gcode_store_pos >= next_checkpoint) {
+                    cached_layers[res.gcode_store_pos].checkpoint = this->save_layer_checkpoint();
+                    next_checkpoint = res.gcode_store_pos + checkpoint_interval;
+                }
+                layer_exported(layer.second);
                 return std::move(res);
             }
         });
@@ -3036,9 +3103,11 @@ void GCode::process_layers(
     std::vector<std::vector<PerExtruderAdjustments>> layers_extruder_adjustments(layers_to_print.size());
 
     const auto parsing = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, object_label](GCode::LayerResult in) -> GCode::LayerResult{
+    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, object_label, &cached_layers](GCode::LayerResult in) -> GCode::LayerResult{
         //record gcode
         in.gcode = gcode_editer.process_layer(std::move(in.gcode), in.layer_id, layers_extruder_adjustments[in.gcode_store_pos], object_label, in.cooling_buffer_flush, false);
+        if (! cached_layers.empty() && cached_layers[in.gcode_store_pos].checkpoint)
+            cached_layers[in.gcode_store_pos].checkpoint->editor_parse = gcode_editer.get_parse_state();
          return std::move(in);
     });
 
@@ -3047,7 +3116,8 @@ void GCode::process_layers(
 
     CoolingBuffer cooling_processor;
 
-    const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+    // The slow down is computed from the layer's own adjustments only, thus the layers are processed in parallel.
+    const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::parallel,
     [&cooling_processor, &layers_extruder_adjustments](GCode::LayerResult in) -> GCode::LayerResult {
         in.layer_time = cooling_processor.calculate_layer_slowdown(layers_extruder_adjustments[in.gcode_store_pos]);
          return std::move(in);
@@ -3065,8 +3135,24 @@ void GCode::process_layers(
 
     // step 5: rewite
     const auto write_gocde= tbb::make_filter<GCode::LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments](GCode::LayerResult in) -> std::string {
-         return gcode_editer.write_layer_gcode(std::move(in.gcode), in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, &cached_layers, &num_cached_layers, &cached_memory,
+     max_memory = cache_layers ? m_layer_cache->max_memory() : 0](GCode::LayerResult in) -> std::string {
+         std::string out = gcode_editer.write_layer_gcode(std::move(in.gcode), in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+         if (! cached_layers.empty()) {
+             GCodeLayerCache::Layer &cached = cached_layers[in.gcode_store_pos];
+             if (cached.checkpoint)
+                 cached.checkpoint->editor_write = gcode_editer.get_write_state();
+             // Only a prefix of the layers is cached.
+             if (num_cached_layers == in.gcode_store_pos) {
+                 const size_t memory = out.size() + (cached.checkpoint ? cached.checkpoint->memory : 0);
+                 if (cached_memory + memory <= max_memory) {
+                     cached.gcode   = out;
+                     cached_memory += memory;
+                     ++ num_cached_layers;
+                 }
+             }
+         }
+         return out;
     });
 
     std::vector<GCode::LayerResult> gcode_res;
@@ -3081,7 +3167,7 @@ void GCode::process_layers(
              if (layer_idx > 0){
                 gcode_res[layer_idx].layer_time = smooth_calculator.recaculate_layer_time(layer_idx, layers_extruder_adjustments[gcode_res[layer_idx].gcode_store_pos]);
              }
-             return gcode_res[layer_idx++];
+             return std::move(gcode_res[layer_idx++]);
         }
         });
 
@@ -3091,17 +3177,19 @@ void GCode::process_layers(
 
     // BBS: apply cooling
     // The pipeline elements are joined using const references, thus no copying is performed.
+    // Enough layers are kept in flight for the parallel cooling filter to keep all the cores busy behind the serial generator.
+    const size_t max_tokens = size_t(std::max(12, 2 * tbb::this_task_arena::max_concurrency()));
     if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_mode & parsing & cooling & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, generator & spiral_mode & parsing & cooling & write_gocde & output);
     else if (!m_config.z_direction_outwall_speed_continuous)
-        tbb::parallel_pipeline(12, generator & parsing & cooling & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, generator & parsing & cooling & write_gocde & output);
     else {
-        tbb::parallel_pipeline(12, generator & parsing & cooling & build_node);
+        tbb::parallel_pipeline(max_tokens, generator & parsing & cooling & build_node);
         std::string message;
         message = _L("Smoothing z direction speed");
         m_print->set_status(85, message);
         //append data
-        for (const LayerResult &res : layers_results) {
+        for (LayerResult &res : layers_results) {
             //remove empty gcode layer caused by support independent layers
             if (res.cooling_buffer_flush) {
                 smooth_calculator.append_data(layers_wall_collection[res.gcode_store_pos]);
@@ -3112,8 +3200,241 @@ void GCode::process_layers(
         smooth_calculator.smooth_layer_speed();
         message = _L("Exporting G-code");
         m_print->set_status(90, message);
-        tbb::parallel_pipeline(12, calculate_layer_time & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, calculate_layer_time & write_gocde & output);
+    }
+
+    if (cache_layers) {
+        cached_layers.resize(num_cached_layers);
+        m_layer_cache->m_layers = std::move(cached_layers);
+    }
+}
+
+bool GCode::layer_cache_enabled(const Print &print) const
+{
+    return m_layer_cache != nullptr && m_layer_cache->max_memory() > 0 && ! m_layer_exported_callback &&
+        ! m_wipe_tower && ! m_spiral_vase && ! m_config.z_direction_outwall_speed_continuous &&
+        // The travels avoiding the perimeters depend on the travels of the preceding layers.
+        ! m_config.reduce_crossing_wall &&
+        print.calib_params().mode == CalibMode::Calib_None;
+}
+
+std::vector<uint64_t> GCode::layer_cache_keys(
+    const Print                                                         &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+    const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print) const
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, print.config().hash());
+    // Placeholders of the custom G-codes, except for the time of the export.
+    static const std::set<std::string> timestamp_keys { "timestamp", "year", "month", "day", "hour", "minute", "second" };
+    for (const std::string &key : m_placeholder_parser.config().keys())
+        if (timestamp_keys.find(key) == timestamp_keys.end()) {
+            boost::hash_combine(seed, key);
+            boost::hash_combine(seed, m_placeholder_parser.config().option(key)->hash());
+        }
+    // The extrusions are not hashed, thus any step of a PrintObject executed again changes the keys of all the layers.
+    for (const PrintObject *object : print.objects()) {
+        boost::hash_combine(seed, object->id().id);
+        boost::hash_combine(seed, object->config().hash());
+        for (int step = 0; step < int(posCount); ++ step)
+            boost::hash_combine(seed, object->step_state_with_timestamp(PrintObjectStep(step)).timestamp);
+    }
+    for (PrintStep step : { psWipeTower, psSkirtBrim })
+        boost::hash_combine(seed, print.step_state_with_timestamp(step).timestamp);
+    for (const PrintInstance *instance : print_object_instances_ordering) {
+        boost::hash_combine(seed, instance->print_object->id().id);
+        boost::hash_combine(seed, instance->shift.x());
+        boost::hash_combine(seed, instance->shift.y());
+        boost::hash_combine(seed, instance->model_instance->get_labeled_id());
+    }
+    boost::hash_combine(seed, layers_to_print.size());
+    boost::hash_combine(seed, tool_ordering.get_most_used_extruder());
+    boost::hash_combine(seed, print.is_BBL_Printer());
+    // State of the generator after the start G-code.
+    const GCodeWriter::State writer = m_writer.get_state();
+    for (int i = 0; i < 3; ++ i)
+        boost::hash_combine(seed, writer.pos[i]);
+    boost::hash_combine(seed, writer.curr_extruder_id);
+    boost::hash_range(seed, writer.curr_filament_extruder.begin(), writer.curr_filament_extruder.end());
+    for (const Extruder::State &extruder : writer.filament_extruders) {
+        boost::hash_combine(seed, extruder.E);
+        boost::hash_combine(seed, extruder.absolute_E);
+        boost::hash_combine(seed, extruder.retracted);
+    }
+    boost::hash_combine(seed, m_origin.x());
+    boost::hash_combine(seed, m_origin.y());
+    boost::hash_combine(seed, m_last_pos.x());
+    boost::hash_combine(seed, m_last_pos.y());
+    boost::hash_combine(seed, m_last_pos_defined);
+    boost::hash_combine(seed, m_toolchange_count);
+    boost::hash_combine(seed, m_start_gcode_filament);
+    boost::hash_range(seed, m_initial_layer_extruders.begin(), m_initial_layer_extruders.end());
+    boost::hash_combine(seed, m_enable_label_object);
+    boost::hash_range(seed, m_label_objects_ids.begin(), m_label_objects_ids.end());
+
+    std::vector<uint64_t>                           keys;
+    std::unordered_map<const PrintRegion*, size_t> region_hashes;
+    keys.reserve(layers_to_print.size());
+    size_t key = seed;
+    for (const std::pair<coordf_t, std::vector<LayerToPrint>> &layer : layers_to_print) {
+        boost::hash_combine(key, layer.first);
+        boost::hash_combine(key, &layer == &layers_to_print.back());
+        const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+        boost::hash_combine(key, layer_tools.print_z);
+        boost::hash_combine(key, layer_tools.has_object);
+        boost::hash_combine(key, layer_tools.has_support);
+        boost::hash_range(key, layer_tools.extruders.begin(), layer_tools.extruders.end());
+        boost::hash_combine(key, layer_tools.extruder_override);
+        boost::hash_combine(key, layer_tools.has_skirt);
+        boost::hash_combine(key, layer_tools.has_wipe_tower);
+        boost::hash_combine(key, layer_tools.wipe_tower_partitions);
+        boost::hash_combine(key, layer_tools.wipe_tower_layer_height);
+        if (const CustomGCode::Item *custom_gcode = layer_tools.custom_gcode; custom_gcode != nullptr) {
+            boost::hash_combine(key, custom_gcode->print_z);
+            boost::hash_combine(key, int(custom_gcode->type));
+            boost::hash_combine(key, custom_gcode->extruder);
+            boost::hash_combine(key, custom_gcode->color);
+            boost::hash_combine(key, custom_gcode->extra);
+        }
+        for (const LayerToPrint &layer_to_print : layer.second) {
+            boost::hash_combine(key, layer_to_print.original_object);
+            if (const Layer *object_layer = layer_to_print.object_layer; object_layer != nullptr) {
+                boost::hash_combine(key, object_layer);
+                boost::hash_combine(key, object_layer->id());
+                boost::hash_combine(key, object_layer->print_z);
+                for (const LayerRegion *layerm : object_layer->regions()) {
+                    auto [it, inserted] = region_hashes.insert({ &layerm->region(), 0 });
+                    if (inserted)
+                        it->second = layerm->region().config().hash();
+                    boost::hash_combine(key, it->second);
+                }
+                boost::hash_combine(key, m_seam_placer.layer_hash(object_layer));
+            }
+            if (const SupportLayer *support_layer = layer_to_print.support_layer; support_layer != nullptr) {
+                boost::hash_combine(key, support_layer);
+                boost::hash_combine(key, support_layer->id());
+                boost::hash_combine(key, support_layer->print_z);
+            }
+        }
+        keys.emplace_back(key);
     }
+    return keys;
+}
+
+// Approximate size of a configuration in memory: the serialized size of its options.
+static size_t config_memory(const ConfigBase &config)
+{
+    size_t out = 0;
+    for (const std::string &key : config.keys())
+        out += key.size() + config.option(key)->serialize().size();
+    return out;
+}
+
+std::shared_ptr<GCode::LayerCheckpoint> GCode::save_layer_checkpoint() const
+{
+    auto checkpoint = std::make_shared<LayerCheckpoint>();
+    checkpoint->config                        = m_config;
+    checkpoint->writer                        = m_writer.get_state();
+    checkpoint->placeholder_parser            = m_placeholder_parser;
+    checkpoint->placeholder_parser_context    = m_placeholder_parser_context;
+    checkpoint->origin                        = m_origin;
+    checkpoint->ooze_prevention               = m_ooze_prevention;
+    checkpoint->wipe                          = m_wipe;
+    checkpoint->use_external_mp               = m_avoid_crossing_perimeters.used_external_mp();
+    checkpoint->use_external_mp_once          = m_avoid_crossing_perimeters.used_external_mp_once();
+    checkpoint->disabled_once                 = m_avoid_crossing_perimeters.disabled_once();
+    checkpoint->enable_loop_clipping          = m_enable_loop_clipping;
+    checkpoint->last_processor_extrusion_role = m_last_processor_extrusion_role;
+    checkpoint->layer_index                   = m_layer_index;
+    checkpoint->layer                         = m_layer;
+    checkpoint->object_layer_over_raft        = m_object_layer_over_raft;
+    checkpoint->last_extrusion_role           = m_last_extrusion_role;
+    checkpoint->last_height                   = m_last_height;
+    checkpoint->last_layer_z                  = m_last_layer_z;
+    checkpoint->max_layer_z                   = m_max_layer_z;
+    checkpoint->last_width                    = m_last_width;
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+    checkpoint->last_mm3_per_mm               = m_last_mm3_per_mm;
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+    checkpoint->last_pos                      = m_last_pos;
+    checkpoint->last_pos_defined              = m_last_pos_defined;
+    checkpoint->last_scarf_seam_flag          = m_last_scarf_seam_flag;
+    checkpoint->skirt_done                    = m_skirt_done;
+    checkpoint->brim_done                     = m_brim_done;
+    checkpoint->second_layer_things_done      = m_second_layer_things_done;
+    checkpoint->last_obj_copy                 = m_last_obj_copy;
+    checkpoint->objs_with_brim                = m_objsWithBrim;
+    checkpoint->obj_supports_with_brim        = m_objSupportsWithBrim;
+    checkpoint->support_traditional_timelapse = m_support_traditional_timelapse;
+    checkpoint->toolchange_count              = m_toolchange_count;
+    checkpoint->nominal_z                     = m_nominal_z;
+    checkpoint->need_change_layer_lift_z      = m_need_change_layer_lift_z;
+    checkpoint->start_gcode_filament          = m_start_gcode_filament;
+    checkpoint->initial_layer_extruders       = m_initial_layer_extruders;
+    checkpoint->placeholder_parser_failed_templates = m_placeholder_parser_failed_templates;
+    checkpoint->timelapse_warning_code        = m_timelapse_warning_code;
+    checkpoint->timelapse_pos_picker          = m_timelapse_pos_picker;
+    // The copies of the configurations dominate the size of the checkpoint.
+    checkpoint->memory                        = sizeof(LayerCheckpoint) + config_memory(checkpoint->config) + config_memory(checkpoint->placeholder_parser.config());
+    return checkpoint;
+}
+
+void GCode::restore_layer_checkpoint(const LayerCheckpoint &checkpoint)
+{
+    m_config                        = checkpoint.config;
+    m_writer.set_state(checkpoint.writer);
+    m_placeholder_parser            = checkpoint.placeholder_parser;
+    m_placeholder_parser_context    = checkpoint.placeholder_parser_context;
+    m_origin                        = checkpoint.origin;
+    m_ooze_prevention               = checkpoint.ooze_prevention;
+    m_wipe                          = checkpoint.wipe;
+    m_avoid_crossing_perimeters.use_external_mp(checkpoint.use_external_mp);
+    m_avoid_crossing_perimeters.reset_once_modifiers();
+    if (checkpoint.use_external_mp_once)
+        m_avoid_crossing_perimeters.use_external_mp_once();
+    if (checkpoint.disabled_once)
+        m_avoid_crossing_perimeters.disable_once();
+    m_enable_loop_clipping          = checkpoint.enable_loop_clipping;
+    m_last_processor_extrusion_role = checkpoint.last_processor_extrusion_role;
+    m_layer_index                   = checkpoint.layer_index;
+    m_layer                         = checkpoint.layer;
+    m_object_layer_over_raft        = checkpoint.object_layer_over_raft;
+    m_last_extrusion_role           = checkpoint.last_extrusion_role;
+    m_last_height                   = checkpoint.last_height;
+    m_last_layer_z                  = checkpoint.last_layer_z;
+    m_max_layer_z                   = checkpoint.max_layer_z;
+    m_last_width                    = checkpoint.last_width;
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+    m_last_mm3_per_mm               = checkpoint.last_mm3_per_mm;
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+    m_last_pos                      = checkpoint.last_pos;
+    m_last_pos_defined              = checkpoint.last_pos_defined;
+    m_last_scarf_seam_flag          = checkpoint.last_scarf_seam_flag;
+    m_skirt_done                    = checkpoint.skirt_done;
+    m_brim_done                     = checkpoint.brim_done;
+    m_second_layer_things_done      = checkpoint.second_layer_things_done;
+    m_last_obj_copy                 = checkpoint.last_obj_copy;
+    m_objsWithBrim                  = checkpoint.objs_with_brim;
+    m_objSupportsWithBrim           = checkpoint.obj_supports_with_brim;
+    m_support_traditional_timelapse = checkpoint.support_traditional_timelapse;
+    m_toolchange_count              = checkpoint.toolchange_count;
+    m_nominal_z                     = checkpoint.nominal_z;
+    m_need_change_layer_lift_z      = checkpoint.need_change_layer_lift_z;
+    m_start_gcode_filament          = checkpoint.start_gcode_filament;
+    m_initial_layer_extruders       = checkpoint.initial_layer_extruders;
+    m_placeholder_parser_failed_templates = checkpoint.placeholder_parser_failed_templates;
+    m_timelapse_warning_code        = checkpoint.timelapse_warning_code;
+    m_timelapse_pos_picker          = checkpoint.timelapse_pos_picker;
+    m_processor.result().timelapse_warning_code = m_timelapse_warning_code;
+}
+
+size_t GCodeLayerCache::memory() const
+{
+    size_t out = 0;
+    for (const Layer &layer : m_layers)
+        out += layer_memory(layer);
+    return out;
 }
 
 // Process all layers of a single object instance (sequential mode) with a parallel pipeline:
@@ -3188,7 +3509,8 @@ void GCode::process_layers(
     std::vector<std::vector<OutwallCollection>> layers_wall_collection(layers_to_print.size());
     CoolingBuffer cooling_processor;
 
-    const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+    // The slow down is computed from the layer's own adjustments only, thus the layers are processed in parallel.
+    const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::parallel,
     [&cooling_processor, &layers_extruder_adjustments](GCode::LayerResult in) -> GCode::LayerResult {
         in.layer_time = cooling_processor.calculate_layer_slowdown(layers_extruder_adjustments[in.gcode_store_pos]);
          return std::move(in);
@@ -3223,7 +3545,7 @@ void GCode::process_layers(
              if (layer_idx > 0) {
                 gcode_res[layer_idx].layer_time = smooth_calculator.recaculate_layer_time(layer_idx, layers_extruder_adjustments[gcode_res[layer_idx].gcode_store_pos]);
              }
-             return gcode_res[layer_idx++];
+             return std::move(gcode_res[layer_idx++]);
         }
         });
 
@@ -3233,26 +3555,28 @@ void GCode::process_layers(
 
     // BBS: apply cooling
     // The pipeline elements are joined using const references, thus no copying is performed.
+    // Enough layers are kept in flight for the parallel cooling filter to keep all the cores busy behind the serial generator.
+    const size_t max_tokens = size_t(std::max(12, 2 * tbb::this_task_arena::max_concurrency()));
     if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_mode & parsing & cooling & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, generator & spiral_mode & parsing & cooling & write_gocde & output);
     else if (!m_config.z_direction_outwall_speed_continuous)
-        tbb::parallel_pipeline(12, generator & parsing & cooling & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, generator & parsing & cooling & write_gocde & output);
     else {
-        tbb::parallel_pipeline(12, generator & parsing & cooling & build_node);
+        tbb::parallel_pipeline(max_tokens, generator & parsing & cooling & build_node);
         // step 4.2: smoothing
         // break pipeline and do z smoothing
         // append data
-        for (const LayerResult &res : layers_results) {
+        for (LayerResult &res : layers_results) {
             // remove empty gcode layer caused by support independent layers
             if (res.cooling_buffer_flush) {
                 smooth_calculator.append_data(layers_wall_collection[res.gcode_store_pos]);
-                gcode_res.push_back(res);
+                gcode_res.push_back(std::move(res));
             }
         }
 
         smooth_calculator.smooth_layer_speed();
 
-        tbb::parallel_pipeline(12, calculate_layer_time & write_gocde & output);
+        tbb::parallel_pipeline(max_tokens, calculate_layer_time & write_gocde & output);
     }
 }
 
@@ -5107,8 +5431,21 @@ std::string GCode::extrude_infill(const Print &print, const std::vector<ObjectBy
                     extrusions.emplace_back(ee);
             if (! extrusions.empty()) {
                 m_config.apply(print.get_print_region(&region - &by_region.front()).config());
-                chain_and_reorder_extrusion_entities(extrusions, &m_last_pos);
-                for (const ExtrusionEntity *fill : extrusions) {
+                // Chaining crashes on empty collections.
+                extrusions.erase(std::remove_if(extrusions.begin(), extrusions.end(), [](const ExtrusionEntity *ee) {
+                    auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(ee);
+                    return eec != nullptr && eec->empty();
+                }), extrusions.end());
+                // The extrusions of the layer are not reversed in place, a reversed copy is extruded instead,
+                // so that exporting the G-code again or resuming it from the layer cache produces the same G-code.
+                for (const std::pair<size_t, bool> &idx : chain_extrusion_entities(extrusions, &m_last_pos)) {
+                    const ExtrusionEntity           *fill = extrusions[idx.first];
+                    std::unique_ptr<ExtrusionEntity> reversed;
+                    if (idx.second) {
+                        reversed.reset(fill->clone());
+                        reversed->reverse();
+                        fill = reversed.get();
+                    }
                     auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(fill);
                     if (eec) {
                         for (ExtrusionEntity *ee : eec->chained_path_from(m_last_pos).entities)
@@ -5162,32 +5499,113 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
     return gcode;
 }
 
+// The G-code is written in chunks of at least 4MB, at most 4 of them waiting for the disk.
+static constexpr size_t GCodeOutputChunkSize      = 4 * 1024 * 1024;
+static constexpr size_t GCodeOutputMaxChunksQueued = 4;
+
+GCode::GCodeOutputStream::GCodeOutputStream(FILE *f, GCodeProcessor &processor) : f(f), m_processor(processor)
+{
+    if (this->f != nullptr) {
+        m_chunk.reserve(GCodeOutputChunkSize);
+        m_writer_thread = std::thread([this]() { this->write_chunks(); });
+    }
+}
+
 bool GCode::GCodeOutputStream::is_error() const
 {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_write_error)
+            return true;
+    }
     return ::ferror(this->f);
 }
 
 void GCode::GCodeOutputStream::flush()
 {
+    if (this->f == nullptr)
+        return;
+    if (! m_chunk.empty())
+        this->submit_chunk();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_chunks_to_write.empty() && ! m_writing; });
+    }
     ::fflush(this->f);
 }
 
 void GCode::GCodeOutputStream::close()
 {
     if (this->f) {
+        if (! m_chunk.empty())
+            this->submit_chunk();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        // The writer thread exits after all the submitted chunks are written.
+        m_writer_thread.join();
         ::fclose(this->f);
         this->f = nullptr;
     }
 }
 
-void GCode::GCodeOutputStream::write(const char *what)
+void GCode::GCodeOutputStream::write(const std::string &what)
+{
+    if (what.empty())
+        return;
+    // The processor parses the string in place, the file receives a copy in the current chunk.
+    m_processor.process_buffer(what);
+    m_chunk += what;
+    if (m_chunk.size() >= GCodeOutputChunkSize)
+        this->submit_chunk();
+}
+
+void GCode::GCodeOutputStream::submit_chunk()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_chunks_to_write.size() < GCodeOutputMaxChunksQueued; });
+        m_chunks_to_write.emplace_back(std::move(m_chunk));
+        if (m_free_chunks.empty()) {
+            m_chunk = std::string();
+            m_chunk.reserve(GCodeOutputChunkSize);
+        } else {
+            m_chunk = std::move(m_free_chunks.back());
+            m_free_chunks.pop_back();
+        }
+    }
+    m_condition.notify_all();
+}
+
+void GCode::GCodeOutputStream::write_chunks()
 {
-    if (what != nullptr) {
-        const char* gcode = what;
-        // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), this->f);
-        //FIXME don't allocate a string, maybe process a batch of lines?
-        m_processor.process_buffer(std::string(gcode));
+    for (;;) {
+        std::string chunk;
+        bool        write_error;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || ! m_chunks_to_write.empty(); });
+            if (m_chunks_to_write.empty())
+                // Stopped and everything was written.
+                return;
+            chunk = std::move(m_chunks_to_write.front());
+            m_chunks_to_write.pop_front();
+            m_writing   = true;
+            write_error = m_write_error;
+        }
+        // Once a write failed, the rest of the G-code is dropped, the export will fail on is_error().
+        if (! write_error && ::fwrite(chunk.data(), 1, chunk.size(), this->f) != chunk.size())
+            write_error = true;
+        chunk.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free_chunks.emplace_back(std::move(chunk));
+            m_writing     = false;
+            m_write_error = write_error;
+        }
+        m_condition.notify_all();
     }
 }
 
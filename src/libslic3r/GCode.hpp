@@ -22,10 +22,15 @@
 #include "GCode/TimelapsePosPicker.hpp"
 
 #include <cfloat>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 
 #ifdef HAS_PRESSURE_EQUALIZER
 #include "GCode/PressureEqualizer.hpp"
@@ -35,6 +40,7 @@ namespace Slic3r {
 
 // Forward declarations.
 class GCode;
+class GCodeLayerCache;
 
 namespace { struct Item; }
 struct PrintInstance;
@@ -189,6 +195,12 @@ public:
     void            export_layer_filaments(GCodeProcessorResult* result);
     //BBS: set offset for gcode writer
     void set_gcode_offset(double x, double y) { m_writer.set_xy_offset(x, y); m_processor.set_xy_offset(x, y);}
+    // Called for each object and support layer once its G-code was generated, thus the layer is not accessed
+    // by the G-code generator anymore. Only called when printing all the objects layer by layer (non-sequential mode).
+    void set_layer_exported_callback(std::function<void(const Layer&)> callback) { m_layer_exported_callback = std::move(callback); }
+    // G-code of the layers exported by the last export of the same Print, the layers preceding the first changed layer are copied
+    // from the cache instead of being generated again. Only used when printing all the objects layer by layer (non-sequential mode).
+    void set_layer_cache(GCodeLayerCache *layer_cache) { m_layer_cache = layer_cache; }
 
     // Exported for the helper classes (OozePrevention, Wipe) and for the Perl binding for unit tests.
     const Vec2d&    origin() const { return m_origin; }
@@ -271,20 +283,23 @@ public:
     };
 
 private:
+    // The G-code is passed to the processor as it is written, while it is accumulated into large chunks
+    // written into the file by a background thread, so that the export pipeline does not wait for the disk.
     class GCodeOutputStream {
     public:
-        GCodeOutputStream(FILE *f, GCodeProcessor &processor) : f(f), m_processor(processor) {}
+        GCodeOutputStream(FILE *f, GCodeProcessor &processor);
         ~GCodeOutputStream() { this->close(); }
 
         bool is_open() const { return f; }
         bool is_error() const;
 
+        // Waits until all the G-code written so far is in the file.
         void flush();
         void close();
 
         // Write a string into a file.
-        void write(const std::string& what) { this->write(what.c_str()); }
-        void write(const char* what);
+        void write(const std::string& what);
+        void write(const char* what) { if (what != nullptr) this->write(std::string(what)); }
 
         // Write a string into a file.
         // Add a newline, if the string does not end with a newline already.
@@ -295,8 +310,27 @@ private:
         void write_format(const char* format, ...);
 
     private:
+        // Hands m_chunk over to the writer thread. Blocks while too many chunks are waiting to be written.
+        void submit_chunk();
+        // Body of the writer thread.
+        void write_chunks();
+
         FILE *f = nullptr;
         GCodeProcessor &m_processor;
+
+        // G-code being accumulated, handed over to the writer thread once it is at least ChunkSize long.
+        std::string                     m_chunk;
+        // Chunks waiting for the writer thread.
+        std::deque<std::string>         m_chunks_to_write;
+        // Written chunks, reused for accumulating the G-code to avoid reallocations.
+        std::vector<std::string>        m_free_chunks;
+        // The writer thread is writing a chunk, which is neither in m_chunks_to_write nor in m_free_chunks.
+        bool                            m_writing { false };
+        bool                            m_write_error { false };
+        bool                            m_stop { false };
+        mutable std::mutex              m_mutex;
+        std::condition_variable         m_condition;
+        std::thread                     m_writer_thread;
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
 
@@ -364,6 +398,70 @@ private:
         const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
         const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
         GCodeOutputStream                                                   &output_stream);
+
+    // State of the G-code generator after a layer, from which the incremental G-code export resumes the export, see GCodeLayerCache.
+    // The state of the generator is saved by the generator stage of the pipeline, the state of the G-code editor
+    // by the parsing and by the writing stage.
+    struct LayerCheckpoint
+    {
+        FullPrintConfig                     config;
+        GCodeWriter::State                  writer;
+        PlaceholderParser                   placeholder_parser;
+        PlaceholderParser::ContextData      placeholder_parser_context;
+        Vec2d                               origin;
+        OozePrevention                      ooze_prevention;
+        Wipe                                wipe;
+        bool                                use_external_mp;
+        bool                                use_external_mp_once;
+        bool                                disabled_once;
+        bool                                enable_loop_clipping;
+        ExtrusionRole                       last_processor_extrusion_role;
+        int                                 layer_index;
+        const Layer*                        layer;
+        bool                                object_layer_over_raft;
+        ExtrusionRole                       last_extrusion_role;
+        float                               last_height;
+        float                               last_layer_z;
+        float                               max_layer_z;
+        float                               last_width;
+#if ENABLE_GCODE_VIEWER_DATA_CHECKING
+        double                              last_mm3_per_mm;
+#endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
+        Point                               last_pos;
+        bool                                last_pos_defined;
+        bool                                last_scarf_seam_flag;
+        std::vector<coordf_t>               skirt_done;
+        bool                                brim_done;
+        bool                                second_layer_things_done;
+        std::pair<const PrintObject*, Point> last_obj_copy;
+        std::set<ObjectID>                  objs_with_brim;
+        std::set<ObjectID>                  obj_supports_with_brim;
+        bool                                support_traditional_timelapse;
+        unsigned int                        toolchange_count;
+        coordf_t                            nominal_z;
+        bool                                need_change_layer_lift_z;
+        int                                 start_gcode_filament;
+        std::set<unsigned int>              initial_layer_extruders;
+        std::map<std::string, std::string>  placeholder_parser_failed_templates;
+        int                                 timelapse_warning_code;
+        TimelapsePosPicker                  timelapse_pos_picker;
+        GCodeEditor::ParseState             editor_parse;
+        GCodeEditor::WriteState             editor_write;
+        // Approximate size of the checkpoint in memory, counted into the memory limit of GCodeLayerCache.
+        size_t                              memory;
+    };
+    // Is the export of the layers cached by m_layer_cache? Not with the wipe tower, the spiral vase, the Z speed smoothing,
+    // the travels avoiding the walls or the calibration patterns, which keep state outside of LayerCheckpoint.
+    bool            layer_cache_enabled(const Print &print) const;
+    // Keys of layers_to_print for GCodeLayerCache.
+    std::vector<uint64_t> layer_cache_keys(
+        const Print                                                         &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+        const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print) const;
+    // Saves the state of the generator, the state of the G-code editor is filled in by the pipeline.
+    std::shared_ptr<LayerCheckpoint> save_layer_checkpoint() const;
+    void            restore_layer_checkpoint(const LayerCheckpoint &checkpoint);
     // Process all layers of a single object instance (sequential mode) with a parallel pipeline:
     // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
     // and export G-code into file.
@@ -537,6 +635,8 @@ private:
     bool                                m_last_scarf_seam_flag;
     std::unique_ptr<GCodeEditor>        m_gcode_editer;
     std::unique_ptr<SpiralVase>         m_spiral_vase;
+    std::function<void(const Layer&)>   m_layer_exported_callback;
+    GCodeLayerCache                    *m_layer_cache { nullptr };
 #ifdef HAS_PRESSURE_EQUALIZER
     std::unique_ptr<PressureEqualizer>  m_pressure_equalizer;
 #endif /* HAS_PRESSURE_EQUALIZER */
@@ -614,6 +714,51 @@ private:
     friend class Wipe;
     friend class WipeTowerIntegration;
     friend class Print;
+    friend class GCodeLayerCache;
+};
+
+// G-code of the layers exported by the last G-code export of a Print. The next export of the same Print copies the layers
+// preceding the first layer, which would be exported differently, for example after a custom G-code, a pause or a color change
+// was inserted, and generates the following layers only. A PrintObject step executed again changes all the layers.
+//
+// The key of a layer chains the key of the previous layer with a hash of what the G-code of the layer is generated from:
+// the print configuration, the timestamps of the PrintObject and Print steps, the tool ordering, the regions and the seams
+// of the layer. Thus all the layers up to the first changed layer keep their keys. The state of the G-code generator
+// is saved after every few layers, the export resumes after the last saved layer preceding the first changed layer.
+// The G-code and the saved states are held in memory up to a memory limit, the layers above the limit are not cached.
+// Disabled by default.
+class GCodeLayerCache
+{
+public:
+    // Maximum size of the G-code and of the saved states of the G-code generator held in memory, 0 disables the cache.
+    void        set_max_memory(size_t bytes) { m_max_memory = bytes; if (bytes == 0) this->clear(); }
+    size_t      max_memory() const { return m_max_memory; }
+    // Size of the G-code and of the saved states of the G-code generator held in memory.
+    size_t      memory() const;
+    // Number of layers copied from the cache by the last export.
+    size_t      num_reused_layers() const { return m_num_reused_layers; }
+    void        clear() { m_layers.clear(); m_num_reused_layers = 0; }
+
+private:
+    // At most this many states of the G-code generator are saved, each of them holds a copy of the configuration.
+    static constexpr const size_t max_checkpoints = 32;
+
+    struct Layer
+    {
+        uint64_t                                  key { 0 };
+        // Final G-code of the layer, empty for the support layers flushed together with the following layer.
+        std::string                               gcode;
+        // Set if the state of the generator was saved after this layer.
+        std::shared_ptr<GCode::LayerCheckpoint>   checkpoint;
+    };
+    static size_t layer_memory(const Layer &layer) { return layer.gcode.size() + (layer.checkpoint ? layer.checkpoint->memory : 0); }
+
+    size_t                                        m_max_memory { 0 };
+    size_t                                        m_num_reused_layers { 0 };
+    // Cached layers, starting with the first layer of the print.
+    std::vector<Layer>                            m_layers;
+
+    friend class GCode;
 };
 
 std::vector<const PrintInstance*> sort_object_instances_by_model_order(const Print& print, bool init_order = false);
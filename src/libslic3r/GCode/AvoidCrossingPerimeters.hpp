@@ -17,9 +17,9 @@ class AvoidCrossingPerimeters
 public:
     // Routing around the objects vs. inside a single object.
     void        use_external_mp(bool use = true) { m_use_external_mp = use; };
-    bool        used_external_mp() { return m_use_external_mp; }
+    bool        used_external_mp() const { return m_use_external_mp; }
     void        use_external_mp_once()  { m_use_external_mp_once = true; }
-    bool        used_external_mp_once() { return m_use_external_mp_once; }
+    bool        used_external_mp_once() const { return m_use_external_mp_once; }
     void        disable_once()          { m_disabled_once = true; }
     bool        disabled_once() const   { return m_disabled_once; }
     void        reset_once_modifiers()  { m_use_external_mp_once = false; m_disabled_once = false; }
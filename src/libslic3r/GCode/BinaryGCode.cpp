@@ -0,0 +1,460 @@
+#include "BinaryGCode.hpp"
+
+#include "../libslic3r.h"
+#include "../Exception.hpp"
+#include "../Utils.hpp"
+#include "libslic3r_version.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/beast/core/detail/base64.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "../miniz_extension.hpp"
+
+namespace Slic3r {
+namespace BinaryGCode {
+
+static constexpr const char     MAGIC[4] = { 'G', 'C', 'D', 'E' };
+static constexpr const uint32_t VERSION  = 1;
+// Size of the file header: magic, version, checksum type.
+static constexpr const size_t   FILE_HEADER_SIZE = 10;
+// Maximum size of the text G-code stored into a single G-code block.
+static constexpr const size_t   GCODE_BLOCK_SIZE = 1024 * 1024;
+
+static void append_u16(std::string &out, uint16_t v)
+{
+    out += char(v & 0xff);
+    out += char(v >> 8);
+}
+
+static void append_u32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++ i)
+        out += char((v >> (8 * i)) & 0xff);
+}
+
+static uint16_t read_u16(const unsigned char *p) { return uint16_t(p[0] | (p[1] << 8)); }
+static uint32_t read_u32(const unsigned char *p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+
+static void write_data(FILE *f, const void *data, size_t size)
+{
+    if (size > 0 && ::fwrite(data, 1, size, f) != size)
+        throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nIs the disk full?\n"));
+}
+
+static void read_data(FILE *f, void *data, size_t size)
+{
+    if (size > 0 && ::fread(data, 1, size, f) != size)
+        throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nThe file is truncated or cannot be read.\n"));
+}
+
+static void write_block(FILE *f, EBlockType type, ECompressionType compression, const std::string &params, std::string_view data)
+{
+    std::string compressed;
+    std::string_view payload = data;
+    if (compression == ECompressionType::Deflate) {
+        mz_ulong compressed_size = mz_compressBound(mz_ulong(data.size()));
+        compressed.resize(compressed_size);
+        if (mz_compress2((unsigned char*)compressed.data(), &compressed_size, (const unsigned char*)data.data(), mz_ulong(data.size()), MZ_DEFAULT_LEVEL) != MZ_OK)
+            throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nCompression error.\n"));
+        compressed.resize(compressed_size);
+        payload = compressed;
+    }
+
+    std::string header;
+    append_u16(header, uint16_t(type));
+    append_u16(header, uint16_t(compression));
+    append_u32(header, uint32_t(data.size()));
+    if (compression != ECompressionType::None)
+        append_u32(header, uint32_t(payload.size()));
+    header += params;
+
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, (const unsigned char*)header.data(), header.size());
+    crc = mz_crc32(crc, (const unsigned char*)payload.data(), payload.size());
+    std::string checksum;
+    append_u32(checksum, uint32_t(crc));
+
+    write_data(f, header.data(), header.size());
+    write_data(f, payload.data(), payload.size());
+    write_data(f, checksum.data(), checksum.size());
+}
+
+static std::string encoding_params(uint16_t encoding)
+{
+    std::string params;
+    append_u16(params, encoding);
+    return params;
+}
+
+struct Thumbnail
+{
+    EThumbnailFormat format;
+    uint16_t         width;
+    uint16_t         height;
+    std::string      data;
+};
+
+using MetadataItems = std::vector<std::pair<std::string, std::string>>;
+
+struct Metadata
+{
+    // Items of the header block and of the configuration block of the text G-code.
+    MetadataItems          print;
+    MetadataItems          slicer;
+    std::vector<Thumbnail> thumbnails;
+    // Offset of the executable block in the text G-code, the G-code blocks start there.
+    size_t                 gcode_offset { 0 };
+};
+
+// Keys of the slicer metadata copied into the printer metadata, which is read by the printers.
+static constexpr const char *PRINTER_METADATA_KEYS[] = {
+    "printer_model", "nozzle_diameter", "filament_type", "filament_colour", "nozzle_temperature", "nozzle_temperature_initial_layer",
+    "curr_bed_type", "layer_height", "sparse_infill_density", "enable_support", "brim_width"
+};
+
+static const char *THUMBNAIL_BLOCK_START = "; THUMBNAIL_BLOCK_START";
+static const char *THUMBNAIL_BLOCK_END   = "; THUMBNAIL_BLOCK_END";
+// Row length of the base64 encoded thumbnails, see export_thumbnails_to_file() in GCode.cpp.
+static constexpr const size_t THUMBNAIL_ROW_LENGTH = 78;
+
+// "; key: value" or "; key = value" comment line into a key / value pair, other lines are ignored.
+static void append_metadata_line(MetadataItems &out, std::string_view line)
+{
+    if (line.empty() || line.front() != ';')
+        return;
+    line.remove_prefix(1);
+    size_t pos = line.find_first_of(":=");
+    if (pos == std::string_view::npos)
+        return;
+    std::string key(line.substr(0, pos));
+    std::string value(line.substr(pos + 1));
+    boost::trim(key);
+    boost::trim(value);
+    if (! key.empty())
+        out.emplace_back(std::move(key), std::move(value));
+}
+
+// INI encoding of the metadata blocks.
+static std::string metadata_to_ini(const MetadataItems &items)
+{
+    std::string out;
+    for (const auto &[key, value] : items)
+        out += key + '=' + value + '\n';
+    return out;
+}
+
+static MetadataItems metadata_from_ini(const std::string &ini)
+{
+    MetadataItems     out;
+    std::string_view  data(ini);
+    while (! data.empty()) {
+        size_t           eol  = data.find('\n');
+        std::string_view line = data.substr(0, eol);
+        data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
+        if (size_t pos = line.find('='); pos != std::string_view::npos)
+            out.emplace_back(std::string(line.substr(0, pos)), std::string(line.substr(pos + 1)));
+    }
+    return out;
+}
+
+// Collects the header and configuration blocks and the thumbnails, which are all exported before the executable block.
+static Metadata collect_metadata(const std::string &src_path)
+{
+    boost::nowide::ifstream ifs(src_path, std::ios::binary);
+    if (! ifs.good())
+        throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nCannot open file for reading.\n"));
+
+    enum class Section { None, Header, Config, Thumbnail };
+    Metadata    metadata;
+    Section     section = Section::None;
+    std::string base64;
+    std::string line;
+    size_t      offset = 0;
+    bool        executable_block_found = false;
+    while (std::getline(ifs, line)) {
+        const size_t line_offset = offset;
+        offset += line.size() + 1;
+        if (! line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line == "; EXECUTABLE_BLOCK_START") {
+            metadata.gcode_offset  = line_offset;
+            executable_block_found = true;
+            break;
+        }
+        switch (section) {
+        case Section::None:
+            if (line == "; HEADER_BLOCK_START")
+                section = Section::Header;
+            else if (line == "; CONFIG_BLOCK_START")
+                section = Section::Config;
+            else if (boost::starts_with(line, "; thumbnail")) {
+                // "; thumbnail begin 300x300 12345", "; thumbnail_JPG begin ...", "; thumbnail_QOI begin ..."
+                Thumbnail thumbnail;
+                thumbnail.format = boost::starts_with(line, "; thumbnail_JPG ") ? EThumbnailFormat::JPG :
+                                   boost::starts_with(line, "; thumbnail_QOI ") ? EThumbnailFormat::QOI : EThumbnailFormat::PNG;
+                unsigned int width = 0, height = 0;
+                size_t pos = line.find(" begin ");
+                if (pos != std::string::npos && sscanf(line.c_str() + pos + 7, "%ux%u", &width, &height) == 2) {
+                    thumbnail.width  = uint16_t(width);
+                    thumbnail.height = uint16_t(height);
+                    metadata.thumbnails.emplace_back(std::move(thumbnail));
+                    base64.clear();
+                    section = Section::Thumbnail;
+                }
+            }
+            break;
+        case Section::Header:
+            if (line == "; HEADER_BLOCK_END")
+                section = Section::None;
+            else
+                append_metadata_line(metadata.print, line);
+            break;
+        case Section::Config:
+            if (line == "; CONFIG_BLOCK_END")
+                section = Section::None;
+            else
+                append_metadata_line(metadata.slicer, line);
+            break;
+        case Section::Thumbnail:
+            if (boost::starts_with(line, "; thumbnail") && boost::ends_with(line, " end")) {
+                std::string &data = metadata.thumbnails.back().data;
+                data.resize(boost::beast::detail::base64::decoded_size(base64.size()));
+                data.resize(boost::beast::detail::base64::decode(data.data(), base64.data(), base64.size()).first);
+                section = Section::None;
+            } else if (line.size() > 2)
+                base64.append(line, 2, std::string::npos);
+            break;
+        }
+    }
+    // Without the executable block the file was not exported by GCode::do_export(), it is stored as G-code as it is.
+    return executable_block_found ? metadata : Metadata();
+}
+
+// Text G-code preceding the executable block, as exported by GCode::do_export().
+static std::string metadata_to_gcode(const MetadataItems &file, const MetadataItems &print, const MetadataItems &slicer, const std::vector<Thumbnail> &thumbnails)
+{
+    std::string out;
+    if (! print.empty()) {
+        out += "; HEADER_BLOCK_START\n";
+        for (const auto &[key, value] : file)
+            if (key == "Producer")
+                out += "; " + value + "\n";
+        for (const auto &[key, value] : print)
+            out += "; " + key + ": " + value + "\n";
+        out += "; HEADER_BLOCK_END\n\n";
+    }
+    if (! slicer.empty()) {
+        out += "; CONFIG_BLOCK_START\n";
+        for (const auto &[key, value] : slicer)
+            out += "; " + key + " = " + value + "\n";
+        out += "; CONFIG_BLOCK_END\n\n";
+    }
+    for (const Thumbnail &thumbnail : thumbnails) {
+        std::string encoded;
+        encoded.resize(boost::beast::detail::base64::encoded_size(thumbnail.data.size()));
+        encoded.resize(boost::beast::detail::base64::encode(encoded.data(), thumbnail.data.data(), thumbnail.data.size()));
+        const char *tag = thumbnail.format == EThumbnailFormat::JPG ? "thumbnail_JPG" : thumbnail.format == EThumbnailFormat::QOI ? "thumbnail_QOI" : "thumbnail";
+        out += std::string(THUMBNAIL_BLOCK_START) + "\n";
+        out += "; " + std::string(tag) + " begin " + std::to_string(thumbnail.width) + "x" + std::to_string(thumbnail.height) + " " + std::to_string(encoded.size()) + "\n";
+        for (size_t i = 0; i < encoded.size(); i += THUMBNAIL_ROW_LENGTH)
+            out += "; " + encoded.substr(i, THUMBNAIL_ROW_LENGTH) + "\n";
+        out += "; " + std::string(tag) + " end\n";
+        out += std::string(THUMBNAIL_BLOCK_END) + "\n\n";
+    }
+    return out;
+}
+
+bool is_binary_gcode_file(const std::string &path)
+{
+    FilePtr f{ boost::nowide::fopen(path.c_str(), "rb") };
+    if (f.f == nullptr)
+        return false;
+    char magic[sizeof(MAGIC)];
+    return ::fread(magic, 1, sizeof(magic), f.f) == sizeof(magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void convert_ascii_to_binary(const std::string &src_path, const std::string &dst_path, ECompressionType compression)
+{
+    Metadata metadata = collect_metadata(src_path);
+
+    FilePtr in{ boost::nowide::fopen(src_path.c_str(), "rb") };
+    if (in.f == nullptr)
+        throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nCannot open file for reading.\n"));
+    FilePtr out{ boost::nowide::fopen(dst_path.c_str(), "wb") };
+    if (out.f == nullptr)
+        throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nCannot open file for writing.\n"));
+
+    try {
+        std::string file_header(MAGIC, sizeof(MAGIC));
+        append_u32(file_header, VERSION);
+        append_u16(file_header, uint16_t(EChecksumType::CRC32));
+        write_data(out.f, file_header.data(), file_header.size());
+
+        MetadataItems printer_metadata;
+        for (const char *key : PRINTER_METADATA_KEYS)
+            if (auto it = std::find_if(metadata.slicer.begin(), metadata.slicer.end(), [key](const auto &item) { return item.first == key; }); it != metadata.slicer.end())
+                printer_metadata.emplace_back(*it);
+
+        // The blocks in the order required by the specification.
+        write_block(out.f, EBlockType::FileMetadata, compression, encoding_params(METADATA_ENCODING_INI), metadata_to_ini({ { "Producer", header_slic3r_generated() } }));
+        write_block(out.f, EBlockType::PrinterMetadata, compression, encoding_params(METADATA_ENCODING_INI), metadata_to_ini(printer_metadata));
+        for (const Thumbnail &thumbnail : metadata.thumbnails) {
+            std::string params;
+            append_u16(params, uint16_t(thumbnail.format));
+            append_u16(params, thumbnail.width);
+            append_u16(params, thumbnail.height);
+            // The thumbnail images are compressed already.
+            write_block(out.f, EBlockType::Thumbnail, ECompressionType::None, params, thumbnail.data);
+        }
+        write_block(out.f, EBlockType::PrintMetadata, compression, encoding_params(METADATA_ENCODING_INI), metadata_to_ini(metadata.print));
+        write_block(out.f, EBlockType::SlicerMetadata, compression, encoding_params(METADATA_ENCODING_INI), metadata_to_ini(metadata.slicer));
+
+        // Split the executable block into G-code blocks of whole lines.
+        if (::fseek(in.f, long(metadata.gcode_offset), SEEK_SET) != 0)
+            throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nError while reading from file.\n"));
+        std::vector<char> buffer(GCODE_BLOCK_SIZE);
+        size_t            buffer_used = 0;
+        for (;;) {
+            const size_t cnt_read = ::fread(buffer.data() + buffer_used, 1, buffer.size() - buffer_used, in.f);
+            if (::ferror(in.f))
+                throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nError while reading from file.\n"));
+            buffer_used += cnt_read;
+            if (buffer_used == 0)
+                break;
+            const bool eof = cnt_read == 0 || ::feof(in.f);
+            // Cut the block after the last end of line, unless a single line does not fit the buffer or the end of file was reached.
+            size_t block_size = buffer_used;
+            if (! eof) {
+                auto it_eol = std::find(std::make_reverse_iterator(buffer.begin() + buffer_used), buffer.rend(), '\n');
+                if (it_eol != buffer.rend())
+                    block_size = size_t(it_eol.base() - buffer.begin());
+            }
+            write_block(out.f, EBlockType::GCode, compression, encoding_params(GCODE_ENCODING_NONE), std::string_view(buffer.data(), block_size));
+            std::memmove(buffer.data(), buffer.data() + block_size, buffer_used - block_size);
+            buffer_used -= block_size;
+            if (eof && buffer_used == 0)
+                break;
+        }
+        if (::fflush(out.f) != 0 || ::ferror(out.f))
+            throw Slic3r::RuntimeError(std::string("Binary G-code export failed.\nIs the disk full?\n"));
+    } catch (...) {
+        out.close();
+        boost::nowide::remove(dst_path.c_str());
+        throw;
+    }
+}
+
+void convert_binary_to_ascii(const std::string &src_path, const std::string &dst_path)
+{
+    FilePtr in{ boost::nowide::fopen(src_path.c_str(), "rb") };
+    if (in.f == nullptr)
+        throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nCannot open file for reading.\n"));
+    FilePtr out{ boost::nowide::fopen(dst_path.c_str(), "wb") };
+    if (out.f == nullptr)
+        throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nCannot open file for writing.\n"));
+
+    try {
+        unsigned char file_header[FILE_HEADER_SIZE];
+        read_data(in.f, file_header, sizeof(file_header));
+        if (memcmp(file_header, MAGIC, sizeof(MAGIC)) != 0)
+            throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nNot a binary G-code file.\n"));
+        if (read_u32(file_header + 4) != VERSION)
+            throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nUnsupported version.\n"));
+        const EChecksumType checksum_type = EChecksumType(read_u16(file_header + 8));
+        if (checksum_type != EChecksumType::None && checksum_type != EChecksumType::CRC32)
+            throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nUnsupported checksum.\n"));
+
+        // The metadata and the thumbnails precede the G-code blocks, they are written as text once the first G-code block is reached.
+        MetadataItems          file_metadata;
+        MetadataItems          print_metadata;
+        MetadataItems          slicer_metadata;
+        std::vector<Thumbnail> thumbnails;
+        bool                   metadata_written = false;
+        auto                   write_metadata   = [&]() {
+            if (! metadata_written) {
+                const std::string text = metadata_to_gcode(file_metadata, print_metadata, slicer_metadata, thumbnails);
+                write_data(out.f, text.data(), text.size());
+                metadata_written = true;
+            }
+        };
+
+        std::string payload;
+        std::string data;
+        for (;;) {
+            unsigned char header[18];
+            const size_t  cnt_read = ::fread(header, 1, 8, in.f);
+            if (cnt_read == 0 && ::feof(in.f))
+                break;
+            if (cnt_read != 8)
+                throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nThe file is truncated or cannot be read.\n"));
+            const EBlockType       type              = EBlockType(read_u16(header));
+            const ECompressionType compression       = ECompressionType(read_u16(header + 2));
+            const uint32_t         uncompressed_size = read_u32(header + 4);
+            if (compression != ECompressionType::None && compression != ECompressionType::Deflate)
+                throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nUnsupported compression.\n"));
+            size_t header_size = 8;
+            uint32_t payload_size = uncompressed_size;
+            if (compression != ECompressionType::None) {
+                read_data(in.f, header + header_size, 4);
+                payload_size = read_u32(header + header_size);
+                header_size += 4;
+            }
+            const size_t params_size = type == EBlockType::Thumbnail ? 6 : 2;
+            read_data(in.f, header + header_size, params_size);
+            const unsigned char *params = header + header_size;
+            header_size += params_size;
+
+            payload.resize(payload_size);
+            read_data(in.f, payload.data(), payload.size());
+            if (checksum_type == EChecksumType::CRC32) {
+                unsigned char checksum[4];
+                read_data(in.f, checksum, sizeof(checksum));
+                mz_ulong crc = mz_crc32(MZ_CRC32_INIT, header, header_size);
+                crc = mz_crc32(crc, (const unsigned char*)payload.data(), payload.size());
+                if (uint32_t(crc) != read_u32(checksum))
+                    throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nChecksum mismatch, the file is corrupted.\n"));
+            }
+
+            if (compression == ECompressionType::Deflate) {
+                data.resize(uncompressed_size);
+                mz_ulong data_size = uncompressed_size;
+                if (mz_uncompress((unsigned char*)data.data(), &data_size, (const unsigned char*)payload.data(), mz_ulong(payload.size())) != MZ_OK || data_size != uncompressed_size)
+                    throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nDecompression error, the file is corrupted.\n"));
+            } else
+                data.swap(payload);
+
+            switch (type) {
+            case EBlockType::FileMetadata:   file_metadata   = metadata_from_ini(data); break;
+            case EBlockType::PrintMetadata:  print_metadata  = metadata_from_ini(data); break;
+            case EBlockType::SlicerMetadata: slicer_metadata = metadata_from_ini(data); break;
+            case EBlockType::Thumbnail:
+                thumbnails.push_back({ EThumbnailFormat(read_u16(params)), read_u16(params + 2), read_u16(params + 4), data });
+                break;
+            case EBlockType::GCode:
+                write_metadata();
+                write_data(out.f, data.data(), data.size());
+                break;
+            default:
+                // The printer metadata is derived from the slicer metadata.
+                break;
+            }
+        }
+        write_metadata();
+        if (::fflush(out.f) != 0 || ::ferror(out.f))
+            throw Slic3r::RuntimeError(std::string("Binary G-code import failed.\nIs the disk full?\n"));
+    } catch (...) {
+        out.close();
+        boost::nowide::remove(dst_path.c_str());
+        throw;
+    }
+}
+
+} // namespace BinaryGCode
+} // namespace Slic3r
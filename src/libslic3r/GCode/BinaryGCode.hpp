@@ -0,0 +1,79 @@
+#ifndef slic3r_GCode_BinaryGCode_hpp_
+#define slic3r_GCode_BinaryGCode_hpp_
+
+#include <cstdint>
+#include <string>
+
+namespace Slic3r {
+namespace BinaryGCode {
+
+// Binary G-code container, all the integers are stored little endian:
+//
+// File header:  magic "GCDE", uint32 version, uint16 checksum type
+// Block:        uint16 block type, uint16 compression, uint32 uncompressed size,
+//               uint32 compressed size (only if compressed),
+//               block parameters, block data,
+//               uint32 CRC32 of the header, parameters and data (only if the checksum type is CRC32)
+//
+// The block parameters are a uint16 encoding for all the blocks except for the thumbnails,
+// which store uint16 format, uint16 width and uint16 height.
+//
+// The blocks follow the order of the specification: the file metadata, the printer metadata, the thumbnails,
+// the print metadata, the slicer metadata and the G-code blocks, each of them holding whole lines of the text G-code.
+// The header block (print metadata), the configuration block (slicer metadata) and the thumbnails of the text G-code
+// are stored in their own blocks only, converting the file back to text regenerates them in front of the G-code.
+
+enum class EBlockType : uint16_t
+{
+    FileMetadata    = 0,
+    GCode           = 1,
+    SlicerMetadata  = 2,
+    PrinterMetadata = 3,
+    PrintMetadata   = 4,
+    Thumbnail       = 5,
+};
+
+enum class ECompressionType : uint16_t
+{
+    None    = 0,
+    // zlib stream (RFC 1950) compressed by miniz.
+    Deflate = 1,
+};
+
+enum class EChecksumType : uint16_t
+{
+    None  = 0,
+    CRC32 = 1,
+};
+
+enum class EThumbnailFormat : uint16_t
+{
+    PNG = 0,
+    JPG = 1,
+    QOI = 2,
+};
+
+// Encoding of the metadata blocks: "key=value" lines.
+static constexpr const uint16_t METADATA_ENCODING_INI = 0;
+// Encoding of the G-code blocks: plain text.
+static constexpr const uint16_t GCODE_ENCODING_NONE   = 0;
+
+// Returns true if the file starts with the binary G-code file header.
+bool is_binary_gcode_file(const std::string &path);
+
+// Converts the text G-code exported by GCode::do_export() into the binary container.
+// The file metadata, the printer metadata (a subset of the configuration read by the printers), the thumbnails,
+// the header block of the G-code (print metadata) and its configuration block (slicer metadata) are stored
+// as separate blocks, followed by the executable block of the G-code split into blocks of whole lines.
+// Throws Slic3r::RuntimeError on error.
+void convert_ascii_to_binary(const std::string &src_path, const std::string &dst_path, ECompressionType compression = ECompressionType::Deflate);
+
+// Writes a binary G-code file as text G-code: the header, configuration and thumbnail sections regenerated
+// from the metadata and the thumbnail blocks, followed by the content of the G-code blocks.
+// Throws Slic3r::RuntimeError on error or if the file is corrupted.
+void convert_binary_to_ascii(const std::string &src_path, const std::string &dst_path);
+
+} // namespace BinaryGCode
+} // namespace Slic3r
+
+#endif /* slic3r_GCode_BinaryGCode_hpp_ */
@@ -1,9 +1,9 @@
 #include "ConflictChecker.hpp"
 
 #include <tbb/parallel_for.h>
-#include <tbb/concurrent_vector.h>
 
-#include <map>
+#include <algorithm>
+#include <unordered_map>
 #include <functional>
 #include <atomic>
 
@@ -16,6 +16,11 @@ using Grids     = std::vector<IndexPair>;
 inline constexpr int64_t RasteXDistance = scale_(1);
 inline constexpr int64_t RasteYDistance = scale_(1);
 
+struct IndexPairHash
+{
+    size_t operator()(const IndexPair &idx) const { return std::hash<int64_t>()(idx.first * 73856093 ^ idx.second * 19349663); }
+};
+
 inline IndexPair point_map_grid_index(const Point &pt, int64_t xdist, int64_t ydist)
 {
     auto x = pt.x() / xdist;
@@ -142,6 +147,18 @@ LineWithIDs LinesBucketQueue::getCurLines() const
     return lines;
 }
 
+std::vector<LinesBucketRange> LinesBucketQueue::getCurRanges() const
+{
+    std::vector<LinesBucketRange> ranges;
+    for (const LinesBucket &bucket : line_buckets) {
+        if (bucket.valid()) {
+            auto [b, e] = bucket.curRange();
+            ranges.push_back({ &bucket, b, e });
+        }
+    }
+    return ranges;
+}
+
 void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths)
 {
     std::function<void(const ExtrusionEntityCollection *, ExtrusionPaths &)> getExtrusionPathImpl = [&](const ExtrusionEntityCollection *entity, ExtrusionPaths &paths) {
@@ -190,12 +207,16 @@ ObjectExtrusions getAllLayersExtrusionPathsFromObject(PrintObject *obj)
 {
     ObjectExtrusions oe;
 
-    for (auto layerPtr : obj->layers()) {
-        auto perimeters = getExtrusionPathsFromLayer(layerPtr->regions());
-        oe.perimeters.insert(oe.perimeters.end(), perimeters.begin(), perimeters.end());
-    }
+    std::vector<ExtrusionLayers> layers(obj->layers().size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layers.size()), [obj, &layers](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i) { layers[i] = getExtrusionPathsFromLayer(obj->get_layer(int(i))->regions()); }
+    });
+    for (ExtrusionLayers &perimeters : layers) { oe.perimeters.insert(oe.perimeters.end(), std::make_move_iterator(perimeters.begin()), std::make_move_iterator(perimeters.end())); }
 
-    for (auto supportLayerPtr : obj->support_layers()) { oe.support.push_back(getExtrusionPathsFromSupportLayer(supportLayerPtr)); }
+    oe.support.resize(obj->support_layers().size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, oe.support.size()), [obj, &oe](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i) { oe.support[i] = getExtrusionPathsFromSupportLayer(obj->support_layers()[i]); }
+    });
 
     return oe;
 }
@@ -203,7 +224,8 @@ ObjectExtrusions getAllLayersExtrusionPathsFromObject(PrintObject *obj)
 ConflictComputeOpt ConflictChecker::find_inter_of_lines(const LineWithIDs &lines)
 {
     using namespace RasterizationImpl;
-    std::map<IndexPair, std::vector<int>> indexToLine;
+    std::unordered_map<IndexPair, std::vector<int>, IndexPairHash> indexToLine;
+    indexToLine.reserve(lines.size());
 
     for (int i = 0; i < lines.size(); ++i) {
         const LineWithID &l1      = lines[i];
@@ -220,11 +242,44 @@ ConflictComputeOpt ConflictChecker::find_inter_of_lines(const LineWithIDs &lines
     return {};
 }
 
+LineWithIDs ConflictChecker::lines_of_overlapping_objs(const std::vector<LinesBucketRange> &ranges)
+{
+    std::vector<LineWithIDs> bucketLines(ranges.size());
+    std::vector<BoundingBox> bboxes(ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        bucketLines[i] = ranges[i].bucket->lines(ranges[i].begin, ranges[i].end);
+        for (const LineWithID &l : bucketLines[i]) {
+            bboxes[i].merge(l._line.a);
+            bboxes[i].merge(l._line.b);
+        }
+    }
+
+    LineWithIDs   lines;
+    BoundingBoxes others;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (bucketLines[i].empty()) continue;
+        others.clear();
+        for (size_t j = 0; j < ranges.size(); ++j) {
+            if (ranges[j].bucket->_id != ranges[i].bucket->_id && ! bucketLines[j].empty() && bboxes[i].overlap(bboxes[j])) { others.push_back(bboxes[j]); }
+        }
+        if (others.empty()) continue;
+        for (LineWithID &l : bucketLines[i]) {
+            BoundingBox bbox;
+            bbox.merge(l._line.a);
+            bbox.merge(l._line.b);
+            if (std::any_of(others.begin(), others.end(), [&bbox](const BoundingBox &other) { return bbox.overlap(other); })) { lines.push_back(std::move(l)); }
+        }
+    }
+    return lines;
+}
+
 ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(PrintObjectPtrs                      objs,
                                                                     std::optional<const FakeWipeTower *> wtdptr) // find the first intersection point of lines in different objects
 {
     if (objs.size() <= 1 && !wtdptr) { return {}; }
     LinesBucketQueue conflictQueue;
+    // The queue points to the buckets, thus the buckets must not be reallocated.
+    conflictQueue.line_buckets.reserve(2 * objs.size() + 1);
 
     if (wtdptr.has_value()) { // wipe tower at 0 by default
         //auto            wtpaths = wtdptr.value()->getFakeExtrusionPathsFromWipeTower();
@@ -245,32 +300,34 @@ ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(PrintObjectP
         conflictQueue.emplace_back_bucket(std::move(layers.support), obj, obj->instances().front().shift);
     }
 
-    std::vector<LineWithIDs> layersLines;
-    std::vector<float>       bottomZs;
+    // The sweep only records the piles of each layer, the lines are generated and checked in parallel.
+    std::vector<std::vector<LinesBucketRange>> layersRanges;
+    std::vector<float>                         bottomZs;
     while (conflictQueue.valid()) {
-        LineWithIDs lines = conflictQueue.getCurLines();
+        std::vector<LinesBucketRange> ranges = conflictQueue.getCurRanges();
         float curBottomZ = conflictQueue.getCurrBottomZ();
         bottomZs.push_back(curBottomZ);
-        layersLines.push_back(std::move(lines));
+        layersRanges.push_back(std::move(ranges));
     }
 
-    bool                                                          find = false;
-    tbb::concurrent_vector<std::pair<ConflictComputeResult, float>> conflict;
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersLines.size()), [&](tbb::blocked_range<size_t> range) {
-        for (size_t i = range.begin(); i < range.end(); i++) {
-            auto interRes = find_inter_of_lines(layersLines[i]);
+    // Report the lowest conflicting layer, layers above an already found conflict are skipped.
+    std::vector<ConflictComputeOpt> layersConflicts(layersRanges.size());
+    std::atomic<size_t>             firstConflictLayer(layersRanges.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersRanges.size()), [&](tbb::blocked_range<size_t> range) {
+        for (size_t i = range.begin(); i < range.end() && i < firstConflictLayer.load(std::memory_order_relaxed); i++) {
+            auto interRes = find_inter_of_lines(lines_of_overlapping_objs(layersRanges[i]));
             if (interRes.has_value()) {
-                find = true;
-                conflict.emplace_back(interRes.value(), bottomZs[i]);
+                layersConflicts[i] = interRes;
+                for (size_t first = firstConflictLayer.load(); i < first && ! firstConflictLayer.compare_exchange_weak(first, i);) {}
                 break;
             }
         }
     });
 
-    if (find) {
-        const void *ptr1           = conflict[0].first._obj1;
-        const void *ptr2           = conflict[0].first._obj2;
-        float       conflictPrintZ = conflict[0].second;
+    if (size_t i = firstConflictLayer.load(); i < layersRanges.size()) {
+        const void *ptr1           = layersConflicts[i]->_obj1;
+        const void *ptr2           = layersConflicts[i]->_obj2;
+        float       conflictPrintZ = bottomZs[i];
         if (wtdptr.has_value()) {
             const FakeWipeTower *wtdp = wtdptr.value();
             if (ptr1 == wtdp || ptr2 == wtdp) {
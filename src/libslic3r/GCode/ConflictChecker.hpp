@@ -83,6 +83,11 @@ public:
     LineWithIDs curLines() const
     {
         auto [b, e] = curRange();
+        return lines(b, e);
+    }
+    // Lines of the piles [b, e), translated by the object offset.
+    LineWithIDs lines(int b, int e) const
+    {
         LineWithIDs lines;
         for (int i = b; i < e; ++i) {
             for (const ExtrusionPath &path : _piles[i].paths) {
@@ -102,6 +107,14 @@ public:
     friend bool operator==(const LinesBucket &left, const LinesBucket &right) { return left._curBottomZ == right._curBottomZ; }
 };
 
+// Piles of a bucket at the current position of the LinesBucketQueue sweep.
+struct LinesBucketRange
+{
+    const LinesBucket *bucket;
+    int                begin;
+    int                end;
+};
+
 struct LinesBucketPtrComp
 {
     bool operator()(const LinesBucket *left, const LinesBucket *right) { return *left > *right; }
@@ -118,6 +131,8 @@ public:
     bool        valid() const { return line_bucket_ptr_queue.empty() == false; }
     float       getCurrBottomZ();
     LineWithIDs getCurLines() const;
+    // Same piles as getCurLines(), without generating the lines.
+    std::vector<LinesBucketRange> getCurRanges() const;
 };
 
 void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths);
@@ -145,6 +160,8 @@ struct ConflictChecker
 {
     static ConflictResultOpt  find_inter_of_lines_in_diff_objs(PrintObjectPtrs objs, std::optional<const FakeWipeTower *> wtdptr);
     static ConflictComputeOpt find_inter_of_lines(const LineWithIDs &lines);
+    // Lines of the piles, only those whose bounding box overlaps the bounding box of another object in the same layer.
+    static LineWithIDs        lines_of_overlapping_objs(const std::vector<LinesBucketRange> &ranges);
     static ConflictComputeOpt line_intersect(const LineWithID &l1, const LineWithID &l2);
 };
 
@@ -10,7 +10,8 @@ class CoolingBuffer
 public:
     CoolingBuffer(){};
 
-    float calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    // Only modifies per_extruder_adjustments, thus it may be called for several layers in parallel.
+    float calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments) const;
 
 private:
     // Old logic: proportional.
@@ -256,6 +256,36 @@ public:
     // Returns the adjusted G-code.
     std::string write_layer_gcode(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
+    // State of process_layer() and of write_layer_gcode(), saved and restored by the incremental G-code export
+    // to resume the export at a layer, see GCodeLayerCache. The two parts are saved by different stages of the pipeline.
+    // Only saved after a layer, which flushed the G-code of the preceding support layers.
+    struct ParseState
+    {
+        std::vector<float> current_pos;
+        unsigned int       parse_gcode_extruder;
+    };
+    struct WriteState
+    {
+        int                fan_speed;
+        int                additional_fan_speed;
+        unsigned int       current_extruder;
+        int                current_fan_speed;
+        bool               set_fan_changing_layer;
+        bool               set_addition_fan_changing_layer;
+    };
+    ParseState  get_parse_state() const { assert(m_gcode.empty()); return { m_current_pos, m_parse_gcode_extruder }; }
+    void        set_parse_state(const ParseState &state) { m_gcode.clear(); m_current_pos = state.current_pos; m_parse_gcode_extruder = state.parse_gcode_extruder; }
+    WriteState  get_write_state() const
+        { return { m_fan_speed, m_additional_fan_speed, m_current_extruder, m_current_fan_speed, m_set_fan_changing_layer, m_set_addition_fan_changing_layer }; }
+    void        set_write_state(const WriteState &state) {
+        m_fan_speed                       = state.fan_speed;
+        m_additional_fan_speed            = state.additional_fan_speed;
+        m_current_extruder                = state.current_extruder;
+        m_current_fan_speed               = state.current_fan_speed;
+        m_set_fan_changing_layer          = state.set_fan_changing_layer;
+        m_set_addition_fan_changing_layer = state.set_addition_fan_changing_layer;
+    }
+
 private :
 	GCodeEditor& operator=(const GCodeEditor&) = delete;
     std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &                       gcode,
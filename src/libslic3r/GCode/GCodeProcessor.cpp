@@ -4,12 +4,14 @@
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
 #include "GCodeProcessor.hpp"
+#include "BinaryGCode.hpp"
 
 #include <boost/log/trivial.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include <fast_float/fast_float.h>
@@ -541,11 +543,6 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
     std::string filename_in = filename;
     std::string filename_out = filename + ".postprocess";
 
-    FilePtr out{ boost::nowide::fopen(filename_out.c_str(), "wb+") };
-    if (out.f == nullptr) {
-        throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
-    }
-
     auto time_in_minutes = [](float time_in_seconds) {
         assert(time_in_seconds >= 0.f);
         return int((time_in_seconds + 0.5f) / 60.0f);
@@ -622,6 +619,11 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
         last_exported_stop[i] = time_in_minutes(machines[i].time);
     }
 
+    // The G-code is read twice, but written only once: the first pass only collects the line ids of the tags and the filament / extruder
+    // usage blocks, the second pass replays the same M73 and placeholder processing while writing the final G-code.
+    // Set to false during the second pass, so that the collected data is not modified.
+    bool collect_blocks = true;
+
     // replace placeholder lines with the proper final value
     // gcode_line is in/out parameter, to reduce expensive memory allocation
     auto process_placeholders = [&](std::string& gcode_line, int line_id) {
@@ -734,17 +736,17 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
                 }
                 ret += format_filament_used_info("total filament length [mm]", total_length_per_extruder);
             }
-            else if (line == reserved_tag(ETags::MachineStartGCodeEnd)) {
+            else if (collect_blocks && line == reserved_tag(ETags::MachineStartGCodeEnd)) {
                 machine_start_gcode_end_line_id = line_id;
             }
-            else if (line == reserved_tag(ETags::MachineEndGCodeStart)) {
+            else if (collect_blocks && line == reserved_tag(ETags::MachineEndGCodeStart)) {
                 machine_end_gcode_start_line_id = line_id;
             }
-            else if (line == custom_tags(CustomETags::SKIPPABLE_START)){
+            else if (collect_blocks && line == custom_tags(CustomETags::SKIPPABLE_START)){
                 skippable_blocks.emplace_back(0,0);
                 skippable_blocks.back().first = line_id;
             }
-            else if (line == custom_tags(CustomETags::SKIPPABLE_END)){
+            else if (collect_blocks && line == custom_tags(CustomETags::SKIPPABLE_END)){
                 skippable_blocks.back().second = line_id;
             }
         }
@@ -869,7 +871,7 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
 
     /*
         Read the file according to the buffer block size, read one line of gcode from the buffer each time and process it.
-        Write to a new file when the buffer is full.
+        Write to a new file when the buffer is full. If out is not open, the processed lines are discarded.
         The callback function accepts the gcode content, line number, and buffer content
     */
     auto gcode_process = [&write_string](FilePtr& in, FilePtr& out, const std::string& filename_in, const std::string& filename_out, const std::function<void(std::string&, std::string&, int& line_id)>& gcode_line_handler, std::vector<size_t>* line_ends = nullptr, int buffer_size_in_kB = 64) {
@@ -900,8 +902,12 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
                     gcode_line += "\n";
                     gcode_line_handler(gcode_line, export_line, line_id);
                     export_line += gcode_line;
-                    if (export_line.length() >= buffer_size_in_kB * 1024)
-                        write_string(filename_out, out, export_line, out_file_pos, line_ends);
+                    if (export_line.length() >= buffer_size_in_kB * 1024) {
+                        if (out.f != nullptr)
+                            write_string(filename_out, out, export_line, out_file_pos, line_ends);
+                        else
+                            export_line.clear();
+                    }
                     gcode_line.clear();
                 }
                 // Skip EOL.
@@ -914,7 +920,7 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
             if (eof)
                 break;
         }
-        if (!export_line.empty())
+        if (!export_line.empty() && out.f != nullptr)
             write_string(filename_out, out, export_line, out_file_pos, line_ends);
         };
 
@@ -1014,8 +1020,11 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
         }
         };
 
-    // we don't need to get line ends here because it's not the final end
-    gcode_process(in, out, filename_in, filename_out, gcode_time_handler, nullptr, buffer_size_in_KB);
+    // first pass: nothing is written, the M73 lines and placeholders are only counted to know the line ids of the final G-code
+    {
+        FilePtr no_out{ nullptr };
+        gcode_process(in, no_out, filename_in, filename_out, gcode_time_handler, nullptr, buffer_size_in_KB);
+    }
 
     // updates moves' gcode ids which have been modified by the insertion of the M73 lines
     handle_offsets_of_first_process(offsets, moves, filament_blocks, extruder_blocks, skippable_blocks, machine_start_gcode_end_line_id, machine_end_gcode_start_line_id);
@@ -1114,63 +1123,96 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
         pre_cooling_injector->process_pre_cooling_and_heating(inserted_operation_lines);
     }
 
+    // Restore the state of the M73 export, the second pass has to produce exactly the lines counted by the first pass.
+    collect_blocks = false;
+    g1_lines_counter = 0;
+    for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+        last_exported_main[i] = { 0, time_in_minutes(machines[i].time) };
+        last_exported_stop[i] = time_in_minutes(machines[i].time);
+        g1_times_cache_it[i] = machines[i].g1_times_cache.begin();
+    }
+
     auto pre_operation_iter = inserted_operation_lines.begin();
-    auto filament_change_handle = [&inserted_operation_lines, &pre_operation_iter,enable_pre_heating = context.enable_pre_heating](std::string& gcode_line, std::string& gcode_buffer, int line_id) {
-        if (pre_operation_iter == inserted_operation_lines.end())
+    // Appends the pre-cooling / pre-heating and filament change lines after the line with the given id,
+    // the ids being the ones of the G-code with the M73 lines and placeholders already expanded.
+    auto append_operation_lines = [&inserted_operation_lines, &pre_operation_iter, enable_pre_heating = context.enable_pre_heating](std::string& gcode_lines, int line_id) {
+        if (pre_operation_iter == inserted_operation_lines.end() || line_id != pre_operation_iter->first)
             return;
-        if (line_id == pre_operation_iter->first) {
-            for (auto& elem : pre_operation_iter->second) {
-                const std::string& str = elem.first;
-                const InsertLineType type = elem.second;
-                switch (type)
+        for (auto& elem : pre_operation_iter->second) {
+            const std::string& str = elem.first;
+            const InsertLineType type = elem.second;
+            switch (type)
+            {
+                case InsertLineType::PlaceholderReplace:
+                case InsertLineType::TimePredict: break;  // these types above has been handled before
+                case InsertLineType::PreCooling:
+                case InsertLineType::PreHeating:
                 {
-                    case InsertLineType::PlaceholderReplace:
-                    case InsertLineType::TimePredict: break;  // these types above has been handled before
-                    case InsertLineType::PreCooling:
-                    case InsertLineType::PreHeating:
-                    {
-                        if (enable_pre_heating)
-                            gcode_line += str;
-                        break;
-                    }
-                    case InsertLineType::ExtruderChangePredict: break;
-                    case InsertLineType::FilamentChangePredict:
-                    {
-                        gcode_line += str;
-                        break;
-                    }
-                    default:
-                        break;
+                    if (enable_pre_heating)
+                        gcode_lines += str;
+                    break;
                 }
+                case InsertLineType::ExtruderChangePredict: break;
+                case InsertLineType::FilamentChangePredict:
+                {
+                    gcode_lines += str;
+                    break;
+                }
+                default:
+                    break;
             }
-            ++pre_operation_iter;
         }
+        ++pre_operation_iter;
     };
 
-    filename_in = filename_out; // filename_out is opened in read|write mode. During second process ,we ues filename_out as input
-    filename_out = filename + ".postprocessed";
-    std::string filename_in_safe = PathSanitizer::sanitize(filename_in);
-    std::string filename_out_safe = PathSanitizer::sanitize(filename_out);
+    // id of the last line produced by the M73 and placeholder processing
+    int expanded_line_id = 0;
+    std::string expanded_lines;
+    auto gcode_export_handler = [&](std::string& gcode_line, std::string& gcode_buffer, int line_id) {
+        expanded_lines.clear();
+        auto [processed, lines_added_count] = process_placeholders(gcode_line, line_id);
+        if (!processed && !is_temporary_decoration(gcode_line) &&
+            (GCodeReader::GCodeLine::cmd_is(gcode_line, "G1") ||
+             GCodeReader::GCodeLine::cmd_is(gcode_line, "G2") ||
+             GCodeReader::GCodeLine::cmd_is(gcode_line, "G3") ||
+             GCodeReader::GCodeLine::cmd_start_with(gcode_line, ";VG1")))
+            process_line_move(expanded_lines, g1_lines_counter++);
+        expanded_lines += gcode_line;
+
+        const int lines_count = int(std::count(expanded_lines.begin(), expanded_lines.end(), '\n'));
+        if (pre_operation_iter == inserted_operation_lines.end() || pre_operation_iter->first > expanded_line_id + lines_count) {
+            // fast path, nothing to insert after these lines
+            expanded_line_id += lines_count;
+            gcode_buffer += expanded_lines;
+            gcode_line.clear();
+            return;
+        }
+        gcode_line.clear();
+        for (size_t begin = 0; begin < expanded_lines.size();) {
+            size_t end = expanded_lines.find('\n', begin) + 1;
+            gcode_line.append(expanded_lines, begin, end - begin);
+            append_operation_lines(gcode_line, ++ expanded_line_id);
+            begin = end;
+        }
+    };
 
-    FilePtr new_out = boost::nowide::fopen(filename_out.c_str(), "wb");
-    std::fseek(out.f, 0, SEEK_SET); // move to start of the file and start reading gcode as in
+    FilePtr out{ boost::nowide::fopen(filename_out.c_str(), "wb") };
+    if (out.f == nullptr) {
+        throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
+    }
+    std::fseek(in.f, 0, SEEK_SET); // move to start of the file and write the final gcode in a single pass
 
-    gcode_process(out, new_out, filename_in, filename_out, filament_change_handle, &lines_ends, buffer_size_in_KB);
-    new_out.close();
+    gcode_process(in, out, filename_in, filename_out, gcode_export_handler, &lines_ends, buffer_size_in_KB);
+    out.close();
 
     // recollect gcode offset caused by inserted operations
     handle_offsets_of_second_process(inserted_operation_lines, moves);
 
     in.close();
-    out.close();
 
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  after process %1%") % filename_safe;
 
-    if (boost::nowide::remove(filename_in.c_str()) != 0) {
-        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  Failed to remove the temporary G-code file %1%") % filename_in_safe;
-        throw Slic3r::RuntimeError(std::string("Failed to remove the temporary G-code file ") + filename_in_safe + '\n' +
-            "Is " + filename_in_safe + " locked?" + '\n');
-    }
+    std::string filename_out_safe = PathSanitizer::sanitize(filename_out);
     if (rename_file(filename_out, filename)) {
         BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  Failed to rename the output G-code file from %1% to %2%") % filename_out_safe % filename_safe;
         throw Slic3r::RuntimeError(std::string("Failed to rename the output G-code file from ") + filename_out_safe + " to " + filename_safe + '\n' +
@@ -1405,6 +1447,7 @@ void GCodeProcessorResult::reset() {
     lock();
 
     moves = std::vector<GCodeProcessorResult::MoveVertex>();
+    temporary_filename.reset();
     printable_area = Pointfs();
     //BBS: add bed exclude area
     bed_exclude_area = Pointfs();
@@ -1433,6 +1476,7 @@ void GCodeProcessorResult::reset() {
 
     moves.clear();
     lines_ends.clear();
+    temporary_filename.reset();
     printable_area = Pointfs();
     //BBS: add bed exclude area
     bed_exclude_area = Pointfs();
@@ -1487,7 +1531,7 @@ bool GCodeProcessor::contains_reserved_tag(const std::string& gcode, std::string
 
     GCodeReader parser;
     parser.parse_buffer(gcode, [&ret, &found_tag](GCodeReader& parser, const GCodeReader::GCodeLine& line) {
-        std::string comment = line.raw();
+        std::string comment(line.raw());
         if (comment.length() > 2 && comment.front() == ';') {
             comment = comment.substr(1);
             for (const std::string& s : ReservedTags) {
@@ -1514,7 +1558,7 @@ bool GCodeProcessor::contains_reserved_tags(const std::string& gcode, unsigned i
 
     GCodeReader parser;
     parser.parse_buffer(gcode, [&ret, &found_tag, max_count](GCodeReader& parser, const GCodeReader::GCodeLine& line) {
-        std::string comment = line.raw();
+        std::string comment(line.raw());
         if (comment.length() > 2 && comment.front() == ';') {
             comment = comment.substr(1);
             for (const std::string& s : ReservedTags) {
@@ -2293,6 +2337,23 @@ DynamicConfig GCodeProcessor::export_config_for_render() const
 // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
 void GCodeProcessor::process_file(const std::string& filename, std::function<void()> cancel_callback)
 {
+    if (BinaryGCode::is_binary_gcode_file(filename)) {
+        // Expand the binary G-code into a uniquely named temporary text file, which is then parsed and kept around
+        // for the G-code viewer as long as the result refers to it.
+        boost::filesystem::path dir = temporary_dir().empty() ? boost::filesystem::temp_directory_path() : boost::filesystem::path(temporary_dir());
+        auto text_filename = std::shared_ptr<const std::string>(
+            new std::string((dir / boost::filesystem::unique_path(boost::filesystem::path(filename).stem().string() + "-%%%%-%%%%-%%%%.gcode")).string()),
+            [](const std::string *path) {
+                boost::system::error_code ec;
+                boost::filesystem::remove(*path, ec);
+                delete path;
+            });
+        BinaryGCode::convert_binary_to_ascii(filename, *text_filename);
+        this->process_file(*text_filename, cancel_callback);
+        m_result.temporary_filename = std::move(text_filename);
+        return;
+    }
+
     CNumericLocalesSetter locales_setter;
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -2351,7 +2412,7 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     // 1st move must be a dummy move
     m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
     size_t parse_line_callback_cntr = 10000;
-    m_parser.parse_file(filename, [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
+    auto process_line = [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (-- parse_line_callback_cntr == 0) {
             // Don't call the cancel_callback() too often, do it every at every 10000'th line.
             parse_line_callback_cntr = 10000;
@@ -2359,7 +2420,11 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
                 cancel_callback();
         }
         this->process_gcode_line(line, true);
-    }, m_result.lines_ends);
+    };
+    if (m_parallel_parsing)
+        m_parser.parse_file_parallel(filename, process_line, m_result.lines_ends);
+    else
+        m_parser.parse_file(filename, process_line, m_result.lines_ends);
 
     // Don't post-process the G-code to update time stamps.
     this->finalize(false);
@@ -2671,10 +2736,10 @@ void GCodeProcessor::process_gcode_line(const GCodeReader::GCodeLine& line, bool
         m_command_processor.process_comand(cmd, line);
     }
     else {
-        const std::string &comment = line.raw();
+        const std::string_view comment = line.raw();
         if (comment.length() > 2 && comment.front() == ';')
         {
-            std::string comment_content = comment.substr(1); // only format like ";V{cmd}" is valid
+            std::string comment_content(comment.substr(1)); // only format like ";V{cmd}" is valid
             if (comment_content[0] == 'V' || comment_content[0] == 'v') {
                 GCodeReader reader;
                 GCodeReader::GCodeLine new_line;
@@ -4993,7 +5058,7 @@ void GCodeProcessor::process_M108(const GCodeReader::GCodeLine& line)
     if (m_flavor != gcfSailfish)
         return;
 
-    std::string cmd = line.raw();
+    std::string cmd(line.raw());
     size_t pos = cmd.find("T");
     if (pos != std::string::npos)
         process_T(cmd.substr(pos));
@@ -5048,7 +5113,7 @@ void GCodeProcessor::process_M135(const GCodeReader::GCodeLine& line)
     if (m_flavor != gcfMakerWare)
         return;
 
-    std::string cmd = line.raw();
+    std::string cmd(line.raw());
     size_t pos = cmd.find("T");
     if (pos != std::string::npos)
         process_T(cmd.substr(pos));
@@ -5190,10 +5255,11 @@ void GCodeProcessor::process_M205(const GCodeReader::GCodeLine& line)
 
 void GCodeProcessor::process_SET_VELOCITY_LIMIT(const GCodeReader::GCodeLine& line)
 {
+    const std::string raw(line.raw());
     // handle SQUARE_CORNER_VELOCITY
     std::regex pattern("\\sSQUARE_CORNER_VELOCITY\\s*=\\s*([0-9]*\\.*[0-9]*)");
     std::smatch matches;
-    if (std::regex_search(line.raw(), matches, pattern) && matches.size() == 2) {
+    if (std::regex_search(raw, matches, pattern) && matches.size() == 2) {
         float _jerk = 0;
         try
         {
@@ -5207,7 +5273,7 @@ void GCodeProcessor::process_SET_VELOCITY_LIMIT(const GCodeReader::GCodeLine& li
     }
 
     pattern = std::regex("\\sACCEL\\s*=\\s*([0-9]*\\.*[0-9]*)");
-    if (std::regex_search(line.raw(), matches, pattern) && matches.size() == 2) {
+    if (std::regex_search(raw, matches, pattern) && matches.size() == 2) {
         float _accl = 0;
         try
         {
@@ -5221,7 +5287,7 @@ void GCodeProcessor::process_SET_VELOCITY_LIMIT(const GCodeReader::GCodeLine& li
     }
 
     pattern = std::regex("\\sVELOCITY\\s*=\\s*([0-9]*\\.*[0-9]*)");
-    if (std::regex_search(line.raw(), matches, pattern) && matches.size() == 2) {
+    if (std::regex_search(raw, matches, pattern) && matches.size() == 2) {
         float _speed = 0;
         try
         {
@@ -5368,7 +5434,7 @@ void GCodeProcessor::process_M1020(const GCodeReader::GCodeLine &line)
     int curr_filament_id = get_filament_id(false);
     int curr_extruder_id = get_extruder_id(false);
     if (line.raw().length() > 5) {
-        std::string filament_id_str = line.raw().substr(7);
+        std::string filament_id_str(line.raw().substr(7));
         if (filament_id_str.empty())
             return;
 
@@ -5520,8 +5586,8 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
         ((type == EMoveType::Seam) ? m_last_line_id : m_line_id);
 
     //BBS: apply plate's and extruder's offset to arc interpolation points
-    if (path_type == EMovePathType::Arc_move_cw ||
-        path_type == EMovePathType::Arc_move_ccw) {
+    const bool is_arc_move = path_type == EMovePathType::Arc_move_cw || path_type == EMovePathType::Arc_move_ccw;
+    if (is_arc_move) {
         for (size_t i = 0; i < m_interpolation_points.size(); i++)
             m_interpolation_points[i] =
                 Vec3f(m_interpolation_points[i].x() + m_x_offset,
@@ -5549,8 +5615,8 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
         {0.f,0.f}, // prefix sum of move time to this move : set later
         //BBS: add plate's offset to the rendering vertices
         Vec3f(m_end_position[X] + m_x_offset, m_end_position[Y] + m_y_offset, m_processing_start_custom_gcode ? m_first_layer_height : m_end_position[Z]) + m_extruder_offsets[filament_id],
-        Vec3f(m_arc_center(0, 0) + m_x_offset, m_arc_center(1, 0) + m_y_offset, m_arc_center(2, 0)) + m_extruder_offsets[filament_id],
-        m_interpolation_points,
+        // m_interpolation_points keep the points of the last arc, store them with arc moves only.
+        is_arc_move ? GCodeProcessorResult::ArcInterpolationPoints(m_interpolation_points) : GCodeProcessorResult::ArcInterpolationPoints(),
         m_object_label_id,
         m_print_z
     });
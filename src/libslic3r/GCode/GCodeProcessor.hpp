@@ -10,6 +10,8 @@
 
 #include <cstdint>
 #include <array>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <mutex>
 #include <string>
@@ -185,6 +187,62 @@ namespace Slic3r {
             }
         };
 
+        // Interpolation points of an arc move. Most of the moves are not arcs, thus the points are stored
+        // in a single heap block referenced by one pointer, with the number of points stored in front of them,
+        // instead of a std::vector taking three pointers per move.
+        class ArcInterpolationPoints
+        {
+        public:
+            ArcInterpolationPoints() = default;
+            ArcInterpolationPoints(const std::vector<Vec3f> &points) { this->assign(points.data(), points.data() + points.size()); }
+            ArcInterpolationPoints(const ArcInterpolationPoints &rhs) { this->assign(rhs.begin(), rhs.end()); }
+            ArcInterpolationPoints(ArcInterpolationPoints &&rhs) noexcept : m_block(rhs.m_block) { rhs.m_block = nullptr; }
+            ~ArcInterpolationPoints() { this->clear(); }
+
+            ArcInterpolationPoints& operator=(const ArcInterpolationPoints &rhs) {
+                if (this != &rhs)
+                    this->assign(rhs.begin(), rhs.end());
+                return *this;
+            }
+            ArcInterpolationPoints& operator=(ArcInterpolationPoints &&rhs) noexcept { std::swap(m_block, rhs.m_block); return *this; }
+
+            size_t       size()  const { return m_block ? m_block->size : 0; }
+            bool         empty() const { return m_block == nullptr; }
+            const Vec3f* begin() const { return m_block ? m_block->points() : nullptr; }
+            const Vec3f* end()   const { return m_block ? m_block->points() + m_block->size : nullptr; }
+            const Vec3f& operator[](size_t idx) const { assert(idx < this->size()); return m_block->points()[idx]; }
+
+            void clear() {
+                if (m_block != nullptr) {
+                    ::operator delete(m_block);
+                    m_block = nullptr;
+                }
+            }
+
+        private:
+            struct Block {
+                size_t       size;
+                Vec3f*       points()       { return reinterpret_cast<Vec3f*>(this + 1); }
+                const Vec3f* points() const { return reinterpret_cast<const Vec3f*>(this + 1); }
+            };
+            static_assert(std::is_trivially_destructible_v<Vec3f>);
+            static_assert(sizeof(Block) % alignof(Vec3f) == 0);
+
+            void assign(const Vec3f *begin, const Vec3f *end) {
+                this->clear();
+                if (begin != end) {
+                    size_t size = end - begin;
+                    m_block = static_cast<Block*>(::operator new(sizeof(Block) + size * sizeof(Vec3f)));
+                    m_block->size = size;
+                    std::uninitialized_copy(begin, end, m_block->points());
+                }
+            }
+
+            Block *m_block { nullptr };
+        };
+
+        // There may be tens of millions of moves, keep the vertex small: the one byte fields share a single word
+        // and the arc interpolation points take a single pointer.
         struct MoveVertex
         {
             EMoveType type{ EMoveType::Noop };
@@ -207,8 +265,7 @@ namespace Slic3r {
             std::array<float, 2>time{ 0.f,0.f }; // prefix sum of time, assigned during finalize()
 
             Vec3f position{ Vec3f::Zero() }; // mm
-            Vec3f arc_center_position{ Vec3f::Zero() };      // mm
-            std::vector<Vec3f> interpolation_points;     // interpolation points of arc for drawing
+            ArcInterpolationPoints interpolation_points;     // interpolation points of arc for drawing, empty for other moves
             int  object_label_id{-1};
             float print_z{0.0f};
 
@@ -221,6 +278,7 @@ namespace Slic3r {
                 return move_path_type == EMovePathType::Arc_move_ccw || move_path_type == EMovePathType::Arc_move_cw;
             }
         };
+        static_assert(sizeof(void*) != 8 || sizeof(MoveVertex) == 80, "GCodeProcessorResult::MoveVertex grew");
 
         struct SliceWarning {
             int         level;                  // 0: normal tips, 1: warning; 2: error
@@ -229,7 +287,10 @@ namespace Slic3r {
             std::vector<std::string> params;    // extra msg info
         };
 
+        // The G-code viewer maps this file by lines_ends, thus for a binary G-code it is the text G-code expanded from it.
         std::string filename;
+        // Text G-code expanded from a binary G-code, removed once the last copy of this result releases it.
+        std::shared_ptr<const std::string> temporary_filename;
         unsigned int id;
         std::vector<MoveVertex> moves;
         // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
@@ -282,6 +343,7 @@ namespace Slic3r {
         GCodeProcessorResult& operator=(const GCodeProcessorResult &other)
         {
             filename = other.filename;
+            temporary_filename = other.temporary_filename;
             id = other.id;
             moves = other.moves;
             lines_ends = other.lines_ends;
@@ -1067,6 +1129,7 @@ namespace Slic3r {
         bool m_detect_layer_based_on_tag {false};
         int m_seams_count;
         bool m_measure_g29_time {false};
+        bool m_parallel_parsing {false};
 #if ENABLE_GCODE_VIEWER_STATISTICS
         std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
@@ -1118,6 +1181,9 @@ namespace Slic3r {
             return m_time_processor.machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Stealth)].enabled;
         }
         void enable_machine_envelope_processing(bool enabled) { m_time_processor.machine_envelope_processing_enabled = enabled; }
+        // Tokenize the G-code file in parallel chunks in process_file(), the lines are still processed serially in order,
+        // thus the result is the same as with the serial parser.
+        void enable_parallel_parsing(bool enabled) { m_parallel_parsing = enabled; }
         void reset();
 
         const GCodeProcessorResult& get_result() const { return m_result; }
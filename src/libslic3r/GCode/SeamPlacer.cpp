@@ -4,6 +4,7 @@
 #include "tbb/blocked_range.h"
 #include "tbb/parallel_reduce.h"
 #include <boost/log/trivial.hpp>
+#include <boost/functional/hash.hpp>
 #include <random>
 #include <algorithm>
 #include <queue>
@@ -15,6 +16,7 @@
 #include "libslic3r/BoundingBox.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/RayPacketBVH.hpp"
 
 #include "libslic3r/Geometry/Curves.hpp"
 #include "libslic3r/ShortEdgeCollapse.hpp"
@@ -132,10 +134,10 @@ Vec3f sample_power_cosine_hemisphere(const Vec2f &samples, float power)
     return Vec3f(cos(term1) * term3, sin(term1) * term3, term2);
 }
 
-std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &raycasting_tree,
-                                      const indexed_triangle_set &            triangles,
-                                      const TriangleSetSamples &              samples,
-                                      size_t                                  negative_volumes_start_index)
+std::vector<float> raycast_visibility(const RayPacketBVH &        raycasting_bvh,
+                                      const indexed_triangle_set &triangles,
+                                      const TriangleSetSamples &  samples,
+                                      size_t                      negative_volumes_start_index)
 {
     BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: raycast visibility of " << samples.positions.size() << " samples over " << triangles.indices.size() << " triangles: end";
 
@@ -155,12 +157,47 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
 
     std::vector<float> result(samples.positions.size());
     tbb::parallel_for(tbb::blocked_range<size_t>(0, result.size()), [&triangles, &precomputed_sample_directions, model_contains_negative_parts, negative_volumes_start_index,
-                                                                     &raycasting_tree, &result, &samples](tbb::blocked_range<size_t> r) {
+                                                                     &raycasting_bvh, &result, &samples](tbb::blocked_range<size_t> r) {
+        constexpr float decrease_step = 1.0f / (SeamPlacer::sqr_rays_per_sample_point * SeamPlacer::sqr_rays_per_sample_point);
+        // The rays of consecutive samples are traced in packets, thus most rays of a packet share their origin.
+        RayPacketBVH::Packet packet;
+        // Sample casting each ray of the packet.
+        size_t packet_samples[RayPacketBVH::PacketSize];
+        int    first_hit_ids[RayPacketBVH::PacketSize];
+        float  first_hit_ts[RayPacketBVH::PacketSize];
         // Maintaining hits memory outside of the loop, so it does not have to be reallocated for each query.
-        std::vector<igl::Hit> hits;
+        std::vector<RayPacketBVH::Hit> hits;
+
+        auto trace_packet = [&]() {
+            if (!model_contains_negative_parts) {
+                raycasting_bvh.first_hits(packet, first_hit_ids, first_hit_ts);
+                for (size_t ray = 0; ray < packet.size; ++ray)
+                    if (first_hit_ids[ray] != -1 && its_face_normal(triangles, first_hit_ids[ray]).dot(packet.ray_dir(ray)) <= 0)
+                        result[packet_samples[ray]] -= decrease_step;
+            } else { // TODO improve logic for order based boolean operations - consider order of volumes
+                hits.clear();
+                raycasting_bvh.all_hits(packet, hits);
+                int  counters[RayPacketBVH::PacketSize] = {};
+                bool some_hit[RayPacketBVH::PacketSize] = {};
+                // NOTE: The order of the hits does not matter, the counter is zero if the ray leaves the model as many times as it enters it.
+                // The ray ends outside of the model and outside of the negative volumes.
+                for (const RayPacketBVH::Hit &hit : hits) {
+                    Vec3f face_normal = its_face_normal(triangles, hit.id);
+                    if (hit.id >= int(negative_volumes_start_index)) { // negative volume hit
+                        counters[hit.ray] -= sgn(face_normal.dot(packet.ray_dir(hit.ray))); // if volume face aligns with ray dir, we are leaving negative space
+                    } else {
+                        counters[hit.ray] += sgn(face_normal.dot(packet.ray_dir(hit.ray)));
+                    }
+                    some_hit[hit.ray] = true;
+                }
+                for (size_t ray = 0; ray < packet.size; ++ray)
+                    if (some_hit[ray] && counters[ray] == 0) { result[packet_samples[ray]] -= decrease_step; }
+            }
+            packet.clear();
+        };
+
         for (size_t s_idx = r.begin(); s_idx < r.end(); ++s_idx) {
-            result[s_idx]                 = 1.0f;
-            constexpr float decrease_step = 1.0f / (SeamPlacer::sqr_rays_per_sample_point * SeamPlacer::sqr_rays_per_sample_point);
+            result[s_idx] = 1.0f;
 
             const Vec3f &center = samples.positions[s_idx];
             const Vec3f &normal = samples.normals[s_idx];
@@ -168,44 +205,21 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
             Frame f;
             f.set_from_z(normal);
 
+            bool  casting_from_negative_volume = model_contains_negative_parts && samples.triangle_indices[s_idx] >= negative_volumes_start_index;
+            // start above surface. If casting from negative volume face, invert direction, change start pos
+            Vec3f ray_origin = casting_from_negative_volume ? Vec3f(center - normal * 0.01f) : Vec3f(center + normal * 0.01f);
             for (const auto &dir : precomputed_sample_directions) {
-                Vec3f final_ray_dir = (f.to_world(dir));
-                if (!model_contains_negative_parts) {
-                    igl::Hit hitpoint;
-                    // FIXME: This AABBTTreeIndirect query will not compile for float ray origin and
-                    // direction.
-                    Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
-                    Vec3d ray_origin_d    = (center + normal * 0.01f).cast<double>(); // start above surface.
-                    bool  hit = AABBTreeIndirect::intersect_ray_first_hit(triangles.vertices, triangles.indices, raycasting_tree, ray_origin_d, final_ray_dir_d, hitpoint);
-                    if (hit && its_face_normal(triangles, hitpoint.id).dot(final_ray_dir) <= 0) { result[s_idx] -= decrease_step; }
-                } else { // TODO improve logic for order based boolean operations - consider order of volumes
-                    bool casting_from_negative_volume = samples.triangle_indices[s_idx] >= negative_volumes_start_index;
-
-                    Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
-                    if (casting_from_negative_volume) {                            // if casting from negative volume face, invert direction, change start pos
-                        final_ray_dir = -1.0 * final_ray_dir;
-                        ray_origin_d  = (center - normal * 0.01f).cast<double>();
-                    }
-                    Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
-                    bool  some_hit        = AABBTreeIndirect::intersect_ray_all_hits(triangles.vertices, triangles.indices, raycasting_tree, ray_origin_d, final_ray_dir_d, hits);
-                    if (some_hit) {
-                        int counter = 0;
-                        // NOTE: iterating in reverse, from the last hit for one simple reason: We know the state of the ray at that point;
-                        //  It cannot be inside model, and it cannot be inside negative volume
-                        for (int hit_index = int(hits.size()) - 1; hit_index >= 0; --hit_index) {
-                            Vec3f face_normal = its_face_normal(triangles, hits[hit_index].id);
-                            if (hits[hit_index].id >= int(negative_volumes_start_index)) { // negative volume hit
-                                counter -= sgn(face_normal.dot(final_ray_dir));            // if volume face aligns with ray dir, we are leaving negative space
-                                // which in reverse hit analysis means, that we are entering negative space :) and vice versa
-                            } else {
-                                counter += sgn(face_normal.dot(final_ray_dir));
-                            }
-                        }
-                        if (counter == 0) { result[s_idx] -= decrease_step; }
-                    }
-                }
+                Vec3f final_ray_dir = f.to_world(dir);
+                if (casting_from_negative_volume)
+                    final_ray_dir = -1.0 * final_ray_dir;
+                packet_samples[packet.size] = s_idx;
+                packet.push_back(ray_origin, final_ray_dir);
+                if (packet.full())
+                    trace_packet();
             }
         }
+        if (!packet.empty())
+            trace_packet();
     });
 
     BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: raycast visibility of " << samples.positions.size() << " samples over " << triangles.indices.size() << " triangles: end";
@@ -628,12 +642,12 @@ void compute_global_occlusion(GlobalModelInfo &result, const PrintObject *po, st
 
     BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: Mesh sample raidus: " << result.mesh_samples_radius;
 
-    BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: build AABB tree: start";
-    auto raycasting_tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(triangle_set.vertices, triangle_set.indices);
+    BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: build raycasting BVH: start";
+    RayPacketBVH raycasting_bvh(triangle_set);
 
     throw_if_canceled();
-    BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: build AABB tree: end";
-    result.mesh_samples_visibility = raycast_visibility(raycasting_tree, triangle_set, result.mesh_samples, negative_volumes_start_index);
+    BOOST_LOG_TRIVIAL(debug) << "SeamPlacer: build raycasting BVH: end";
+    result.mesh_samples_visibility = raycast_visibility(raycasting_bvh, triangle_set, result.mesh_samples, negative_volumes_start_index);
     throw_if_canceled();
 #ifdef DEBUG_FILES
     result.debug_export(triangle_set);
@@ -1526,4 +1540,42 @@ void SeamPlacer::place_seam(const Layer *layer, ExtrusionLoop &loop, bool extern
     }
 }
 
+size_t SeamPlacer::layer_hash(const Layer *layer) const
+{
+    using namespace SeamPlacerImpl;
+    size_t seed = 0;
+    const PrintObject *po = layer->object();
+    auto it = m_seam_per_object.find(po);
+    if (it == m_seam_per_object.end() || layer->id() < po->slicing_parameters().raft_layers())
+        return seed;
+    const size_t layer_index = layer->id() - po->slicing_parameters().raft_layers();
+    if (layer_index >= it->second.layers.size())
+        return seed;
+    const PrintObjectSeamData::LayerSeams &layer_seams = it->second.layers[layer_index];
+    for (const Perimeter &perimeter : layer_seams.perimeters) {
+        boost::hash_combine(seed, perimeter.start_index);
+        boost::hash_combine(seed, perimeter.end_index);
+        boost::hash_combine(seed, perimeter.seam_index);
+        boost::hash_combine(seed, perimeter.flow_width);
+        boost::hash_combine(seed, perimeter.finalized);
+        for (int i = 0; i < 3; ++ i)
+            boost::hash_combine(seed, perimeter.final_seam_position[i]);
+    }
+    for (const SeamCandidate &point : layer_seams.points) {
+        for (int i = 0; i < 3; ++ i)
+            boost::hash_combine(seed, point.position[i]);
+        boost::hash_combine(seed, point.visibility);
+        boost::hash_combine(seed, point.overhang);
+        boost::hash_combine(seed, point.embedded_distance);
+        boost::hash_combine(seed, point.local_ccw_angle);
+        boost::hash_combine(seed, int(point.type));
+        boost::hash_combine(seed, point.central_enforcer);
+        boost::hash_combine(seed, point.enable_scarf_seam);
+        boost::hash_combine(seed, point.is_grouped);
+        boost::hash_combine(seed, point.extra_overhang_point);
+        boost::hash_combine(seed, point.overhang_degree);
+    }
+    return seed;
+}
+
 } // namespace Slic3r
@@ -165,6 +165,8 @@ public:
     void init(const Print &print, std::function<void(void)> throw_if_canceled_func);
 
     void place_seam(const Layer *layer, ExtrusionLoop &loop, bool external_first, const Point &last_pos, bool &satisfy_angle_threshold) const;
+    // Hash of the seam data of an object layer, which place_seam() chooses the seams of the layer from.
+    size_t layer_hash(const Layer *layer) const;
 
 private:
     void gather_seam_candidates(const PrintObject *po, const SeamPlacerImpl::GlobalModelInfo &global_model_info, const SeamPosition configured_seam_preference);
@@ -141,7 +141,8 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                 // If this is the initial Z move of the layer, replace it with a
                 // (redundant) move to the last Z of previous layer.
                 line.set(reader, Z, z);
-                new_gcode += line.raw() + '\n';
+                new_gcode += line.raw();
+                new_gcode += '\n';
                 return;
             } else {
                 float dist_XY = line.dist_XY(reader);
@@ -158,7 +159,8 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                             // We add this new layer at the very end
                             GCodeReader::GCodeLine transitionLine(line);
                             transitionLine.set(reader, E, line.e() * (1 - factor), 5 /*decimal_digits*/);
-                            transition_gcode += transitionLine.raw() + '\n';
+                            transition_gcode += transitionLine.raw();
+                            transition_gcode += '\n';
                         }
                         // This line is the core of Spiral Vase mode, ramp up the Z smoothly
                         line.set(reader, Z, z + factor * layer_height);
@@ -191,7 +193,8 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                                 }
                             }
                         }
-                        new_gcode += line.raw() + '\n';
+                        new_gcode += line.raw();
+                        new_gcode += '\n';
                     }
                     return;
                     /*  Skip travel moves: the move to first perimeter point will
@@ -204,9 +207,11 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                 }
             }
         }
-        new_gcode += line.raw() + '\n';
+        new_gcode += line.raw();
+        new_gcode += '\n';
         if(transition_out) {
-            transition_gcode += line.raw() + '\n';
+            transition_gcode += line.raw();
+            transition_gcode += '\n';
         }
     });
 
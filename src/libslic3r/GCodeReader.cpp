@@ -1,11 +1,15 @@
 #include "GCodeReader.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <iomanip>
 #include "Utils.hpp"
 
@@ -14,6 +18,23 @@
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#include <tbb/task_arena.h>
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+// We are using quite an old TBB 2017 U7. Before we update our build servers, let's use the old API, which is deprecated in up to date TBB.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if ! defined(TBB_VERSION_MAJOR)
+    static_assert(false, "TBB_VERSION_MAJOR not defined");
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 void GCodeReader::apply_config(const GCodeConfig &config)
@@ -26,7 +47,7 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
     m_config.apply(config, true);
 }
 
-const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const
 {
     PROFILE_FUNC();
 
@@ -82,9 +103,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
@@ -92,7 +110,7 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
     // Copy the raw string including the comment, without the trailing newlines.
     if (c > ptr) {
         PROFILE_BLOCK(copy_raw_string);
-        gline.m_raw.assign(ptr, c);
+        gline.m_raw = std::string_view(ptr, c - ptr);
     }
 
     // Skip the trailing newlines.
@@ -122,10 +140,65 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
     }
 }
 
+// Map the G-code file into memory. Returns false if the file could not be mapped, for example if it is empty.
+static bool map_gcode_file(const std::string &filename, boost::iostreams::mapped_file_source &file)
+{
+    try {
+        boost::system::error_code ec;
+        if (boost::filesystem::file_size(filename, ec) == 0 || ec)
+            return false;
+        file.open(boost::filesystem::path(filename));
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << ": failed to map " << filename << ", falling back to buffered reading: " << ex.what();
+        return false;
+    }
+    return file.is_open();
+}
+
 template<typename ParseLineCallback, typename LineEndCallback>
 bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
+{
+    boost::iostreams::mapped_file_source file;
+    if (! map_gcode_file(filename, file))
+        return this->parse_file_raw_buffered(filename, parse_line_callback, line_end_callback);
+
+    // Lines are passed to the callback directly from the mapped memory, each of them followed by '\r' or '\n',
+    // except for the last line of a file not terminated by a new line.
+    const char *begin = file.data();
+    const char *end   = begin + file.size();
+    // Copy of the last line not terminated by a new line, zero terminated.
+    std::string last_line;
+    m_parsing = true;
+    for (const char *it = begin; it != end;) {
+        // Find end of line.
+        const char *it_end = it;
+        for (; it_end != end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+        if (it_end == end) {
+            last_line.assign(it, it_end);
+            parse_line_callback(last_line.c_str(), last_line.c_str() + last_line.size());
+        } else
+            parse_line_callback(it, it_end);
+        if (! m_parsing)
+            // The callback wishes to exit.
+            return true;
+        // Skip EOL.
+        it = it_end;
+        if (it != end && *it == '\r')
+            ++ it;
+        if (it != end && *it == '\n') {
+            line_end_callback(size_t(it - begin) + 1);
+            ++ it;
+        }
+    }
+    return true;
+}
+
+template<typename ParseLineCallback, typename LineEndCallback>
+bool GCodeReader::parse_file_raw_buffered(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
 {
     FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
+    if (in.f == nullptr)
+        return false;
 
     // Read the input stream 64kB at a time, extract lines and process them.
     std::vector<char> buffer(65536 * 10, 0);
@@ -215,6 +288,120 @@ bool GCodeReader::parse_file(const std::string &file, callback_t callback, std::
     return ret;
 }
 
+// Block of a memory mapped G-code file starting and ending at a line boundary, tokenized by GCodeReader::parse_file_parallel().
+struct GCodeReaderChunk
+{
+    const char                         *begin { nullptr };
+    const char                         *end   { nullptr };
+    // Copy of the last line of the file if it is not terminated by a new line, zero terminated.
+    std::string                         last_line;
+    // Lines referencing the mapped file or last_line.
+    std::vector<GCodeReader::GCodeLine> lines;
+    // For each line, file offset of the character following its terminating '\n', zero if not terminated by '\n'.
+    std::vector<size_t>                 lines_ends;
+};
+
+bool GCodeReader::parse_file_parallel(const std::string &filename, callback_t callback, std::vector<size_t> &lines_ends)
+{
+    boost::iostreams::mapped_file_source file;
+    if (! map_gcode_file(filename, file))
+        return this->parse_file(filename, callback, lines_ends);
+
+    lines_ends.clear();
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  before parse_file_parallel %1%") % filename.c_str();
+
+    // Minimum size of a chunk. A chunk is extended up to the end of the last line started inside it.
+    static constexpr const size_t chunk_size = 1024 * 1024;
+    using ChunkPtr = std::shared_ptr<GCodeReaderChunk>;
+    const char *file_begin = file.data();
+    const char *file_end   = file_begin + file.size();
+    const char *chunk_begin = file_begin;
+    // Set by the processing stage once the callback asked to stop parsing.
+    std::atomic<bool> quit { false };
+    m_parsing = true;
+
+    const auto split = tbb::make_filter<void, ChunkPtr>(slic3r_tbb_filtermode::serial_in_order,
+        [file_end, &chunk_begin, &quit](tbb::flow_control &fc) -> ChunkPtr {
+            if (quit || chunk_begin == file_end) {
+                fc.stop();
+                return {};
+            }
+            auto chunk   = std::make_shared<GCodeReaderChunk>();
+            chunk->begin = chunk_begin;
+            chunk->end   = file_end;
+            if (size_t(file_end - chunk_begin) > chunk_size)
+                if (const void *eol = memchr(chunk_begin + chunk_size, '\n', file_end - chunk_begin - chunk_size); eol != nullptr)
+                    chunk->end = static_cast<const char*>(eol) + 1;
+            chunk_begin = chunk->end;
+            return chunk;
+        });
+
+    // Tokenize lines of a chunk. This is the expensive part of parsing and it does not depend on the state of the reader.
+    const auto tokenize = tbb::make_filter<ChunkPtr, ChunkPtr>(slic3r_tbb_filtermode::parallel,
+        [this, file_begin](ChunkPtr chunk) -> ChunkPtr {
+            const char *end = chunk->end;
+            std::pair<const char*, const char*> command;
+            for (const char *it = chunk->begin; it != end;) {
+                // Find end of line.
+                const char *it_end = it;
+                for (; it_end != end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+                const char *line_begin = it;
+                const char *line_end   = it_end;
+                if (it_end == end) {
+                    // Last line of the file without a new line. Don't let the parser read past the mapped memory.
+                    chunk->last_line.assign(it, it_end);
+                    line_begin = chunk->last_line.c_str();
+                    line_end   = line_begin + chunk->last_line.size();
+                }
+                // Skip the line number, the same way parse_file_internal() does.
+                line_begin = skip_whitespaces(line_begin);
+                if (std::toupper(*line_begin) == 'N')
+                    line_begin = skip_word(line_begin);
+                line_begin = skip_whitespaces(line_begin);
+                this->parse_line_internal(line_begin, line_end, chunk->lines.emplace_back(), command);
+                // Skip EOL.
+                size_t line_end_pos = 0;
+                it = it_end;
+                if (it != end && *it == '\r')
+                    ++ it;
+                if (it != end && *it == '\n')
+                    line_end_pos = size_t(++ it - file_begin);
+                chunk->lines_ends.emplace_back(line_end_pos);
+            }
+            return chunk;
+        });
+
+    // Replay the tokenized lines in order: update the reader state and call the callback exactly as parse_file() would.
+    const auto process = tbb::make_filter<ChunkPtr, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &lines_ends, &quit](ChunkPtr chunk) {
+            if (! m_parsing)
+                // The callback wished to exit while processing one of the previous chunks.
+                return;
+            for (size_t i = 0; i < chunk->lines.size(); ++ i) {
+                GCodeLine &gline = chunk->lines[i];
+                if (gline.has(E) && m_config.use_relative_e_distances)
+                    m_position[E] = 0;
+                callback(*this, gline);
+                std::pair<const char*, const char*> command;
+                command.first  = skip_whitespaces(gline.m_raw.data());
+                command.second = skip_word(command.first);
+                update_coordinates(gline, command);
+                if (! m_parsing) {
+                    // The callback wishes to exit.
+                    quit = true;
+                    return;
+                }
+                if (chunk->lines_ends[i] != 0)
+                    lines_ends.emplace_back(chunk->lines_ends[i]);
+            }
+        });
+
+    tbb::parallel_pipeline(size_t(std::max(4, tbb::this_task_arena::max_concurrency())), split & tokenize & process);
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  finished parse_file_parallel %1%") % filename.c_str();
+    return true;
+}
+
 bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_t line_callback)
 {
     return this->parse_file_raw_internal(filename,
@@ -224,7 +411,7 @@ bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_
 
 bool GCodeReader::GCodeLine::has(char axis) const
 {
-    const char *c = m_raw.c_str();
+    const char *c = m_raw.data();
     // Skip the whitespaces.
     c = skip_whitespaces(c);
     // Skip the command.
@@ -247,7 +434,7 @@ bool GCodeReader::GCodeLine::has(char axis) const
 bool GCodeReader::GCodeLine::has_value(char axis, float &value) const
 {
     assert(is_decimal_separator_point());
-    const char *c = m_raw.c_str();
+    const char *c = m_raw.data();
     // Skip the whitespaces.
     c = skip_whitespaces(c);
     // Skip the command.
@@ -295,17 +482,22 @@ void GCodeReader::GCodeLine::set(const GCodeReader &reader, const Axis axis, con
         match[1] = 'E';
     }
 
+    // Modify a private copy of the line.
+    if (! this->owns_raw())
+        m_raw_storage.assign(m_raw.data(), m_raw.size());
+    std::string &raw = m_raw_storage;
     if (this->has(axis)) {
-        size_t pos = m_raw.find(match)+2;
-        size_t end = m_raw.find(' ', pos+1);
-        m_raw = m_raw.replace(pos, end-pos, ss.str());
+        size_t pos = raw.find(match)+2;
+        size_t end = raw.find(' ', pos+1);
+        raw.replace(pos, end-pos, ss.str());
     } else {
-        size_t pos = m_raw.find(' ');
+        size_t pos = raw.find(' ');
         if (pos == std::string::npos)
-            m_raw += std::string(match) + ss.str();
+            raw += std::string(match) + ss.str();
         else
-            m_raw = m_raw.replace(pos, 0, std::string(match) + ss.str());
+            raw.replace(pos, 0, std::string(match) + ss.str());
     }
+    m_raw = raw;
     m_axis[axis] = new_value;
     m_mask |= 1 << int(axis);
 }
@@ -13,20 +13,51 @@ namespace Slic3r {
 
 class GCodeReader {
 public:
+    // The raw text of a line is a view into the buffer being parsed (a memory mapped file, a string buffer),
+    // valid during the parser callback only. The view is always followed by an end of line character or zero,
+    // thus it may be scanned by skip_whitespaces() / skip_word(). Copying a GCodeLine copies the view,
+    // modifying the line with set() copies the raw text into a storage owned by the GCodeLine.
     class GCodeLine {
     public:
         GCodeLine() { reset(); }
-        void reset() { m_mask = 0; memset(m_axis, 0, sizeof(m_axis)); m_raw.clear(); }
+        GCodeLine(const GCodeLine &rhs) { *this = rhs; }
+        GCodeLine(GCodeLine &&rhs) noexcept { *this = std::move(rhs); }
+        GCodeLine& operator=(const GCodeLine &rhs) {
+            if (this != &rhs) {
+                memcpy(m_axis, rhs.m_axis, sizeof(m_axis));
+                m_mask = rhs.m_mask;
+                if (rhs.owns_raw()) {
+                    m_raw_storage = rhs.m_raw_storage;
+                    m_raw         = m_raw_storage;
+                } else
+                    m_raw = rhs.m_raw;
+            }
+            return *this;
+        }
+        GCodeLine& operator=(GCodeLine &&rhs) noexcept {
+            if (this != &rhs) {
+                memcpy(m_axis, rhs.m_axis, sizeof(m_axis));
+                m_mask = rhs.m_mask;
+                if (rhs.owns_raw()) {
+                    m_raw_storage = std::move(rhs.m_raw_storage);
+                    m_raw         = m_raw_storage;
+                } else
+                    m_raw = rhs.m_raw;
+                rhs.reset();
+            }
+            return *this;
+        }
+        void reset() noexcept { m_mask = 0; memset(m_axis, 0, sizeof(m_axis)); m_raw_storage.clear(); m_raw = m_raw_storage; }
 
-        const std::string&      raw() const { return m_raw; }
+        std::string_view        raw() const { return m_raw; }
         const std::string_view  cmd() const { 
-            const char *cmd = GCodeReader::skip_whitespaces(m_raw.c_str());
+            const char *cmd = GCodeReader::skip_whitespaces(m_raw.data());
             return std::string_view(cmd, GCodeReader::skip_word(cmd) - cmd);
         }
         const std::string_view  comment() const
-            { size_t pos = m_raw.find(';'); return (pos == std::string::npos) ? std::string_view() : std::string_view(m_raw).substr(pos + 1); }
+            { size_t pos = m_raw.find(';'); return (pos == std::string_view::npos) ? std::string_view() : m_raw.substr(pos + 1); }
 
-        void  clear() { m_raw.clear(); }
+        void  clear() { m_raw_storage.clear(); m_raw = m_raw_storage; }
         bool  has(Axis axis) const { return (m_mask & (1 << int(axis))) != 0; }
         float value(Axis axis) const { return m_axis[axis]; }
         bool  has(char axis) const;
@@ -73,19 +104,24 @@ public:
         float j() const { return m_axis[J]; }
         float p() const { return m_axis[P]; }
 
-        static bool cmd_is(const std::string &gcode_line, const char *cmd_test) {
-            const char *cmd = GCodeReader::skip_whitespaces(gcode_line.c_str());
+        // gcode_line has to be followed by an end of line character or zero, see the GCodeLine description.
+        static bool cmd_is(std::string_view gcode_line, const char *cmd_test) {
+            const char *cmd = GCodeReader::skip_whitespaces(gcode_line.data());
             size_t len = strlen(cmd_test); 
             return strncmp(cmd, cmd_test, len) == 0 && GCodeReader::is_end_of_word(cmd[len]);
         }
 
-        static bool cmd_start_with(const std::string& gcode_line, const char* cmd_test) {
-            const char* cmd = GCodeReader::skip_whitespaces(gcode_line.c_str());
+        static bool cmd_start_with(std::string_view gcode_line, const char* cmd_test) {
+            const char* cmd = GCodeReader::skip_whitespaces(gcode_line.data());
             return strncmp(cmd, cmd_test, strlen(cmd_test)) == 0;
         }
 
     private:
-        std::string      m_raw;
+        bool             owns_raw() const { return m_raw.data() == m_raw_storage.data(); }
+
+        // View of the raw line, either into the parsed buffer or into m_raw_storage.
+        std::string_view m_raw;
+        std::string      m_raw_storage;
         float            m_axis[NUM_AXES];
         uint32_t         m_mask;
         friend class GCodeReader;
@@ -120,6 +156,8 @@ public:
     {
         std::pair<const char*, const char*> cmd;
         const char *line_end = parse_line_internal(ptr, end, gline, cmd);
+        if (gline.has(E) && m_config.use_relative_e_distances)
+            m_position[E] = 0;
         callback(*this, gline);
         update_coordinates(gline, cmd);
         return line_end;
@@ -134,6 +172,10 @@ public:
     // Collect positions of line ends in the binary G-code to be used by the G-code viewer when memory mapping and displaying section of G-code
     // as an overlay in the 3D scene.
     bool parse_file(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
+    // Parse the file in large chunks split at line boundaries. Lines of a chunk are tokenized in parallel, while the callback
+    // is called serially in the order of the lines in the file, thus the callback sees the same sequence of lines and the same
+    // reader state as with parse_file(). Returns false if reading the file failed.
+    bool parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
     // Just read the G-code file line by line, calls callback (const char *begin, const char *end). Returns false if reading the file failed.
     bool parse_file_raw(const std::string &file, raw_line_callback_t callback);
 
@@ -178,10 +220,14 @@ public:
 private:
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
+    // Fallback of parse_file_raw_internal() if the file cannot be memory mapped.
+    template<typename ParseLineCallback, typename LineEndCallback>
+    bool        parse_file_raw_buffered(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
-    const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Tokenize a single line. Does not modify the state of the reader, thus it may be called concurrently.
+    const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     GCodeConfig m_config;
@@ -5,10 +5,7 @@
 #include <iostream>
 #include <map>
 #include <assert.h>
-
-#ifdef __APPLE__
-    #include <boost/spirit/include/karma.hpp>
-#endif
+#include <cstring>
 
 #define FLAVOR_IS(val) this->config.gcode_flavor == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor != val
@@ -43,6 +40,68 @@ void GCodeWriter::set_extruders(std::vector<unsigned int> extruder_ids)
     this->multiple_extruders = (*std::max_element(extruder_ids.begin(), extruder_ids.end())) > 0;
 }
 
+GCodeWriter::State GCodeWriter::get_state() const
+{
+    State state;
+    state.filament_extruders.reserve(m_filament_extruders.size());
+    for (const Extruder &extruder : m_filament_extruders)
+        state.filament_extruders.emplace_back(extruder.get_state());
+    Extruder::get_shared_state(state.share_E, state.share_retracted);
+    state.curr_filament_extruder.reserve(m_curr_filament_extruder.size());
+    for (const Extruder *extruder : m_curr_filament_extruder)
+        state.curr_filament_extruder.emplace_back(extruder == nullptr ? -1 : int(extruder - m_filament_extruders.data()));
+    state.curr_extruder_id                 = m_curr_extruder_id;
+    state.last_acceleration                = m_last_acceleration;
+    state.last_jerk                        = m_last_jerk;
+    state.last_additional_fan_speed        = m_last_additional_fan_speed;
+    state.last_bed_temperature             = m_last_bed_temperature;
+    state.last_bed_temperature_reached     = m_last_bed_temperature_reached;
+    state.lifted                           = m_lifted;
+    state.to_lift                          = m_to_lift;
+    state.to_lift_type                     = m_to_lift_type;
+    state.pos                              = m_pos;
+    state.is_current_pos_clear             = m_is_current_pos_clear;
+    state.current_speed                    = m_current_speed;
+    state.gcode_label_objects_start        = m_gcode_label_objects_start;
+    state.gcode_label_objects_end          = m_gcode_label_objects_end;
+    state.is_first_layer                   = m_is_first_layer;
+    state.acceleration                     = m_acceleration;
+    state.travel_accelerations             = m_travel_accelerations;
+    state.first_layer_travel_accelerations = m_first_layer_travel_accelerations;
+    return state;
+}
+
+void GCodeWriter::set_state(const State &state)
+{
+    // The state has to be restored into a writer set up with the same filaments.
+    assert(state.filament_extruders.size() == m_filament_extruders.size());
+    for (size_t i = 0; i < m_filament_extruders.size(); ++ i)
+        m_filament_extruders[i].set_state(state.filament_extruders[i]);
+    Extruder::set_shared_state(state.share_E, state.share_retracted);
+    m_curr_filament_extruder.assign(state.curr_filament_extruder.size(), nullptr);
+    for (size_t i = 0; i < state.curr_filament_extruder.size(); ++ i)
+        if (state.curr_filament_extruder[i] != -1)
+            m_curr_filament_extruder[i] = &m_filament_extruders[state.curr_filament_extruder[i]];
+    m_curr_extruder_id                 = state.curr_extruder_id;
+    m_last_acceleration                = state.last_acceleration;
+    m_last_jerk                        = state.last_jerk;
+    m_last_additional_fan_speed        = state.last_additional_fan_speed;
+    m_last_bed_temperature             = state.last_bed_temperature;
+    m_last_bed_temperature_reached     = state.last_bed_temperature_reached;
+    m_lifted                           = state.lifted;
+    m_to_lift                          = state.to_lift;
+    m_to_lift_type                     = state.to_lift_type;
+    m_pos                              = state.pos;
+    m_is_current_pos_clear             = state.is_current_pos_clear;
+    m_current_speed                    = state.current_speed;
+    m_gcode_label_objects_start        = state.gcode_label_objects_start;
+    m_gcode_label_objects_end          = state.gcode_label_objects_end;
+    m_is_first_layer                   = state.is_first_layer;
+    m_acceleration                     = state.acceleration;
+    m_travel_accelerations             = state.travel_accelerations;
+    m_first_layer_travel_accelerations = state.first_layer_travel_accelerations;
+}
+
 std::string GCodeWriter::preamble()
 {
     std::ostringstream gcode;
@@ -927,51 +986,99 @@ bool GCodeWriter::need_toolchange(unsigned int filament_id)const
     return filament()==nullptr || filament()->id()!=filament_id;
 }
 
+// "00", "01", ..., "99": integers are converted to text two decimal digits at a time.
+static constexpr const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes the decimal digits of v at ptr, returns the end of the written digits.
+static inline char* write_decimal(char *ptr, uint64_t v)
+{
+    char  digits[20];
+    char *begin = digits + sizeof(digits);
+    while (v >= 100) {
+        begin -= 2;
+        memcpy(begin, digit_pairs + 2 * (v % 100), 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        begin -= 2;
+        memcpy(begin, digit_pairs + 2 * v, 2);
+    } else
+        *(-- begin) = char('0' + v);
+    const size_t len = digits + sizeof(digits) - begin;
+    memcpy(ptr, begin, len);
+    return ptr + len;
+}
+
+// Writes exactly num_digits decimal digits of v at ptr, padded with leading zeros.
+static inline char* write_decimal_padded(char *ptr, uint64_t v, size_t num_digits)
+{
+    char *end = ptr + num_digits;
+    char *p   = end;
+    for (; num_digits >= 2; num_digits -= 2) {
+        p -= 2;
+        memcpy(p, digit_pairs + 2 * (v % 100), 2);
+        v /= 100;
+    }
+    if (num_digits == 1)
+        *(-- p) = char('0' + v % 10);
+    return end;
+}
+
+// Writes v rounded to Digits decimal digits. The number is rounded to a fixed point integer, whose integer and fractional parts
+// are written separately, thus the digits never have to be moved to make space for the decimal point or for the zero padding.
+// Digits is a template parameter, so that the divisions by the scale are compiled into multiplications.
+template<size_t Digits>
+static inline char* write_fixed_point(char *ptr, const double v)
+{
+    constexpr uint64_t scale = []() { uint64_t r = 1; for (size_t i = 0; i < Digits; ++ i) r *= 10; return r; }();
+    // Round half away from zero as std::round() does, which is a library call on most platforms.
+    const double   v_scaled = v * double(scale);
+    const int64_t  v_int    = int64_t(v_scaled < 0. ? v_scaled - 0.5 : v_scaled + 0.5);
+    const uint64_t v_abs    = v_int < 0 ? uint64_t(0) - uint64_t(v_int) : uint64_t(v_int);
+    const uint64_t int_part = v_abs / scale;
+    uint64_t       frac     = v_abs % scale;
+    if (v_int < 0)
+        *ptr++ = '-';
+    // The zero integer part of a non-zero number is not written, 0.5 is exported as .5
+    if (int_part != 0 || frac == 0)
+        ptr = write_decimal(ptr, int_part);
+    if (frac != 0) {
+        // Trailing zeros of the fractional part are not written.
+        size_t digits = Digits;
+        for (; frac % 10 == 0; frac /= 10)
+            -- digits;
+        *ptr++ = '.';
+        ptr = write_decimal_padded(ptr, frac, digits);
+    }
+    return ptr;
+}
+
 void GCodeFormatter::emit_axis(const char axis, const double v, size_t digits) {
     assert(digits <= 9);
-    static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
     *ptr_err.ptr++ = ' '; *ptr_err.ptr++ = axis;
 
     char *base_ptr = this->ptr_err.ptr;
-    auto  v_int    = int64_t(std::round(v * pow_10[digits]));
-    // Older stdlib on macOS doesn't support std::from_chars at all, so it is used boost::spirit::karma::generate instead of it.
-    // That is a little bit slower than std::to_chars but not much.
-#ifdef __APPLE__
-    boost::spirit::karma::generate(this->ptr_err.ptr, boost::spirit::karma::int_generator<int64_t>(), v_int);
-#else
-    // this->buf_end minus 1 because we need space for adding the extra decimal point.
-    this->ptr_err = std::to_chars(this->ptr_err.ptr, this->buf_end - 1, v_int);
-#endif
-    size_t writen_digits = (this->ptr_err.ptr - base_ptr) - (v_int < 0 ? 1 : 0);
-    if (writen_digits < digits) {
-        // Number is smaller than 10^digits, so that we will pad it with zeros.
-        size_t remaining_digits = digits - writen_digits;
-        // Move all newly inserted chars by remaining_digits to allocate space for padding with zeros.
-        for (char *from_ptr = this->ptr_err.ptr - 1, *to_ptr = from_ptr + remaining_digits; from_ptr >= this->ptr_err.ptr - writen_digits; --to_ptr, --from_ptr)
-            *to_ptr = *from_ptr;
-
-        memset(this->ptr_err.ptr - writen_digits, '0', remaining_digits);
-        this->ptr_err.ptr += remaining_digits;
-    }
-
-    // Move all newly inserted chars by one to allocate space for a decimal point.
-    for (char *to_ptr = this->ptr_err.ptr, *from_ptr = to_ptr - 1; from_ptr >= this->ptr_err.ptr - digits; --to_ptr, --from_ptr)
-        *to_ptr = *from_ptr;
-
-    *(this->ptr_err.ptr - digits) = '.';
-    for (size_t i = 0; i < digits; ++i) {
-        if (*this->ptr_err.ptr != '0')
-            break;
-        this->ptr_err.ptr--;
-    }
-    if (*this->ptr_err.ptr == '.')
-        this->ptr_err.ptr--;
-    if ((this->ptr_err.ptr + 1) == base_ptr || *this->ptr_err.ptr == '-')
-        *(++this->ptr_err.ptr) = '0';
-    this->ptr_err.ptr++;
+    switch (digits) {
+    case 0:  this->ptr_err.ptr = write_fixed_point<0>(base_ptr, v); break;
+    case 1:  this->ptr_err.ptr = write_fixed_point<1>(base_ptr, v); break;
+    case 2:  this->ptr_err.ptr = write_fixed_point<2>(base_ptr, v); break;
+    case 3:  this->ptr_err.ptr = write_fixed_point<3>(base_ptr, v); break;
+    case 4:  this->ptr_err.ptr = write_fixed_point<4>(base_ptr, v); break;
+    case 5:  this->ptr_err.ptr = write_fixed_point<5>(base_ptr, v); break;
+    case 6:  this->ptr_err.ptr = write_fixed_point<6>(base_ptr, v); break;
+    case 7:  this->ptr_err.ptr = write_fixed_point<7>(base_ptr, v); break;
+    case 8:  this->ptr_err.ptr = write_fixed_point<8>(base_ptr, v); break;
+    default: this->ptr_err.ptr = write_fixed_point<9>(base_ptr, v); break;
+    }
 
 #if 0 // #ifndef NDEBUG
     {
+        static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
         // Verify that the optimized formatter produces the same result as the standard sprintf().
         double v1 = atof(std::string(base_ptr, this->ptr_err.ptr).c_str());
         char buf[2048];
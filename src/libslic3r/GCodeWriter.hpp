@@ -28,7 +28,8 @@ public:
         m_single_extruder_multi_material(false),
         m_last_acceleration(0), m_max_acceleration(0),
         m_last_jerk(0), m_max_jerk(0),
-        /*m_last_bed_temperature(0), */m_last_bed_temperature_reached(true),
+        // No bed temperature was set yet, the first one is emitted even if it is zero.
+        m_last_bed_temperature(-1), m_last_bed_temperature_reached(true),
         m_lifted(0),
         m_to_lift(0),
         m_to_lift_type(LiftType::NormalLift)
@@ -117,6 +118,38 @@ public:
     void set_current_position_clear(bool clear) { m_is_current_pos_clear = clear; };
     bool is_current_position_clear() const { return m_is_current_pos_clear; };
     void set_is_bbl_printer(bool is_bbl_printer) { m_is_bbl_printer = is_bbl_printer; };
+    // State changing while the layers are exported: position, extruder axes, lift, acceleration and the current filament.
+    // Saved and restored by the incremental G-code export to resume the export at a layer, see GCodeLayerCache.
+    // The configuration and the set of the filaments are not part of the state.
+    struct State
+    {
+        std::vector<Extruder::State> filament_extruders;
+        std::vector<double>          share_E;
+        std::vector<double>          share_retracted;
+        // Indices into m_filament_extruders of the filaments loaded into the extruders, -1 for none.
+        std::vector<int>             curr_filament_extruder;
+        int                          curr_extruder_id;
+        unsigned int                 last_acceleration;
+        double                       last_jerk;
+        unsigned int                 last_additional_fan_speed;
+        int                          last_bed_temperature;
+        bool                         last_bed_temperature_reached;
+        double                       lifted;
+        double                       to_lift;
+        LiftType                     to_lift_type;
+        Vec3d                        pos;
+        bool                         is_current_pos_clear;
+        double                       current_speed;
+        std::string                  gcode_label_objects_start;
+        std::string                  gcode_label_objects_end;
+        bool                         is_first_layer;
+        unsigned int                 acceleration;
+        std::vector<unsigned int>    travel_accelerations;
+        std::vector<unsigned int>    first_layer_travel_accelerations;
+    };
+    State get_state() const;
+    void  set_state(const State &state);
+
     //BBS:
     static const bool full_gcode_comment;
     //Radian threshold of slope for lazy lift and spiral lift;
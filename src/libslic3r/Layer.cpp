@@ -601,6 +601,33 @@ size_t Layer::get_extruder_id(unsigned int filament_id) const
     return m_object->print()->get_extruder_id(filament_id);
 }
 
+void Layer::release_extrusions()
+{
+    for (LayerRegion *layerm : m_regions)
+        layerm->release_extrusions();
+    clear_and_shrink(lslices_extrudable);
+    // loverhangs are kept, the travels of the layers above test them to choose the type of the z-hop.
+    clear_and_shrink(loop_nodes);
+    clear_and_shrink(sharp_tails);
+    clear_and_shrink(sharp_tails_height);
+    clear_and_shrink(cantilevers);
+}
+
+void SupportLayer::release_extrusions()
+{
+    Layer::release_extrusions();
+    support_fills.clear();
+    clear_and_shrink(support_fills.entities);
+    clear_and_shrink(support_islands);
+    clear_and_shrink(base_areas);
+    // The area groups point into the areas, release them first.
+    clear_and_shrink(area_groups);
+    clear_and_shrink(roof_areas);
+    clear_and_shrink(roof_1st_layer);
+    clear_and_shrink(floor_areas);
+    clear_and_shrink(roof_gap_areas);
+}
+
 BoundingBox get_extents(const LayerRegion &layer_region)
 {
     BoundingBox bbox;
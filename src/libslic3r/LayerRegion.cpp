@@ -766,6 +766,22 @@ void LayerRegion::export_region_fill_surfaces_to_svg_debug(const char *name) con
     this->export_region_fill_surfaces_to_svg(debug_out_path("LayerRegion-fill_surfaces-%s-%d.svg", name, idx ++).c_str());
 }
 
+void LayerRegion::release_extrusions()
+{
+    perimeters.clear();
+    clear_and_shrink(perimeters.entities);
+    fills.clear();
+    clear_and_shrink(fills.entities);
+    thin_fills.clear();
+    clear_and_shrink(thin_fills.entities);
+    clear_and_shrink(slices.surfaces);
+    clear_and_shrink(raw_slices);
+    clear_and_shrink(fill_expolygons);
+    clear_and_shrink(fill_surfaces.surfaces);
+    clear_and_shrink(fill_no_overlap_expolygons);
+    clear_and_shrink(unsupported_bridge_edges);
+}
+
 void LayerRegion::simplify_entity_collection(ExtrusionEntityCollection* entity_collection)
 {
     for (size_t i = 0; i < entity_collection->entities.size(); i++) {
@@ -3141,6 +3141,7 @@ void ModelVolume::center_geometry_after_creation(bool update_source_offset)
         if (m_mesh) {
             const_cast<TriangleMesh*>(m_mesh.get())->translate(-(float)shift(0), -(float)shift(1), -(float)shift(2));
             const_cast<TriangleMesh*>(m_mesh.get())->set_init_shift(shift);
+            m_mesh_data_cache.reset();
         }
         if (m_convex_hull)
 			const_cast<TriangleMesh*>(m_convex_hull.get())->translate(-(float)shift(0), -(float)shift(1), -(float)shift(2));
@@ -3254,6 +3255,26 @@ int ModelVolume::get_repaired_errors_count() const
             stats.facets_reversed + stats.backwards_edges;
 }
 
+std::shared_ptr<const std::vector<Vec3i>> ModelVolume::face_edge_ids() const
+{
+    std::lock_guard<std::mutex> lock(m_mesh_data_cache.mutex);
+    m_mesh_data_cache.validate(m_mesh);
+    if (! m_mesh_data_cache.face_edge_ids)
+        m_mesh_data_cache.face_edge_ids = std::make_shared<const std::vector<Vec3i>>(its_face_edge_ids(m_mesh->its));
+    return m_mesh_data_cache.face_edge_ids;
+}
+
+uint64_t ModelVolume::mesh_hash() const
+{
+    std::lock_guard<std::mutex> lock(m_mesh_data_cache.mutex);
+    m_mesh_data_cache.validate(m_mesh);
+    if (! m_mesh_data_cache.has_mesh_hash) {
+        m_mesh_data_cache.mesh_hash     = its_hash(m_mesh->its);
+        m_mesh_data_cache.has_mesh_hash = true;
+    }
+    return m_mesh_data_cache.mesh_hash;
+}
+
 const TriangleMesh& ModelVolume::get_convex_hull() const
 {
     return *m_convex_hull.get();
@@ -3454,6 +3475,7 @@ void ModelVolume::mirror(Axis axis)
 void ModelVolume::scale_geometry_after_creation(const Vec3f& versor)
 {
 	const_cast<TriangleMesh*>(m_mesh.get())->scale(versor);
+    m_mesh_data_cache.reset();
     if (m_convex_hull->empty())
         //BBS: recompute the convex hull if it is null for previous too small
         this->calculate_convex_hull();
@@ -4323,6 +4345,14 @@ bool model_custom_supports_data_changed(const ModelObject& mo, const ModelObject
         [](const ModelVolume &mv_old, const ModelVolume &mv_new){ return mv_old.supported_facets.timestamp_matches(mv_new.supported_facets); });
 }
 
+bool model_custom_supports_painting_changed(const ModelObject& mo, const ModelObject& mo_new)
+{
+    return model_property_changed(mo, mo_new,
+        [](const ModelVolumeType t) { return t == ModelVolumeType::MODEL_PART; },
+        [](const ModelVolume &mv_old, const ModelVolume &mv_new){
+            return mv_old.supported_facets.timestamp_matches(mv_new.supported_facets) || mv_old.supported_facets.equals(mv_new.supported_facets); });
+}
+
 bool model_custom_fuzzy_skin_data_changed(const ModelObject &mo, const ModelObject &mo_new)
 {
     return model_property_changed(
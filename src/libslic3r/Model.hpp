@@ -29,6 +29,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -937,6 +938,11 @@ public:
     void                set_mesh(std::unique_ptr<const TriangleMesh> &&mesh) { m_mesh = std::move(mesh); }
 	void				reset_mesh() { m_mesh = std::make_shared<const TriangleMesh>(); }
     const std::shared_ptr<const TriangleMesh> &get_mesh_shared_ptr() const { return m_mesh; }
+    // Unique edge IDs of the mesh faces, see its_face_edge_ids(). Calculated on demand and kept for slicing the same mesh again,
+    // recalculated once the mesh is replaced.
+    std::shared_ptr<const std::vector<Vec3i>> face_edge_ids() const;
+    // its_hash() of the mesh, calculated on demand and kept until the mesh is replaced. Used as a key of the SliceCache.
+    uint64_t            mesh_hash() const;
     // Configuration parameters specific to an object model geometry or a modifier volume,
     // overriding the global Slic3r settings and the ModelObject settings.
     ModelConfigObject	config;
@@ -1110,6 +1116,39 @@ private:
     mutable Polygon                     m_convex_hull_2d; //BBS, used for convex_hell_2d acceleration
     mutable Transform3d                 m_cached_trans_matrix{Transform3d::Identity()}; // BBS, used for convex_hell_2d acceleration
     mutable Polygon                     m_cached_2d_polygon;   //BBS, used for convex_hell_2d acceleration
+    // Cache of face_edge_ids() and mesh_hash(), valid for the mesh they were calculated for. A copy of the volume shares the cached data.
+    struct MeshDataCache
+    {
+        MeshDataCache() = default;
+        MeshDataCache(const MeshDataCache &rhs) {
+            std::lock_guard<std::mutex> lock(rhs.mutex);
+            mesh          = rhs.mesh;
+            face_edge_ids = rhs.face_edge_ids;
+            mesh_hash     = rhs.mesh_hash;
+            has_mesh_hash = rhs.has_mesh_hash;
+        }
+        // Drops the cached data if the mesh was replaced. Call with the mutex locked.
+        void validate(const std::shared_ptr<const TriangleMesh> &current_mesh) {
+            if (mesh.lock() != current_mesh) {
+                mesh          = current_mesh;
+                face_edge_ids.reset();
+                has_mesh_hash = false;
+            }
+        }
+        // Drops the cached data after the shared mesh was modified in place.
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex);
+            mesh.reset();
+            face_edge_ids.reset();
+            has_mesh_hash = false;
+        }
+        mutable std::mutex                        mutex;
+        std::weak_ptr<const TriangleMesh>         mesh;
+        std::shared_ptr<const std::vector<Vec3i>> face_edge_ids;
+        uint64_t                                  mesh_hash { 0 };
+        bool                                      has_mesh_hash { false };
+    };
+    mutable MeshDataCache               m_mesh_data_cache;
     Geometry::Transformation        	m_transformation;
 
     TextInfo m_text_info;
@@ -1794,6 +1833,10 @@ bool model_volume_list_changed(const ModelObject &model_object_old, const ModelO
 // Test whether the now ModelObject has newer custom supports data than the old one.
 // The function assumes that volumes list is synchronized.
 bool model_custom_supports_data_changed(const ModelObject& mo, const ModelObject& mo_new);
+// Test whether the new ModelObject has custom supports painted differently than the old one. The timestamps differ
+// even if the painting did not change, for example after undo / redo or after painting over an already painted area.
+// The function assumes that volumes list is synchronized.
+bool model_custom_supports_painting_changed(const ModelObject& mo, const ModelObject& mo_new);
 bool model_custom_fuzzy_skin_data_changed(const ModelObject &mo, const ModelObject &mo_new);
     // Test whether the now ModelObject has newer custom seam data than the old one.
 // The function assumes that volumes list is synchronized.
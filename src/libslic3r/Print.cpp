@@ -2155,7 +2155,16 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
     //BBS: compute plate offset for gcode-generator
     const Vec3d origin = this->get_plate_origin();
     gcode.set_gcode_offset(origin(0), origin(1));
+    if (m_gcode_layer_cache)
+        gcode.set_layer_cache(m_gcode_layer_cache.get());
+    if (m_release_layers_after_export)
+        // The layers are owned by this Print, the G-code generator only accesses them through const pointers.
+        gcode.set_layer_exported_callback([](const Layer &layer) { const_cast<Layer&>(layer).release_extrusions(); });
     gcode.do_export(this, path.c_str(), result, thumbnail_cb);
+    if (m_release_layers_after_export)
+        // Some of the layers were released, slice them again if exporting once more.
+        for (PrintObject *object : m_objects)
+            object->invalidate_step(posSlice);
     gcode.export_layer_filaments(result);
     //BBS
     if (result != nullptr)
@@ -2163,6 +2172,17 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
     return path.c_str();
 }
 
+void Print::set_gcode_layer_cache_size(size_t max_memory)
+{
+    if (max_memory == 0)
+        m_gcode_layer_cache.reset();
+    else {
+        if (! m_gcode_layer_cache)
+            m_gcode_layer_cache = std::make_shared<GCodeLayerCache>();
+        m_gcode_layer_cache->set_max_memory(max_memory);
+    }
+}
+
 void Print::_make_skirt()
 {
     // First off we need to decide how tall the skirt must be.
@@ -2925,6 +2945,7 @@ void Print::export_gcode_from_previous_file(const std::string& file, GCodeProces
         const Vec3d origin = this->get_plate_origin();
         processor.set_xy_offset(origin(0), origin(1));
         //processor.enable_producers(true);
+        processor.enable_parallel_parsing(true);
         processor.process_file(file);
 
         *result = std::move(processor.extract_result());
@@ -28,6 +28,7 @@
 namespace Slic3r {
 
 class GCode;
+class GCodeLayerCache;
 class Layer;
 class ModelObject;
 class Print;
@@ -577,8 +578,10 @@ private:
     void merge_infill_types();
     void combine_infill();
     void _generate_support_material();
+    // The previous octrees are reused if they were built from the same mesh and overhangs.
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> prepare_adaptive_infill_data(
-        const std::vector<std::pair<const Surface*, float>>& surfaces_w_bottom_z) const;
+        const std::vector<std::pair<const Surface*, float>>& surfaces_w_bottom_z,
+        std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> &&previous_octrees) const;
     FillLightning::GeneratorPtr prepare_lightning_infill_data();
 
     // BBS
@@ -605,6 +608,9 @@ private:
     LayerPtrs                               m_layers;
     SupportLayerPtrs                        m_support_layers;
     // BBS
+    // Kept after the support generation until the object is sliced again: the next support generation after a change
+    // of the support painting or of the support parameters reuses its collision and avoidance areas and overhangs
+    // instead of computing them again, at the cost of holding them in memory, which may take tens of MB for a tall object.
     std::shared_ptr<TreeSupportData>        m_tree_support_preview_cache;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
@@ -1006,6 +1012,13 @@ public:
 
     void set_check_multi_filaments_compatibility(bool check) { m_need_check_multi_filaments_compatibility = check; }
     bool need_check_multi_filaments_compatibility() const { return m_need_check_multi_filaments_compatibility; }
+    // Release the extrusions of each layer as soon as export_gcode() wrote its G-code, to lower the peak memory of command line slicing.
+    // The objects have to be sliced again before the next export, only the layer heights and the first layer bounding boxes remain valid.
+    void set_release_layers_after_export(bool release) { m_release_layers_after_export = release; }
+    // Keep the G-code of the layers exported last in memory up to max_memory bytes, export_gcode() copies the layers preceding
+    // the first layer changed since then instead of generating them again. Zero disables the cache.
+    void set_gcode_layer_cache_size(size_t max_memory);
+    const GCodeLayerCache* gcode_layer_cache() const { return m_gcode_layer_cache.get(); }
 
     // scaled point
     Vec2d translate_to_print_space(const Point& point) const;
@@ -1094,6 +1107,8 @@ private:
     Calib_Params m_calib_params;
 
     bool m_need_check_multi_filaments_compatibility{true};
+    bool m_release_layers_after_export{false};
+    std::shared_ptr<GCodeLayerCache> m_gcode_layer_cache;
 
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
@@ -1516,7 +1516,9 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
             model_object.assign_copy(model_object_new);
         } else {
             model_object_status.print_object_regions_status = ModelObjectStatus::PrintObjectRegionsStatus::Valid;
-            if (supports_differ || model_custom_supports_data_changed(model_object, model_object_new)) {
+            // Supports painted again the same way do not invalidate the supports.
+            if (supports_differ || (model_custom_supports_data_changed(model_object, model_object_new) &&
+                                    model_custom_supports_painting_changed(model_object, model_object_new))) {
                 // First stop background processing before shuffling or deleting the ModelVolumes in the ModelObject's list.
                 if (supports_differ) {
                     this->call_cancel_callback();
@@ -8223,6 +8223,41 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "If enabled, the arrange will avoid extrusion calibrate region when place object";
     def->set_default_value(new ConfigOptionBool(false));
 
+    def = this->add("infill_cache_size", coInt);
+    def->label = "Infill cache size";
+    def->tooltip = "Keep up to this many megabytes of the sparse and solid infill in memory and reuse it for the same surfaces "
+                   "of other objects with the same infill settings, for example for copies of a part added as separate objects. "
+                   "The infill is not kept if zero.";
+    def->cli_params = "MB";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("slice_cache_dir", coString);
+    def->label = "Slice cache directory";
+    def->tooltip = "Store the slices of the objects into this directory and reuse them when slicing the same object with the same layers again, "
+                   "for example by another run of the command line slicer. The slices are not stored if empty.";
+    def->cli_params = "\"dir\"";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("slice_cache_size", coInt);
+    def->label = "Slice cache size";
+    def->tooltip = "Keep up to this many megabytes of the slices of the objects in memory and reuse them when slicing the same object "
+                   "with the same layers again. The slices are not kept if zero.";
+    def->cli_params = "MB";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("release_layers_after_export", coBool);
+    def->label = "Release layers after export";
+    def->tooltip = "Free the extrusions of each layer as soon as its G-code is exported to lower the peak memory usage. "
+                   "Ignored when exporting the slicing data.";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("export_binary_gcode", coBool);
+    def->label = "Export binary G-code";
+    def->tooltip = "Also write the G-code of each plate as a binary G-code (.bgcode) next to the text G-code.";
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("skip_modified_gcodes", coBool);
     def->label = "Skip modified gcodes in 3mf";
     def->tooltip = "Skip the modified gcodes in 3mf from Printer or filament Presets";
@@ -808,7 +808,8 @@ void PrintObject::simplify_extrusion_path()
 }
 
 std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare_adaptive_infill_data(
-    const std::vector<std::pair<const Surface *, float>> &surfaces_w_bottom_z) const
+    const std::vector<std::pair<const Surface *, float>> &surfaces_w_bottom_z,
+    std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> &&previous_octrees) const
 {
     using namespace FillAdaptive;
 
@@ -840,8 +841,8 @@ std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare
         append(overhangs.front(), std::move(overhangs[i]));
 
     return std::make_pair(
-        adaptive_line_spacing ? build_octree(mesh, overhangs.front(), adaptive_line_spacing, false) : OctreePtr(),
-        support_line_spacing  ? build_octree(mesh, overhangs.front(), support_line_spacing, true) : OctreePtr());
+        adaptive_line_spacing ? build_octree(mesh, overhangs.front(), adaptive_line_spacing, false, std::move(previous_octrees.first)) : OctreePtr(),
+        support_line_spacing  ? build_octree(mesh, overhangs.front(), support_line_spacing, true, std::move(previous_octrees.second)) : OctreePtr());
 }
 
 FillLightning::GeneratorPtr PrintObject::prepare_lightning_infill_data()
@@ -899,9 +900,18 @@ void PrintObject::clear_support_layers()
 
 std::shared_ptr<TreeSupportData> PrintObject::alloc_tree_support_preview_cache()
 {
-    if (!m_tree_support_preview_cache) {
-        const coordf_t xy_distance = m_config.support_object_xy_distance.value;
+    const coordf_t xy_distance = m_config.support_object_xy_distance.value;
+    const uint64_t inputs_hash = TreeSupportData::calc_inputs_hash(*this, xy_distance, g_config_tree_support_collision_resolution);
+    if (m_tree_support_preview_cache && m_tree_support_preview_cache->inputs_hash == inputs_hash) {
+        // Just the support painting or support parameters not affecting the collision areas changed,
+        // keep the collision and avoidance areas. Drop the nodes of the previous support generation.
+        m_tree_support_preview_cache->clear_nodes();
+        m_tree_support_preview_cache->layer_heights.clear();
+    } else {
+        // Release the memory of the previous data before building the new one.
+        m_tree_support_preview_cache.reset();
         m_tree_support_preview_cache = std::make_shared<TreeSupportData>(*this, xy_distance, g_config_tree_support_collision_resolution);
+        m_tree_support_preview_cache->inputs_hash = inputs_hash;
     }
 
     return m_tree_support_preview_cache;
@@ -1233,6 +1243,8 @@ bool PrintObject::invalidate_step(PrintObjectStep step)
 		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posSimplifyWall, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
         m_slicing_params.valid = false;
+        // The tree support data kept for the next support generation will not match the new slices.
+        m_tree_support_preview_cache.reset();
     } else if (step == posSupportMaterial) {
         invalidated |= this->invalidate_steps({ posSimplifySupportPath });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
@@ -2186,7 +2198,7 @@ void PrintObject::bridge_over_infill()
             }
         }
 
-        this->m_adaptive_fill_octrees = this->prepare_adaptive_infill_data(surfaces_w_bottom_z);
+        this->m_adaptive_fill_octrees = this->prepare_adaptive_infill_data(surfaces_w_bottom_z, std::move(this->m_adaptive_fill_octrees));
 
         std::vector<size_t> layers_to_generate_infill;
         for (const auto &pair : surfaces_by_layer) {
@@ -3456,9 +3468,14 @@ void PrintObject::combine_infill()
 void PrintObject::_generate_support_material()
 {
     if (is_tree(m_config.support_type.value)) {
-        TreeSupport tree_support(*this, m_slicing_params);
-        tree_support.throw_on_cancel = [this]() { this->throw_if_canceled(); };
-        tree_support.generate();
+        {
+            TreeSupport tree_support(*this, m_slicing_params);
+            tree_support.throw_on_cancel = [this]() { this->throw_if_canceled(); };
+            tree_support.generate();
+        }
+        // Only the collision and avoidance areas and the overhangs are reused by the next support generation, the nodes are not.
+        if (m_tree_support_preview_cache)
+            m_tree_support_preview_cache->clear_nodes();
     }
     else {
         PrintObjectSupportMaterial support_material(this, m_slicing_params);
@@ -3,6 +3,7 @@
 #include "Layer.hpp"
 #include "MultiMaterialSegmentation.hpp"
 #include "Print.hpp"
+#include "SliceCache.hpp"
 #include "ClipperUtils.hpp"
 #include "Interlocking/InterlockingGenerator.hpp"
 //BBS
@@ -54,14 +55,38 @@ static std::vector<ExPolygons> slice_volume(
 {
     std::vector<ExPolygons> layers;
     if (! zs.empty()) {
-        indexed_triangle_set its = volume.mesh().its;
-        if (its.indices.size() > 0) {
+        const indexed_triangle_set &mesh_its = volume.mesh().its;
+        if (mesh_its.indices.size() > 0) {
             MeshSlicingParamsEx params2 { params };
             params2.trafo = params2.trafo * volume.get_matrix();
-            if (params2.trafo.rotation().determinant() < 0.)
+            // Slices of the same mesh with the same transformation, Zs and parameters may be cached by a previous slicing.
+            SliceCache &cache = SliceCache::get_instance();
+            const bool      use_cache = cache.enabled();
+            SliceCache::Key cache_key;
+            if (use_cache) {
+                cache_key = SliceCache::Key(volume.mesh_hash(), zs, params2);
+                if (cache.get(cache_key, layers))
+                    return layers;
+            }
+            // Edge IDs are cached with the volume, they are only recalculated if the mesh changes.
+            std::shared_ptr<const std::vector<Vec3i>> face_edge_ids = volume.face_edge_ids();
+            if (params2.trafo.rotation().determinant() < 0.) {
+                indexed_triangle_set its = mesh_its;
                 its_flip_triangles(its);
-            layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
+                // Flipping a triangle reverses the order of its edges.
+                std::vector<Vec3i> flipped_edge_ids;
+                flipped_edge_ids.reserve(face_edge_ids->size());
+                for (const Vec3i &edge_ids : *face_edge_ids)
+                    flipped_edge_ids.emplace_back(edge_ids(2), edge_ids(1), edge_ids(0));
+                params2.face_edge_ids = &flipped_edge_ids;
+                layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
+            } else {
+                params2.face_edge_ids = face_edge_ids.get();
+                layers = slice_mesh_ex(mesh_its, zs, params2, throw_on_cancel_callback);
+            }
             throw_on_cancel_callback();
+            if (use_cache)
+                cache.put(cache_key, layers);
         }
     }
     return layers;
@@ -0,0 +1,607 @@
+#include "RayPacketBVH.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <limits>
+
+// Kernels tracing packets of rays, see trace_first_hits() and trace_all_hits().
+#if defined(__x86_64__) || defined(_M_X64)
+    // SSE2 is a part of x86-64.
+    #define SLIC3R_RAY_PACKET_SSE
+    #define SLIC3R_RAY_PACKET_AVX2
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define SLIC3R_TARGET_AVX2
+        #define SLIC3R_TARGET_AVX2_FLATTEN
+    #else
+        #define SLIC3R_TARGET_AVX2 __attribute__((target("avx2")))
+        // The traversal templates are instantiated with the AVX2 lanes from functions compiled for AVX2. Flattening inlines
+        // the templates and the AVX2 lane operations into these functions, as the templates themselves are not compiled for AVX2.
+        #define SLIC3R_TARGET_AVX2_FLATTEN __attribute__((target("avx2"), flatten))
+        #if defined(__GNUC__) && ! defined(__clang__)
+            // The templates instantiated with the AVX2 lanes pass __m256 around, they are never called without being flattened.
+            #pragma GCC diagnostic ignored "-Wpsabi"
+        #endif
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SLIC3R_RAY_PACKET_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace Slic3r {
+
+using Node     = RayPacketBVH::Node;
+using Triangle = RayPacketBVH::Triangle;
+using Packet   = RayPacketBVH::Packet;
+
+static constexpr const int   NumBins       = 16;
+static constexpr const int   MaxLeafSize   = 8;
+// Below this depth the nodes are split by the median, which bounds the depth of the hierarchy, see TraversalStackSize.
+static constexpr const int   MaxSAHDepth   = 48;
+static constexpr const int   MaxDepth      = 96;
+static constexpr const int   TraversalStackSize = MaxDepth + 2;
+// Cost of traversing a node relative to intersecting a triangle.
+static constexpr const float TraversalCost = 1.f;
+// The first hits accept the rays passing slightly outside of a triangle, measured in its barycentric coordinates, so that
+// the rays do not slip between two triangles sharing an edge due to the rounding of the single precision intersections.
+// The all hits do not, as hitting both triangles would make a ray enter or leave a volume twice.
+static constexpr const float EdgeTolerance = 1e-5f;
+
+namespace {
+
+struct BuildItem
+{
+    Vec3f min;
+    Vec3f max;
+    Vec3f centroid;
+    int   id;
+};
+
+struct Bounds
+{
+    Vec3f min {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() };
+    Vec3f max { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+    void  extend(const Vec3f &pt) { min = min.cwiseMin(pt); max = max.cwiseMax(pt); }
+    void  extend(const Bounds &rhs) { min = min.cwiseMin(rhs.min); max = max.cwiseMax(rhs.max); }
+    bool  empty() const { return min.x() > max.x(); }
+    float half_area() const {
+        if (this->empty())
+            return 0.f;
+        const Vec3f d = max - min;
+        return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+    }
+};
+
+class Builder
+{
+public:
+    Builder(const indexed_triangle_set &its, std::vector<Node> &nodes, std::vector<Triangle> &triangles) :
+        m_its(its), m_nodes(nodes), m_triangles(triangles)
+    {
+        m_items.reserve(its.indices.size());
+        Bounds bounds;
+        for (size_t i = 0; i < its.indices.size(); ++ i) {
+            const stl_triangle_vertex_indices &face = its.indices[i];
+            BuildItem item;
+            item.min = item.max = its.vertices[face(0)];
+            for (int j = 1; j < 3; ++ j) {
+                item.min = item.min.cwiseMin(its.vertices[face(j)]);
+                item.max = item.max.cwiseMax(its.vertices[face(j)]);
+            }
+            item.centroid = (its.vertices[face(0)] + its.vertices[face(1)] + its.vertices[face(2)]) / 3.f;
+            item.id       = int(i);
+            m_items.emplace_back(item);
+            bounds.extend(item.min);
+            bounds.extend(item.max);
+        }
+        // Pad the bounding boxes, so that the rays hitting a triangle on a face of its bounding box do not miss it due to rounding.
+        m_pad = bounds.empty() ? 0.f : 1e-6f * std::max(1.f, (bounds.max - bounds.min).maxCoeff());
+    }
+
+    void build()
+    {
+        m_nodes.clear();
+        m_triangles.clear();
+        if (m_items.empty())
+            return;
+        m_nodes.reserve(2 * m_items.size());
+        m_triangles.reserve(m_items.size());
+        m_nodes.emplace_back();
+        this->build_recursive(0, 0, m_items.size(), 0);
+    }
+
+private:
+    void build_recursive(size_t node_idx, size_t begin, size_t end, int depth)
+    {
+        Bounds bounds, centroids;
+        for (size_t i = begin; i < end; ++ i) {
+            bounds.min = bounds.min.cwiseMin(m_items[i].min);
+            bounds.max = bounds.max.cwiseMax(m_items[i].max);
+            centroids.extend(m_items[i].centroid);
+        }
+        {
+            Node &node = m_nodes[node_idx];
+            for (int k = 0; k < 3; ++ k) {
+                node.min[k] = bounds.min[k] - m_pad;
+                node.max[k] = bounds.max[k] + m_pad;
+            }
+        }
+
+        const size_t count = end - begin;
+        size_t       mid   = begin;
+        int          axis  = 0;
+        if (count > 2) {
+            mid = depth < MaxSAHDepth ? this->partition_sah(begin, end, bounds, centroids, axis) : begin;
+            if (mid == begin && count > MaxLeafSize)
+                mid = this->partition_median(begin, end, centroids, axis);
+        }
+        if (mid == begin || depth >= MaxDepth) {
+            Node &node = m_nodes[node_idx];
+            node.index = uint32_t(m_triangles.size());
+            node.count = uint16_t(count);
+            node.axis  = 0;
+            for (size_t i = begin; i < end; ++ i) {
+                const stl_triangle_vertex_indices &face = m_its.indices[m_items[i].id];
+                const Vec3f &v0 = m_its.vertices[face(0)];
+                const Vec3f  e1 = m_its.vertices[face(1)] - v0;
+                const Vec3f  e2 = m_its.vertices[face(2)] - v0;
+                Triangle     triangle;
+                for (int k = 0; k < 3; ++ k) {
+                    triangle.v0[k] = v0[k];
+                    triangle.e1[k] = e1[k];
+                    triangle.e2[k] = e2[k];
+                }
+                triangle.id = m_items[i].id;
+                m_triangles.emplace_back(triangle);
+            }
+            return;
+        }
+
+        const size_t left = m_nodes.size();
+        m_nodes.emplace_back();
+        m_nodes.emplace_back();
+        {
+            Node &node = m_nodes[node_idx];
+            node.index = uint32_t(left);
+            node.count = 0;
+            node.axis  = uint16_t(axis);
+        }
+        this->build_recursive(left,     begin, mid, depth + 1);
+        this->build_recursive(left + 1, mid,   end, depth + 1);
+    }
+
+    // Partitions the items by the binned surface area heuristic. Returns begin if the centroids can not be split
+    // or if the items fit a leaf, which is cheaper than any split.
+    size_t partition_sah(size_t begin, size_t end, const Bounds &bounds, const Bounds &centroids, int &axis)
+    {
+        struct Bin {
+            Bounds bounds;
+            size_t count { 0 };
+        };
+        const size_t count     = end - begin;
+        const float  leaf_cost = float(count);
+        float        best_cost = std::numeric_limits<float>::max();
+        int          best_axis = -1;
+        int          best_bin  = 0;
+        for (int k = 0; k < 3; ++ k) {
+            const float extent = centroids.max[k] - centroids.min[k];
+            if (extent <= 0.f)
+                continue;
+            const float scale = float(NumBins) / extent;
+            std::array<Bin, NumBins> bins;
+            for (size_t i = begin; i < end; ++ i) {
+                Bin &bin = bins[std::min(int((m_items[i].centroid[k] - centroids.min[k]) * scale), NumBins - 1)];
+                bin.bounds.extend(m_items[i].min);
+                bin.bounds.extend(m_items[i].max);
+                ++ bin.count;
+            }
+            // Cost of the items on the right of the splits, sweeping from the right.
+            std::array<float, NumBins> right_cost;
+            Bounds right;
+            size_t right_count = 0;
+            for (int i = NumBins - 1; i > 0; -- i) {
+                right.extend(bins[i].bounds);
+                right_count += bins[i].count;
+                right_cost[i] = right.half_area() * float(right_count);
+            }
+            Bounds left;
+            size_t left_count = 0;
+            for (int i = 1; i < NumBins; ++ i) {
+                left.extend(bins[i - 1].bounds);
+                left_count += bins[i - 1].count;
+                if (left_count == 0 || left_count == count)
+                    continue;
+                const float cost = TraversalCost + (left.half_area() * float(left_count) + right_cost[i]) / bounds.half_area();
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = k;
+                    best_bin  = i;
+                }
+            }
+        }
+        if (best_axis == -1 || (best_cost >= leaf_cost && count <= MaxLeafSize))
+            return begin;
+        axis = best_axis;
+        const float min   = centroids.min[axis];
+        const float scale = float(NumBins) / (centroids.max[axis] - min);
+        auto it = std::partition(m_items.begin() + begin, m_items.begin() + end, [axis, min, scale, best_bin](const BuildItem &item) {
+            return std::min(int((item.centroid[axis] - min) * scale), NumBins - 1) < best_bin;
+        });
+        return size_t(it - m_items.begin());
+    }
+
+    // Splits the items in halves along the longest extent of the centroids.
+    size_t partition_median(size_t begin, size_t end, const Bounds &centroids, int &axis)
+    {
+        (centroids.max - centroids.min).maxCoeff(&axis);
+        const size_t mid = (begin + end) / 2;
+        std::nth_element(m_items.begin() + begin, m_items.begin() + mid, m_items.begin() + end,
+            [axis](const BuildItem &l, const BuildItem &r) { return l.centroid[axis] < r.centroid[axis]; });
+        return mid;
+    }
+
+    const indexed_triangle_set &m_its;
+    std::vector<Node>          &m_nodes;
+    std::vector<Triangle>      &m_triangles;
+    std::vector<BuildItem>      m_items;
+    float                       m_pad { 0 };
+};
+
+} // namespace
+
+RayPacketBVH::RayPacketBVH(const indexed_triangle_set &its)
+{
+    Builder(its, m_nodes, m_triangles).build();
+}
+
+// Lanes of the kernels. The operations are evaluated in the same order by all the kernels and min / max treat NaNs the same way
+// as the SSE instructions, so that all the kernels return the same hits.
+
+struct LanesScalar
+{
+    static constexpr const int W = 4;
+    struct V { float v[W]; };
+    struct M { bool v[W]; };
+
+    template<typename Fn> static V map(Fn fn) { V out; for (int i = 0; i < W; ++ i) out.v[i] = fn(i); return out; }
+    template<typename Fn> static M test(Fn fn) { M out; for (int i = 0; i < W; ++ i) out.v[i] = fn(i); return out; }
+
+    static V    set1(float a) { return map([a](int) { return a; }); }
+    static V    load(const float *p) { return map([p](int i) { return p[i]; }); }
+    static void store(float *p, const V &a) { for (int i = 0; i < W; ++ i) p[i] = a.v[i]; }
+    static V    add(const V &a, const V &b) { return map([&](int i) { return a.v[i] + b.v[i]; }); }
+    static V    sub(const V &a, const V &b) { return map([&](int i) { return a.v[i] - b.v[i]; }); }
+    static V    mul(const V &a, const V &b) { return map([&](int i) { return a.v[i] * b.v[i]; }); }
+    static V    div(const V &a, const V &b) { return map([&](int i) { return a.v[i] / b.v[i]; }); }
+    static V    min(const V &a, const V &b) { return map([&](int i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; }); }
+    static V    max(const V &a, const V &b) { return map([&](int i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; }); }
+    static M    lt(const V &a, const V &b) { return test([&](int i) { return a.v[i] < b.v[i]; }); }
+    static M    le(const V &a, const V &b) { return test([&](int i) { return a.v[i] <= b.v[i]; }); }
+    static M    and_(const M &a, const M &b) { return test([&](int i) { return a.v[i] && b.v[i]; }); }
+    static V    select(const M &m, const V &a, const V &b) { return map([&](int i) { return m.v[i] ? a.v[i] : b.v[i]; }); }
+    static int  movemask(const M &m) { int out = 0; for (int i = 0; i < W; ++ i) out |= int(m.v[i]) << i; return out; }
+};
+
+#ifdef SLIC3R_RAY_PACKET_SSE
+struct LanesSSE
+{
+    static constexpr const int W = 4;
+    using V = __m128;
+    using M = __m128;
+
+    static V    set1(float a) { return _mm_set1_ps(a); }
+    static V    load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, V a) { _mm_storeu_ps(p, a); }
+    static V    add(V a, V b) { return _mm_add_ps(a, b); }
+    static V    sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V    mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V    div(V a, V b) { return _mm_div_ps(a, b); }
+    static V    min(V a, V b) { return _mm_min_ps(a, b); }
+    static V    max(V a, V b) { return _mm_max_ps(a, b); }
+    static M    lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static M    le(V a, V b) { return _mm_cmple_ps(a, b); }
+    static M    and_(M a, M b) { return _mm_and_ps(a, b); }
+    static V    select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static int  movemask(M m) { return _mm_movemask_ps(m); }
+};
+#endif // SLIC3R_RAY_PACKET_SSE
+
+#ifdef SLIC3R_RAY_PACKET_AVX2
+struct LanesAVX2
+{
+    static constexpr const int W = 8;
+    using V = __m256;
+    using M = __m256;
+
+    SLIC3R_TARGET_AVX2 static V    set1(float a) { return _mm256_set1_ps(a); }
+    SLIC3R_TARGET_AVX2 static V    load(const float *p) { return _mm256_loadu_ps(p); }
+    SLIC3R_TARGET_AVX2 static void store(float *p, V a) { _mm256_storeu_ps(p, a); }
+    SLIC3R_TARGET_AVX2 static V    add(V a, V b) { return _mm256_add_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    div(V a, V b) { return _mm256_div_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    min(V a, V b) { return _mm256_min_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    max(V a, V b) { return _mm256_max_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static M    lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    SLIC3R_TARGET_AVX2 static M    le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    SLIC3R_TARGET_AVX2 static M    and_(M a, M b) { return _mm256_and_ps(a, b); }
+    SLIC3R_TARGET_AVX2 static V    select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    SLIC3R_TARGET_AVX2 static int  movemask(M m) { return _mm256_movemask_ps(m); }
+};
+#endif // SLIC3R_RAY_PACKET_AVX2
+
+#ifdef SLIC3R_RAY_PACKET_NEON
+struct LanesNEON
+{
+    static constexpr const int W = 4;
+    using V = float32x4_t;
+    using M = uint32x4_t;
+
+    static V    set1(float a) { return vdupq_n_f32(a); }
+    static V    load(const float *p) { return vld1q_f32(p); }
+    static void store(float *p, V a) { vst1q_f32(p, a); }
+    static V    add(V a, V b) { return vaddq_f32(a, b); }
+    static V    sub(V a, V b) { return vsubq_f32(a, b); }
+    static V    mul(V a, V b) { return vmulq_f32(a, b); }
+    static V    div(V a, V b) { return vdivq_f32(a, b); }
+    // vminq_f32 / vmaxq_f32 return NaN if any of the arguments is NaN, unlike the SSE instructions.
+    static V    min(V a, V b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+    static V    max(V a, V b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+    static M    lt(V a, V b) { return vcltq_f32(a, b); }
+    static M    le(V a, V b) { return vcleq_f32(a, b); }
+    static M    and_(M a, M b) { return vandq_u32(a, b); }
+    static V    select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+    static int  movemask(M m) {
+        static const uint32_t bits[4] = { 1, 2, 4, 8 };
+        return int(vaddvq_u32(vandq_u32(m, vld1q_u32(bits))));
+    }
+};
+#endif // SLIC3R_RAY_PACKET_NEON
+
+static inline int lowest_bit(int mask)
+{
+    assert(mask != 0);
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, (unsigned long)mask);
+    return int(idx);
+#else
+    return __builtin_ctz((unsigned int)mask);
+#endif
+}
+
+// Lanes [begin, begin + L::W) of a packet. The lanes past the end of the packet never hit anything.
+template<typename L>
+struct PacketLanes
+{
+    using V = typename L::V;
+    using M = typename L::M;
+
+    V origin[3];
+    V dir[3];
+    V inv_dir[3];
+    // Ray parameter of the closest hit so far, infinity for the active lanes without any hit, negative for the inactive lanes.
+    V t_max;
+    // Bounds of the barycentric coordinates of the hits, see EdgeTolerance.
+    V min_uv;
+    V max_uv_sum;
+
+    PacketLanes(const Packet &packet, size_t begin, float edge_tolerance)
+    {
+        min_uv     = L::set1(- edge_tolerance);
+        max_uv_sum = L::set1(1.f + edge_tolerance);
+        for (int k = 0; k < 3; ++ k) {
+            origin[k]  = L::load(packet.origin[k] + begin);
+            dir[k]     = L::load(packet.dir[k] + begin);
+            inv_dir[k] = L::div(L::set1(1.f), dir[k]);
+        }
+        float t[L::W];
+        for (int i = 0; i < L::W; ++ i)
+            t[i] = begin + i < packet.size ? std::numeric_limits<float>::infinity() : -1.f;
+        t_max = L::load(t);
+    }
+
+    // Slab test of the lanes against the bounding box of a node.
+    M hits_box(const Node &node) const
+    {
+        V t_enter = L::set1(0.f);
+        V t_exit  = t_max;
+        for (int k = 0; k < 3; ++ k) {
+            V t0 = L::mul(L::sub(L::set1(node.min[k]), origin[k]), inv_dir[k]);
+            V t1 = L::mul(L::sub(L::set1(node.max[k]), origin[k]), inv_dir[k]);
+            t_enter = L::max(t_enter, L::min(t0, t1));
+            t_exit  = L::min(t_exit,  L::max(t0, t1));
+        }
+        return L::le(t_enter, t_exit);
+    }
+
+    // Moeller - Trumbore test of the lanes against a triangle, hits at positive ray parameter below t_max.
+    M hits_triangle(const Triangle &tri, V &t) const
+    {
+        const V e1[3] = { L::set1(tri.e1[0]), L::set1(tri.e1[1]), L::set1(tri.e1[2]) };
+        const V e2[3] = { L::set1(tri.e2[0]), L::set1(tri.e2[1]), L::set1(tri.e2[2]) };
+        const V p[3]  = { L::sub(L::mul(dir[1], e2[2]), L::mul(dir[2], e2[1])),
+                          L::sub(L::mul(dir[2], e2[0]), L::mul(dir[0], e2[2])),
+                          L::sub(L::mul(dir[0], e2[1]), L::mul(dir[1], e2[0])) };
+        const V det     = L::add(L::add(L::mul(e1[0], p[0]), L::mul(e1[1], p[1])), L::mul(e1[2], p[2]));
+        // Infinite for the rays parallel to the triangle, then u, v or t are not finite and the tests below fail.
+        const V inv_det = L::div(L::set1(1.f), det);
+        const V s[3]    = { L::sub(origin[0], L::set1(tri.v0[0])), L::sub(origin[1], L::set1(tri.v0[1])), L::sub(origin[2], L::set1(tri.v0[2])) };
+        const V u       = L::mul(L::add(L::add(L::mul(s[0], p[0]), L::mul(s[1], p[1])), L::mul(s[2], p[2])), inv_det);
+        const V q[3]    = { L::sub(L::mul(s[1], e1[2]), L::mul(s[2], e1[1])),
+                            L::sub(L::mul(s[2], e1[0]), L::mul(s[0], e1[2])),
+                            L::sub(L::mul(s[0], e1[1]), L::mul(s[1], e1[0])) };
+        const V v       = L::mul(L::add(L::add(L::mul(dir[0], q[0]), L::mul(dir[1], q[1])), L::mul(dir[2], q[2])), inv_det);
+        t               = L::mul(L::add(L::add(L::mul(e2[0], q[0]), L::mul(e2[1], q[1])), L::mul(e2[2], q[2])), inv_det);
+        const V zero    = L::set1(0.f);
+        return L::and_(L::and_(L::and_(L::le(min_uv, u), L::le(min_uv, v)), L::le(L::add(u, v), max_uv_sum)),
+                       L::and_(L::lt(zero, t), L::lt(t, t_max)));
+    }
+
+    // Calls hit_fn(lanes hit, triangle, t) for the triangles of the leaves reached by any of the lanes.
+    // The traversal descends into the nearer child first by the direction of the first lane hitting the node.
+    template<typename HitFn>
+    void traverse(const std::vector<Node> &nodes, const std::vector<Triangle> &triangles, const Packet &packet, size_t begin, HitFn hit_fn)
+    {
+        uint32_t stack[TraversalStackSize];
+        int      stack_size = 0;
+        stack[stack_size ++] = 0;
+        while (stack_size > 0) {
+            const Node &node = nodes[stack[-- stack_size]];
+            const int   mask = L::movemask(this->hits_box(node));
+            if (mask == 0)
+                continue;
+            if (node.count > 0) {
+                for (uint32_t i = node.index; i < node.index + node.count; ++ i) {
+                    V         t;
+                    const M   hit      = this->hits_triangle(triangles[i], t);
+                    const int hit_mask = L::movemask(hit);
+                    if (hit_mask != 0)
+                        hit_fn(hit_mask, hit, triangles[i], t);
+                }
+            } else {
+                assert(stack_size + 2 <= TraversalStackSize);
+                const uint32_t negative = packet.dir[node.axis][begin + lowest_bit(mask)] < 0.f;
+                // Far child first, it is popped last.
+                stack[stack_size ++] = node.index + 1 - negative;
+                stack[stack_size ++] = node.index + negative;
+            }
+        }
+    }
+};
+
+template<typename L>
+static inline void trace_first_hits(const std::vector<Node> &nodes, const std::vector<Triangle> &triangles, const Packet &packet, int *ids, float *ts)
+{
+    for (size_t begin = 0; begin < packet.size; begin += L::W) {
+        PacketLanes<L> lanes(packet, begin, EdgeTolerance);
+        int            lane_ids[L::W];
+        std::fill(lane_ids, lane_ids + L::W, -1);
+        lanes.traverse(nodes, triangles, packet, begin, [&lanes, &lane_ids](int hit_mask, const typename L::M &hit, const Triangle &tri, const typename L::V &t) {
+            // Shorten the rays to the hits.
+            lanes.t_max = L::select(hit, t, lanes.t_max);
+            for (int mask = hit_mask; mask != 0; mask &= mask - 1)
+                lane_ids[lowest_bit(mask)] = tri.id;
+        });
+        float t_max[L::W];
+        L::store(t_max, lanes.t_max);
+        for (size_t i = 0; i < size_t(L::W) && begin + i < packet.size; ++ i) {
+            ids[begin + i] = lane_ids[i];
+            ts[begin + i]  = lane_ids[i] == -1 ? std::numeric_limits<float>::infinity() : t_max[i];
+        }
+    }
+}
+
+template<typename L>
+static inline void trace_all_hits(const std::vector<Node> &nodes, const std::vector<Triangle> &triangles, const Packet &packet, std::vector<RayPacketBVH::Hit> &hits)
+{
+    for (size_t begin = 0; begin < packet.size; begin += L::W) {
+        PacketLanes<L> lanes(packet, begin, 0.f);
+        lanes.traverse(nodes, triangles, packet, begin, [begin, &hits](int hit_mask, const typename L::M &, const Triangle &tri, const typename L::V &t) {
+            float ts[L::W];
+            L::store(ts, t);
+            for (int mask = hit_mask; mask != 0; mask &= mask - 1) {
+                const int lane = lowest_bit(mask);
+                hits.push_back({ int(begin) + lane, tri.id, ts[lane] });
+            }
+        });
+    }
+}
+
+#ifdef SLIC3R_RAY_PACKET_AVX2
+SLIC3R_TARGET_AVX2_FLATTEN static void trace_first_hits_avx2(const std::vector<Node> &nodes, const std::vector<Triangle> &triangles, const Packet &packet, int *ids, float *ts)
+{
+    trace_first_hits<LanesAVX2>(nodes, triangles, packet, ids, ts);
+}
+
+SLIC3R_TARGET_AVX2_FLATTEN static void trace_all_hits_avx2(const std::vector<Node> &nodes, const std::vector<Triangle> &triangles, const Packet &packet, std::vector<RayPacketBVH::Hit> &hits)
+{
+    trace_all_hits<LanesAVX2>(nodes, triangles, packet, hits);
+}
+#endif // SLIC3R_RAY_PACKET_AVX2
+
+static RayPacketKernel best_ray_packet_kernel()
+{
+#if defined(SLIC3R_RAY_PACKET_AVX2)
+    if (cpu_supports_avx2())
+        return RayPacketKernel::AVX2;
+#endif
+#if defined(SLIC3R_RAY_PACKET_SSE)
+    return RayPacketKernel::SSE;
+#elif defined(SLIC3R_RAY_PACKET_NEON)
+    // NEON is mandatory on aarch64.
+    return RayPacketKernel::NEON;
+#else
+    return RayPacketKernel::Scalar;
+#endif
+}
+
+static std::atomic<RayPacketKernel> s_ray_packet_kernel { best_ray_packet_kernel() };
+
+RayPacketKernel ray_packet_kernel()
+{
+    return s_ray_packet_kernel.load(std::memory_order_relaxed);
+}
+
+bool set_ray_packet_kernel(RayPacketKernel kernel)
+{
+    bool supported = kernel == RayPacketKernel::Scalar;
+#if defined(SLIC3R_RAY_PACKET_SSE)
+    supported |= kernel == RayPacketKernel::SSE;
+#endif
+#if defined(SLIC3R_RAY_PACKET_AVX2)
+    supported |= kernel == RayPacketKernel::AVX2 && cpu_supports_avx2();
+#endif
+#if defined(SLIC3R_RAY_PACKET_NEON)
+    supported |= kernel == RayPacketKernel::NEON;
+#endif
+    if (supported)
+        s_ray_packet_kernel.store(kernel, std::memory_order_relaxed);
+    return supported;
+}
+
+void RayPacketBVH::first_hits(const Packet &packet, int *ids, float *ts) const
+{
+    if (this->empty()) {
+        std::fill(ids, ids + packet.size, -1);
+        std::fill(ts, ts + packet.size, std::numeric_limits<float>::infinity());
+        return;
+    }
+    switch (ray_packet_kernel()) {
+#ifdef SLIC3R_RAY_PACKET_AVX2
+    case RayPacketKernel::AVX2: trace_first_hits_avx2(m_nodes, m_triangles, packet, ids, ts); break;
+#endif
+#ifdef SLIC3R_RAY_PACKET_SSE
+    case RayPacketKernel::SSE:  trace_first_hits<LanesSSE>(m_nodes, m_triangles, packet, ids, ts); break;
+#endif
+#ifdef SLIC3R_RAY_PACKET_NEON
+    case RayPacketKernel::NEON: trace_first_hits<LanesNEON>(m_nodes, m_triangles, packet, ids, ts); break;
+#endif
+    default:                    trace_first_hits<LanesScalar>(m_nodes, m_triangles, packet, ids, ts); break;
+    }
+}
+
+void RayPacketBVH::all_hits(const Packet &packet, std::vector<Hit> &hits) const
+{
+    if (this->empty())
+        return;
+    switch (ray_packet_kernel()) {
+#ifdef SLIC3R_RAY_PACKET_AVX2
+    case RayPacketKernel::AVX2: trace_all_hits_avx2(m_nodes, m_triangles, packet, hits); break;
+#endif
+#ifdef SLIC3R_RAY_PACKET_SSE
+    case RayPacketKernel::SSE:  trace_all_hits<LanesSSE>(m_nodes, m_triangles, packet, hits); break;
+#endif
+#ifdef SLIC3R_RAY_PACKET_NEON
+    case RayPacketKernel::NEON: trace_all_hits<LanesNEON>(m_nodes, m_triangles, packet, hits); break;
+#endif
+    default:                    trace_all_hits<LanesScalar>(m_nodes, m_triangles, packet, hits); break;
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,122 @@
+#ifndef slic3r_RayPacketBVH_hpp_
+#define slic3r_RayPacketBVH_hpp_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <admesh/stl.h>
+
+#include "Point.hpp"
+
+namespace Slic3r {
+
+// Instruction set of the kernels tracing ray packets through RayPacketBVH.
+// All the kernels return the same hits, the fastest kernel supported by the CPU is selected at startup.
+enum class RayPacketKernel {
+    // 4 rays at a time without SIMD instructions.
+    Scalar,
+    // 4 rays at a time.
+    SSE,
+    // 8 rays at a time.
+    AVX2,
+    // 4 rays at a time.
+    NEON,
+};
+
+RayPacketKernel ray_packet_kernel();
+// Select a kernel for testing and benchmarking. Returns false and keeps the active kernel if the CPU does not support it.
+bool            set_ray_packet_kernel(RayPacketKernel kernel);
+
+// Bounding volume hierarchy over an indexed triangle set for tracing packets of rays, for example the rays
+// of the visibility estimation of the seam placer.
+//
+// The hierarchy is split by the surface area heuristic, which traverses faster than the balanced
+// AABBTreeIndirect::Tree. The rays of a packet are tested against a bounding box or a triangle at once
+// with SIMD instructions, thus the packets should contain rays close to each other, ideally from
+// a common origin. The intersections are calculated in single precision, the rays do not need to be normalized.
+//
+// Immutable once built, thus thread safe.
+class RayPacketBVH
+{
+public:
+    static constexpr const size_t PacketSize = 8;
+
+    // Up to PacketSize rays, structure of arrays.
+    struct Packet
+    {
+        size_t size { 0 };
+        float  origin[3][PacketSize] {};
+        float  dir[3][PacketSize] {};
+
+        bool   empty() const { return size == 0; }
+        bool   full() const { return size == PacketSize; }
+        void   clear() { size = 0; }
+        void   push_back(const Vec3f &ray_origin, const Vec3f &ray_dir) {
+            assert(! this->full());
+            for (int i = 0; i < 3; ++ i) {
+                origin[i][size] = ray_origin[i];
+                dir[i][size]    = ray_dir[i];
+            }
+            ++ size;
+        }
+        Vec3f  ray_origin(size_t ray) const { return { origin[0][ray], origin[1][ray], origin[2][ray] }; }
+        Vec3f  ray_dir(size_t ray) const { return { dir[0][ray], dir[1][ray], dir[2][ray] }; }
+    };
+
+    struct Hit
+    {
+        // Index of the ray in its packet.
+        int   ray;
+        // Index of the triangle hit.
+        int   id;
+        // Ray parameter of the hit.
+        float t;
+    };
+
+    RayPacketBVH() = default;
+    explicit RayPacketBVH(const indexed_triangle_set &its);
+
+    bool   empty() const { return m_nodes.empty(); }
+    size_t num_nodes() const { return m_nodes.size(); }
+
+    // First hits of the rays at positive ray parameter. ids[ray] is the index of the triangle hit by the ray or -1,
+    // ts[ray] its ray parameter. Both arrays have to hold packet.size elements.
+    void   first_hits(const Packet &packet, int *ids, float *ts) const;
+    // All hits of the rays at positive ray parameter, in no particular order. The hits are appended.
+    // If a ray hits a shared edge of two triangles, hits for both triangles may be returned.
+    void   all_hits(const Packet &packet, std::vector<Hit> &hits) const;
+
+    // Implementation detail, public for the kernels.
+    struct Node
+    {
+        float    min[3];
+        // Internal node: index of the first child, the second child follows. Leaf: index of the first triangle.
+        uint32_t index;
+        float    max[3];
+        // Internal node: 0. Leaf: number of triangles.
+        uint16_t count;
+        // Internal node: axis splitting the children, the first child is on the lower side.
+        uint16_t axis;
+    };
+
+    struct Triangle
+    {
+        float v0[3];
+        // Edges v1 - v0 and v2 - v0.
+        float e1[3];
+        float e2[3];
+        // Index of the triangle in the indexed triangle set.
+        int   id;
+    };
+
+private:
+    std::vector<Node>     m_nodes;
+    // In the order of the leaves.
+    std::vector<Triangle> m_triangles;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_RayPacketBVH_hpp_
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <cassert>
 
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
 // Naive implementation of the Traveling Salesman Problem, it works by always taking the next closest neighbor.
@@ -998,11 +1000,256 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy2(SegmentEndPointFunc
 	return chain_segments_greedy_constrained_reversals2_<PointType, SegmentEndPointFunc, false, decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
 }
 
+// The greedy chaining slows down more than linearly with the number of segments, larger sets of segments are chained by tiles.
+static constexpr const size_t chain_tiled_min_segments = 4096;
+// Approximate number of segments of a tile.
+static constexpr const size_t chain_tile_segments      = 1024;
+// Number of the closest end points, to which improve_chain_by_two_opt() tries to reconnect an end point of a connection.
+static constexpr const size_t chain_two_opt_neighbors  = 8;
+// Work of improve_chain_by_two_opt() per segment at most: the number of evaluated moves and of segments reversed by the applied moves.
+// The budget is not a wall clock time to keep the G-code reproducible.
+static constexpr const size_t chain_two_opt_max_work   = 256;
+
+// Improve a chain by 2-opt moves: The segments between two connections are traversed backwards if the two new connections
+// are shorter than the two old ones. An end point of a connection is only reconnected to the end points closest to it, thus
+// a chain of tens of thousands of segments is improved in about linear time. A run of segments is only reversed if all
+// its segments could be reversed, and if it is not longer than a tile. The first segment of the chain is kept.
+// Used to shorten the connections between the tiles and inside the tiles chained by chain_segments_tiled().
+template<typename SegmentEndPointFunc, typename CouldReverseFunc>
+static void improve_chain_by_two_opt(std::vector<std::pair<size_t, bool>> &chain, SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func)
+{
+	const size_t num_segments = chain.size();
+	if (num_segments < 3)
+		return;
+
+	// Position of a segment in the chain.
+	std::vector<size_t> position(num_segments);
+	for (size_t i = 0; i < num_segments; ++ i)
+		position[chain[i].first] = i;
+	// Number of the segments, which could not be reversed, before a position in the chain.
+	// Such segments never move, as only the runs of segments, which all could be reversed, are reversed.
+	std::vector<size_t> num_fixed_before(num_segments + 1, 0);
+	for (size_t i = 0; i < num_segments; ++ i)
+		num_fixed_before[i + 1] = num_fixed_before[i] + (could_reverse_func(chain[i].first) ? 0 : 1);
+
+	auto start_point = [&chain, &end_point_func](size_t pos) -> const Point& { return end_point_func(chain[pos].first, ! chain[pos].second); };
+	auto end_point   = [&chain, &end_point_func](size_t pos) -> const Point& { return end_point_func(chain[pos].first, chain[pos].second); };
+	auto distance    = [](const Point &p1, const Point &p2) { return (p2 - p1).cast<double>().norm(); };
+	// Connection i starts at the end of the segment at position i. The last segment has no connection.
+	auto connection_length = [&](size_t i) { return i + 1 < num_segments ? distance(end_point(i), start_point(i + 1)) : 0.; };
+
+	// End point 2 * i is the first point of the segment i, end point 2 * i + 1 is its last point.
+	// Sort the end points into the cells of a grid with about two end points per cell.
+	const size_t num_end_points = 2 * num_segments;
+	auto         end_point_of   = [&end_point_func](size_t idx) -> const Point& { return end_point_func(idx / 2, (idx & 1) == 0); };
+	BoundingBox  bbox;
+	for (size_t idx = 0; idx < num_end_points; ++ idx)
+		bbox.merge(end_point_of(idx));
+	const double width     = double(bbox.size().x()) + 1.;
+	const double height    = double(bbox.size().y()) + 1.;
+	const double cell_size = std::max({ std::sqrt(2. * width * height / double(num_end_points)), 2. * std::max(width, height) / double(num_end_points), 1. });
+	const size_t cols      = size_t(width / cell_size) + 1;
+	const size_t rows      = size_t(height / cell_size) + 1;
+	auto         cell_of   = [&bbox, cell_size](const Point &pt) { return Vec2i64(int64_t(double(pt.x() - bbox.min.x()) / cell_size), int64_t(double(pt.y() - bbox.min.y()) / cell_size)); };
+	std::vector<size_t> cell_begin(cols * rows + 1, 0);
+	std::vector<size_t> cell_end_points(num_end_points);
+	for (size_t idx = 0; idx < num_end_points; ++ idx) {
+		Vec2i64 cell = cell_of(end_point_of(idx));
+		++ cell_begin[size_t(cell.y()) * cols + size_t(cell.x()) + 1];
+	}
+	for (size_t i = 1; i < cell_begin.size(); ++ i)
+		cell_begin[i] += cell_begin[i - 1];
+	{
+		std::vector<size_t> cell_end(cell_begin.begin(), cell_begin.end() - 1);
+		for (size_t idx = 0; idx < num_end_points; ++ idx) {
+			Vec2i64 cell = cell_of(end_point_of(idx));
+			cell_end_points[cell_end[size_t(cell.y()) * cols + size_t(cell.x())] ++] = idx;
+		}
+	}
+	// Find the closest end points of each end point in the 5x5 cells around it.
+	static constexpr const size_t npos = std::numeric_limits<size_t>::max();
+	std::vector<std::array<size_t, chain_two_opt_neighbors>> neighbors(num_end_points);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, num_end_points), [&](const tbb::blocked_range<size_t> &range) {
+		std::vector<std::pair<double, size_t>> found;
+		for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
+			const Point   &pt   = end_point_of(idx);
+			const Vec2i64  cell = cell_of(pt);
+			found.clear();
+			for (int64_t row = std::max<int64_t>(cell.y() - 2, 0); row <= std::min<int64_t>(cell.y() + 2, int64_t(rows) - 1); ++ row)
+				for (int64_t col = std::max<int64_t>(cell.x() - 2, 0); col <= std::min<int64_t>(cell.x() + 2, int64_t(cols) - 1); ++ col)
+					for (size_t i = cell_begin[size_t(row) * cols + size_t(col)]; i < cell_begin[size_t(row) * cols + size_t(col) + 1]; ++ i)
+						if (size_t idx2 = cell_end_points[i]; idx2 != idx)
+							found.emplace_back((end_point_of(idx2) - pt).template cast<double>().squaredNorm(), idx2);
+			const size_t num_found = std::min(found.size(), chain_two_opt_neighbors);
+			std::partial_sort(found.begin(), found.begin() + num_found, found.end());
+			neighbors[idx].fill(npos);
+			for (size_t i = 0; i < num_found; ++ i)
+				neighbors[idx][i] = found[i].second;
+		}
+	});
+
+	size_t budget = chain_two_opt_max_work * num_segments;
+	// Replace the connections i and j by connecting the end points at i and j and the start points at i + 1 and j + 1,
+	// which reverses the segments from i + 1 to j. Returns true if the chain was improved.
+	auto try_two_opt_move = [&](size_t i, size_t j) {
+		if (i > j)
+			std::swap(i, j);
+		if (i == j || j - i > std::min(chain_tile_segments, budget) || num_fixed_before[j + 1] != num_fixed_before[i + 1])
+			return false;
+		const double length_old = connection_length(i) + connection_length(j);
+		const double length_new = distance(end_point(i), end_point(j)) + (j + 1 < num_segments ? distance(start_point(i + 1), start_point(j + 1)) : 0.);
+		if (length_new + SCALED_EPSILON > length_old)
+			return false;
+		budget -= j - i;
+		std::reverse(chain.begin() + i + 1, chain.begin() + j + 1);
+		for (size_t k = i + 1; k <= j; ++ k) {
+			chain[k].second = ! chain[k].second;
+			position[chain[k].first] = k;
+		}
+		return true;
+	};
+
+	for (bool improved = true; improved && budget > 0;) {
+		improved = false;
+		for (size_t i = 0; i + 1 < num_segments && budget > 0; ++ i) {
+			const double length = connection_length(i);
+			bool         moved  = false;
+			// Reconnect the end point at i to the end point of another segment, or the start point at i + 1 to the start point of another segment.
+			for (bool from_end_point : { true, false }) {
+				const Point &pt = from_end_point ? end_point(i) : start_point(i + 1);
+				const size_t pt_idx = from_end_point ? 2 * chain[i].first + (chain[i].second ? 0 : 1) : 2 * chain[i + 1].first + (chain[i + 1].second ? 1 : 0);
+				for (size_t idx : neighbors[pt_idx]) {
+					if (idx == npos || budget == 0 || distance(pt, end_point_of(idx)) >= length)
+						break;
+					-- budget;
+					const size_t pos = position[idx / 2];
+					// Is the neighbor an end point or a start point of its segment in the chain?
+					const bool   neighbor_is_end_point = ((idx & 1) == 0) == chain[pos].second;
+					if (from_end_point == neighbor_is_end_point && (from_end_point || pos > 0) &&
+						try_two_opt_move(i, from_end_point ? pos : pos - 1)) {
+						moved = true;
+						break;
+					}
+				}
+				if (moved)
+					break;
+			}
+			improved |= moved;
+		}
+	}
+}
+
+// Chain a large number of segments: The segments are split into the tiles of a regular grid by their centers, the segments of each tile
+// are chained in parallel by chain_tile_func(end_point_func, could_reverse_func, num_segments, start_near), then the chains of the tiles
+// are chained. The tile with the segment closest to start_near is chained first starting near start_near.
+// A chain of a tile is only traversed backwards if all its segments could be reversed.
+template<typename SegmentEndPointFunc, typename CouldReverseFunc, typename ChainTileFunc>
+std::vector<std::pair<size_t, bool>> chain_segments_tiled(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const Point *start_near, ChainTileFunc chain_tile_func)
+{
+	// Centers of the segments, doubled to stay in integers.
+	std::vector<Vec2i64> centers;
+	centers.reserve(num_segments);
+	Vec2i64 min(std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max());
+	Vec2i64 max(std::numeric_limits<int64_t>::lowest(), std::numeric_limits<int64_t>::lowest());
+	for (size_t i = 0; i < num_segments; ++ i) {
+		centers.emplace_back(end_point_func(i, true).template cast<int64_t>() + end_point_func(i, false).template cast<int64_t>());
+		min = min.cwiseMin(centers.back());
+		max = max.cwiseMax(centers.back());
+	}
+	const size_t num_tiles_min = (num_segments + chain_tile_segments - 1) / chain_tile_segments;
+	const double width         = double(max.x() - min.x()) + 1.;
+	const double height        = double(max.y() - min.y()) + 1.;
+	const size_t cols          = std::clamp<size_t>(size_t(std::round(std::sqrt(double(num_tiles_min) * width / height))), 1, num_tiles_min);
+	const size_t rows          = std::clamp<size_t>(size_t(std::round(std::sqrt(double(num_tiles_min) * height / width))), 1, num_tiles_min);
+
+	// Sort the segments by tiles.
+	std::vector<size_t> tile_of_segment(num_segments);
+	std::vector<size_t> tile_begin(cols * rows + 1, 0);
+	for (size_t i = 0; i < num_segments; ++ i) {
+		size_t col = std::min(cols - 1, size_t(double(centers[i].x() - min.x()) * double(cols) / width));
+		size_t row = std::min(rows - 1, size_t(double(centers[i].y() - min.y()) * double(rows) / height));
+		tile_of_segment[i] = row * cols + col;
+		++ tile_begin[tile_of_segment[i] + 1];
+	}
+	for (size_t i = 1; i < tile_begin.size(); ++ i)
+		tile_begin[i] += tile_begin[i - 1];
+	std::vector<size_t> tile_segments(num_segments);
+	{
+		std::vector<size_t> tile_end(tile_begin.begin(), tile_begin.end() - 1);
+		for (size_t i = 0; i < num_segments; ++ i)
+			tile_segments[tile_end[tile_of_segment[i]] ++] = i;
+	}
+
+	// Tile to start with.
+	size_t first_tile = std::numeric_limits<size_t>::max();
+	if (start_near != nullptr) {
+		double dist2_min = std::numeric_limits<double>::max();
+		for (size_t i = 0; i < num_segments; ++ i)
+			for (bool first_point : { true, false })
+				if (double dist2 = (end_point_func(i, first_point) - *start_near).template cast<double>().squaredNorm(); dist2 < dist2_min) {
+					dist2_min  = dist2;
+					first_tile = tile_of_segment[i];
+				}
+	}
+
+	// Chain the segments of the tiles.
+	std::vector<std::vector<std::pair<size_t, bool>>> tile_chains(cols * rows);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tile_chains.size()), [&](const tbb::blocked_range<size_t> &range) {
+		for (size_t tile = range.begin(); tile < range.end(); ++ tile)
+			if (tile_begin[tile] < tile_begin[tile + 1]) {
+				const size_t *segments  = tile_segments.data() + tile_begin[tile];
+				auto tile_end_point     = [&end_point_func, segments](size_t idx, bool first_point) -> const Point& { return end_point_func(segments[idx], first_point); };
+				auto tile_could_reverse = [&could_reverse_func, segments](size_t idx) { return could_reverse_func(segments[idx]); };
+				std::vector<std::pair<size_t, bool>> chain = chain_tile_func(tile_end_point, tile_could_reverse, tile_begin[tile + 1] - tile_begin[tile],
+					tile == first_tile ? start_near : nullptr);
+				for (std::pair<size_t, bool> &segment : chain)
+					segment.first = segments[segment.first];
+				tile_chains[tile] = std::move(chain);
+			}
+	});
+
+	std::vector<std::pair<size_t, bool>> out;
+	out.reserve(num_segments);
+	const Point *chain_start_near = start_near;
+	if (first_tile != std::numeric_limits<size_t>::max()) {
+		out = std::move(tile_chains[first_tile]);
+		chain_start_near = &end_point_func(out.back().first, out.back().second);
+	}
+	tile_chains.erase(std::remove_if(tile_chains.begin(), tile_chains.end(), [](const auto &chain) { return chain.empty(); }), tile_chains.end());
+
+	// Chain the tiles.
+	auto chain_end_point = [&end_point_func, &tile_chains](size_t idx, bool first_point) -> const Point& {
+		const std::vector<std::pair<size_t, bool>> &chain = tile_chains[idx];
+		return first_point ? end_point_func(chain.front().first, ! chain.front().second) : end_point_func(chain.back().first, chain.back().second);
+	};
+	std::vector<char> chain_could_reverse;
+	chain_could_reverse.reserve(tile_chains.size());
+	for (const std::vector<std::pair<size_t, bool>> &chain : tile_chains)
+		chain_could_reverse.emplace_back(std::all_of(chain.begin(), chain.end(), [&could_reverse_func](const std::pair<size_t, bool> &segment) { return could_reverse_func(segment.first); }));
+	auto could_reverse_chain = [&chain_could_reverse](size_t idx) { return chain_could_reverse[idx] != 0; };
+	for (const std::pair<size_t, bool> &tile : chain_segments_greedy_constrained_reversals<Point, decltype(chain_end_point), decltype(could_reverse_chain)>(
+			chain_end_point, could_reverse_chain, tile_chains.size(), chain_start_near)) {
+		const std::vector<std::pair<size_t, bool>> &chain = tile_chains[tile.first];
+		if (tile.second)
+			for (auto it = chain.rbegin(); it != chain.rend(); ++ it)
+				out.emplace_back(it->first, ! it->second);
+		else
+			out.insert(out.end(), chain.begin(), chain.end());
+	}
+	assert(out.size() == num_segments);
+	improve_chain_by_two_opt(out, end_point_func, could_reverse_func);
+	return out;
+}
+
 std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near)
 {
 	auto segment_end_point = [&entities](size_t idx, bool first_point) -> const Point& { return first_point ? entities[idx]->first_point() : entities[idx]->last_point(); };
 	auto could_reverse = [&entities](size_t idx) { const ExtrusionEntity *ee = entities[idx]; return ee->is_loop() || ee->can_reverse(); };
-	std::vector<std::pair<size_t, bool>> out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near);
+	std::vector<std::pair<size_t, bool>> out = entities.size() < chain_tiled_min_segments ?
+		chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near) :
+		chain_segments_tiled(segment_end_point, could_reverse, entities.size(), start_near, [](auto end_point_func, auto could_reverse_func, size_t num_segments, const Point *start_near) {
+			return chain_segments_greedy_constrained_reversals<Point, decltype(end_point_func), decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
+		});
 	for (std::pair<size_t, bool> &segment : out) {
 		ExtrusionEntity *ee = entities[segment.first];
 		if (ee->is_loop())
@@ -1549,8 +1796,9 @@ static inline void do_crossover(const std::vector<FlipEdge> &edges_in, std::vect
 // Expected time complexity: O(min(n, 100) * (n * log n + k * n)
 // where n is the number of edges and k is the number of connection_lengths candidates after the first one
 // is found that improves the total cost.
+// The search gives up after evaluating max_evaluations crossovers to bound the running time for large n.
 //FIXME there are likley better heuristics to lower the time complexity.
-static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<FlipEdge> &edges)
+static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<FlipEdge> &edges, size_t max_evaluations = std::numeric_limits<size_t>::max())
 {
 	if (edges.size() < 2)
 		return;
@@ -1560,6 +1808,7 @@ static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<Fl
 	std::vector<std::pair<double, size_t>>	connection_lengths(edges.size() - 1, std::pair<double, size_t>(0., 0));
 	std::vector<char>						connection_tried(edges.size(), false);
 	const size_t 							max_iterations = std::min(edges.size(), size_t(100));
+	size_t 									num_evaluations = 0;
 	for (size_t iter = 0; iter < max_iterations; ++ iter) {
 		// Initialize connection costs and connection lengths.
 		for (size_t i = 1; i < edges.size(); ++ i) {
@@ -1586,6 +1835,9 @@ static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<Fl
 			size_t crossover_flip_min = 0;
 			for (size_t j = 1; j < connections.size(); ++ j)
 				if (! connection_tried[j]) {
+					if (++ num_evaluations > max_evaluations)
+						// Out of budget, keep the chain improved so far.
+						return;
 					size_t a = j;
 					size_t b = longest_connection_idx;
 					if (a > b)
@@ -1877,61 +2129,54 @@ static inline void reorder_by_three_exchanges_with_segment_flipping2(std::vector
 #endif
 
 // Flip the sequences of polylines to lower the total length of connecting lines.
+// Number of crossovers evaluated by improve_chain_by_two_exchanges_with_segment_flipping() at most,
+// which bounds the time spent improving a chain. The budget is not a wall clock time to keep the G-code reproducible.
+static constexpr const size_t chain_improve_max_evaluations = 10000;
+
+// Improve a chain of segments, which all could be reversed, by exchanges of the chain connections and by segment flipping.
+// The first segment of the chain is not kept.
 // Used by the infill generator if the infill is not connected with perimeter lines
 // and to order the brim lines.
-static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polylines &polylines, bool fixed_start)
+template<typename SegmentEndPointFunc>
+static void improve_chain_by_two_exchanges_with_segment_flipping(std::vector<std::pair<size_t, bool>> &chain, SegmentEndPointFunc end_point_func)
 {
+	if (chain.size() < 2)
+		return;
+
 #ifndef NDEBUG
-	auto cost = [&polylines]() {
+	auto cost = [&chain, &end_point_func]() {
 		double sum = 0.;
-		for (size_t i = 1; i < polylines.size(); ++i)
-			sum += (polylines[i].first_point() - polylines[i - 1].last_point()).cast<double>().norm();
+		for (size_t i = 1; i < chain.size(); ++i)
+			sum += (end_point_func(chain[i].first, ! chain[i].second) - end_point_func(chain[i - 1].first, chain[i - 1].second)).template cast<double>().norm();
 		return sum;
 	};
 	double cost_initial = cost();
-
-	static int iRun = 0;
-	++ iRun;
-#ifdef DEBUG_SVG_OUTPUT
-	svg_draw_polyline_chain("improve_ordering_by_two_exchanges_with_segment_flipping-initial", iRun, polylines);
-#endif /* DEBUG_SVG_OUTPUT */
 #endif /* NDEBUG */
 
 	std::vector<FlipEdge> edges;
-	edges.reserve(polylines.size());
-    std::transform(polylines.begin(), polylines.end(), std::back_inserter(edges), 
-    	[&polylines](const Polyline &pl){ return FlipEdge(pl.first_point().cast<double>(), pl.last_point().cast<double>(), &pl - polylines.data()); });
+	edges.reserve(chain.size());
+	for (const std::pair<size_t, bool> &segment : chain)
+		edges.emplace_back(end_point_func(segment.first, ! segment.second).template cast<double>(), end_point_func(segment.first, segment.second).template cast<double>(), segment.first);
 #if 1
-	reorder_by_two_exchanges_with_segment_flipping(edges);
+	reorder_by_two_exchanges_with_segment_flipping(edges, chain_improve_max_evaluations);
 #else
 	// reorder_by_three_exchanges_with_segment_flipping(edges);
 	reorder_by_three_exchanges_with_segment_flipping2(edges);
 #endif
-	Polylines out;
-	out.reserve(polylines.size());
-	for (const FlipEdge &edge : edges) {
-		Polyline &pl = polylines[edge.source_index];
-		out.emplace_back(pl);
-		if (edge.p2 == pl.first_point().cast<double>()) {
-			// Polyline is flipped.
-			out.back().reverse();
-		} else {
-			// Polyline is not flipped.
-			assert(edge.p1 == pl.first_point().cast<double>());
-		}
+	for (size_t i = 0; i < edges.size(); ++ i) {
+		const FlipEdge &edge = edges[i];
+		// Segment is flipped if its first point is not the start of the edge.
+		chain[i] = std::make_pair(edge.source_index, edge.p1 != end_point_func(edge.source_index, true).template cast<double>());
 	}
 
 #ifndef NDEBUG
 	double cost_final = cost();
-#ifdef DEBUG_SVG_OUTPUT
-	svg_draw_polyline_chain("improve_ordering_by_two_exchanges_with_segment_flipping-final", iRun, out);
-#endif /* DEBUG_SVG_OUTPUT */
-	assert(cost_final <= cost_initial);
+	assert(cost_final <= cost_initial + EPSILON);
 #endif /* NDEBUG */
 }
 
 // Used to optimize order of infill lines and brim lines.
-Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
+Polylines chain_polylines(Polylines &&polylines, const Point *start_near, bool improve_by_two_exchanges)
 {
 #ifdef DEBUG_SVG_OUTPUT
 	static int iRun = 0;
@@ -1942,17 +2187,26 @@ Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
 	Polylines out;
 	if (! polylines.empty()) {
 		auto segment_end_point = [&polylines](size_t idx, bool first_point) -> const Point& { return first_point ? polylines[idx].first_point() : polylines[idx].last_point(); };
-		std::vector<std::pair<size_t, bool>> ordered = chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
+		std::vector<std::pair<size_t, bool>> ordered;
+		if (polylines.size() < chain_tiled_min_segments) {
+			ordered = chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
+			if (improve_by_two_exchanges && start_near == nullptr)
+				improve_chain_by_two_exchanges_with_segment_flipping(ordered, segment_end_point);
+		} else {
+			auto could_reverse = [](size_t /* idx */) { return true; };
+			ordered = chain_segments_tiled(segment_end_point, could_reverse, polylines.size(), start_near, [improve_by_two_exchanges](auto end_point_func, auto /* could_reverse_func */, size_t num_segments, const Point *start_near) {
+				std::vector<std::pair<size_t, bool>> chain = chain_segments_greedy2<Point, decltype(end_point_func)>(end_point_func, num_segments, start_near);
+				if (improve_by_two_exchanges && start_near == nullptr)
+					improve_chain_by_two_exchanges_with_segment_flipping(chain, end_point_func);
+				return chain;
+			});
+		}
 		out.reserve(polylines.size()); 
 		for (auto &segment_and_reversal : ordered) {
 			out.emplace_back(std::move(polylines[segment_and_reversal.first]));
 			if (segment_and_reversal.second)
 				out.back().reverse();
 		}
-		if (out.size() > 1 && start_near == nullptr) {
-			improve_ordering_by_two_exchanges_with_segment_flipping(out, start_near != nullptr);
-			//improve_ordering_by_segment_flipping(out, start_near != nullptr);
-		}
 	}
 
 #ifdef DEBUG_SVG_OUTPUT
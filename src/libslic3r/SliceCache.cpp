@@ -0,0 +1,302 @@
+#include "SliceCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <ankerl/unordered_dense.h>
+
+namespace Slic3r {
+
+// Magic and version of the slices stored on disk.
+static constexpr const char     SLICE_CACHE_MAGIC[4] = { 'S', 'L', 'C', 'C' };
+static constexpr const uint32_t SLICE_CACHE_VERSION  = 1;
+
+SliceCache::Key::Key(uint64_t mesh_hash, const std::vector<float> &zs, const MeshSlicingParamsEx &params) :
+    mesh_hash(mesh_hash), trafo(params.trafo), zs(zs), mode(params.mode), mode_below(params.mode_below),
+    slicing_mode_normal_below_layer(params.slicing_mode_normal_below_layer),
+    closing_radius(params.closing_radius), extra_offset(params.extra_offset), resolution(params.resolution)
+{}
+
+bool SliceCache::Key::operator==(const Key &rhs) const
+{
+    return mesh_hash == rhs.mesh_hash && trafo.matrix() == rhs.trafo.matrix() && zs == rhs.zs &&
+           mode == rhs.mode && mode_below == rhs.mode_below && slicing_mode_normal_below_layer == rhs.slicing_mode_normal_below_layer &&
+           closing_radius == rhs.closing_radius && extra_offset == rhs.extra_offset && resolution == rhs.resolution;
+}
+
+uint64_t SliceCache::Key::hash() const
+{
+    auto hash_bytes = [](const void *data, size_t size) -> uint64_t {
+        return ankerl::unordered_dense::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(data), size));
+    };
+    size_t seed = 0;
+    boost::hash_combine(seed, mesh_hash);
+    boost::hash_combine(seed, hash_bytes(trafo.data(), sizeof(double) * 16));
+    boost::hash_combine(seed, hash_bytes(zs.data(), zs.size() * sizeof(float)));
+    boost::hash_combine(seed, uint32_t(mode));
+    boost::hash_combine(seed, uint32_t(mode_below));
+    boost::hash_combine(seed, slicing_mode_normal_below_layer);
+    boost::hash_combine(seed, closing_radius);
+    boost::hash_combine(seed, extra_offset);
+    boost::hash_combine(seed, resolution);
+    return uint64_t(seed);
+}
+
+// Approximate heap size of the slices including the cache entry.
+static size_t slices_memory(const std::vector<ExPolygons> &slices)
+{
+    size_t out = sizeof(std::vector<ExPolygons>) + slices.capacity() * sizeof(ExPolygons);
+    for (const ExPolygons &expolygons : slices) {
+        out += expolygons.capacity() * sizeof(ExPolygon);
+        for (const ExPolygon &expolygon : expolygons) {
+            out += expolygon.contour.points.capacity() * sizeof(Point) + expolygon.holes.capacity() * sizeof(Polygon);
+            for (const Polygon &hole : expolygon.holes)
+                out += hole.points.capacity() * sizeof(Point);
+        }
+    }
+    return out;
+}
+
+void SliceCache::set_max_memory(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_max_memory = bytes;
+    // Evict the least recently used slices exceeding the new limit.
+    while (m_memory > m_max_memory && ! m_entries.empty()) {
+        m_memory -= m_entries.back().memory;
+        m_map.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+void SliceCache::set_dir(const std::string &dir)
+{
+    if (! dir.empty()) {
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(boost::filesystem::path(dir), ec);
+        if (ec)
+            BOOST_LOG_TRIVIAL(error) << "SliceCache: Failed to create directory " << dir << ": " << ec.message();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dir = dir;
+}
+
+void SliceCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_map.clear();
+    m_memory = 0;
+}
+
+std::string SliceCache::file_path(const Key &key) const
+{
+    return (boost::filesystem::path(m_dir) / (boost::format("%016x.slices") % key.hash()).str()).string();
+}
+
+void SliceCache::insert_and_evict(Key key, std::vector<ExPolygons> slices)
+{
+    // Called with m_mutex locked.
+    if (m_map.find(key) != m_map.end())
+        return;
+    const size_t memory = slices_memory(slices) + sizeof(Entry) + key.zs.capacity() * sizeof(float);
+    if (memory > m_max_memory)
+        // Never cache slices, which would evict all the other slices and still would not fit.
+        return;
+    while (m_memory + memory > m_max_memory && ! m_entries.empty()) {
+        m_memory -= m_entries.back().memory;
+        m_map.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front({ std::move(key), std::move(slices), memory });
+    m_map.emplace(m_entries.front().key, m_entries.begin());
+    m_memory += memory;
+}
+
+namespace {
+
+template<typename T> void write_pod(std::ostream &os, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "write_pod(): trivially copyable type expected");
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T> bool read_pod(std::istream &is, T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "read_pod(): trivially copyable type expected");
+    return bool(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void write_points(std::ostream &os, const Points &points)
+{
+    write_pod(os, uint64_t(points.size()));
+    os.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(Point));
+}
+
+bool read_points(std::istream &is, Points &points)
+{
+    uint64_t n;
+    if (! read_pod(is, n) || n > (uint64_t(1) << 32))
+        return false;
+    points.assign(size_t(n), Point());
+    return bool(is.read(reinterpret_cast<char*>(points.data()), n * sizeof(Point)));
+}
+
+void write_key(std::ostream &os, const SliceCache::Key &key)
+{
+    write_pod(os, key.mesh_hash);
+    os.write(reinterpret_cast<const char*>(key.trafo.data()), sizeof(double) * 16);
+    write_pod(os, uint64_t(key.zs.size()));
+    os.write(reinterpret_cast<const char*>(key.zs.data()), key.zs.size() * sizeof(float));
+    write_pod(os, key.mode);
+    write_pod(os, key.mode_below);
+    write_pod(os, key.slicing_mode_normal_below_layer);
+    write_pod(os, key.closing_radius);
+    write_pod(os, key.extra_offset);
+    write_pod(os, key.resolution);
+}
+
+bool read_key(std::istream &is, SliceCache::Key &key)
+{
+    uint64_t num_zs;
+    if (! read_pod(is, key.mesh_hash) ||
+        ! is.read(reinterpret_cast<char*>(key.trafo.data()), sizeof(double) * 16) ||
+        ! read_pod(is, num_zs) || num_zs > (uint64_t(1) << 32))
+        return false;
+    key.zs.assign(size_t(num_zs), 0.f);
+    return is.read(reinterpret_cast<char*>(key.zs.data()), num_zs * sizeof(float)) &&
+        read_pod(is, key.mode) && read_pod(is, key.mode_below) && read_pod(is, key.slicing_mode_normal_below_layer) &&
+        read_pod(is, key.closing_radius) && read_pod(is, key.extra_offset) && read_pod(is, key.resolution);
+}
+
+bool load_slices(const std::string &path, const SliceCache::Key &key, std::vector<ExPolygons> &slices)
+{
+    boost::nowide::ifstream is(path, std::ios::binary);
+    if (! is.good())
+        return false;
+    char     magic[4];
+    uint32_t version;
+    if (! is.read(magic, 4) || memcmp(magic, SLICE_CACHE_MAGIC, 4) != 0 || ! read_pod(is, version) || version != SLICE_CACHE_VERSION)
+        return false;
+    // The file name is just a hash of the key, verify that the file was stored for the same key.
+    SliceCache::Key stored_key;
+    if (! read_key(is, stored_key) || ! (stored_key == key))
+        return false;
+    uint64_t num_layers;
+    if (! read_pod(is, num_layers) || num_layers != key.zs.size())
+        return false;
+    std::vector<ExPolygons> out(num_layers);
+    for (ExPolygons &expolygons : out) {
+        uint64_t num_expolygons;
+        if (! read_pod(is, num_expolygons) || num_expolygons > (uint64_t(1) << 32))
+            return false;
+        expolygons.assign(size_t(num_expolygons), ExPolygon());
+        for (ExPolygon &expolygon : expolygons) {
+            uint64_t num_holes;
+            if (! read_points(is, expolygon.contour.points) || ! read_pod(is, num_holes) || num_holes > (uint64_t(1) << 32))
+                return false;
+            expolygon.holes.assign(size_t(num_holes), Polygon());
+            for (Polygon &hole : expolygon.holes)
+                if (! read_points(is, hole.points))
+                    return false;
+        }
+    }
+    slices = std::move(out);
+    return true;
+}
+
+void store_slices(const std::string &path, const SliceCache::Key &key, const std::vector<ExPolygons> &slices)
+{
+    // Write into a temporary file first, then rename it, so that concurrent processes sharing the directory
+    // never read a partially written file.
+    const std::string path_tmp = path + boost::filesystem::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp").string();
+    {
+        boost::nowide::ofstream os(path_tmp, std::ios::binary);
+        if (! os.good()) {
+            BOOST_LOG_TRIVIAL(error) << "SliceCache: Failed to open " << path_tmp << " for writing";
+            return;
+        }
+        os.write(SLICE_CACHE_MAGIC, 4);
+        write_pod(os, SLICE_CACHE_VERSION);
+        write_key(os, key);
+        write_pod(os, uint64_t(slices.size()));
+        for (const ExPolygons &expolygons : slices) {
+            write_pod(os, uint64_t(expolygons.size()));
+            for (const ExPolygon &expolygon : expolygons) {
+                write_points(os, expolygon.contour.points);
+                write_pod(os, uint64_t(expolygon.holes.size()));
+                for (const Polygon &hole : expolygon.holes)
+                    write_points(os, hole.points);
+            }
+        }
+        os.close();
+        if (os.fail()) {
+            BOOST_LOG_TRIVIAL(error) << "SliceCache: Failed to write " << path_tmp;
+            boost::system::error_code ec;
+            boost::filesystem::remove(path_tmp, ec);
+            return;
+        }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(path_tmp, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(error) << "SliceCache: Failed to rename " << path_tmp << " to " << path << ": " << ec.message();
+        boost::filesystem::remove(path_tmp, ec);
+    }
+}
+
+} // namespace
+
+bool SliceCache::get(const Key &key, std::vector<ExPolygons> &slices)
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_map.find(key); it != m_map.end()) {
+            // Move to the front of the LRU list.
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            slices = it->second->slices;
+            return true;
+        }
+        if (m_dir.empty())
+            return false;
+        path = this->file_path(key);
+    }
+    std::vector<ExPolygons> loaded;
+    if (! load_slices(path, key, loaded))
+        return false;
+    BOOST_LOG_TRIVIAL(debug) << "SliceCache: Loaded " << loaded.size() << " layers from " << path;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_max_memory > 0) {
+        slices = loaded;
+        this->insert_and_evict(key, std::move(loaded));
+    } else
+        slices = std::move(loaded);
+    return true;
+}
+
+void SliceCache::put(const Key &key, const std::vector<ExPolygons> &slices)
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_max_memory > 0)
+            this->insert_and_evict(key, slices);
+        if (! m_dir.empty())
+            path = this->file_path(key);
+    }
+    boost::system::error_code ec;
+    if (! path.empty() && ! boost::filesystem::exists(path, ec))
+        store_slices(path, key, slices);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,99 @@
+#ifndef slic3r_SliceCache_hpp_
+#define slic3r_SliceCache_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+#include "TriangleMesh.hpp"
+#include "TriangleMeshSlicer.hpp"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Slic3r {
+
+// Cache of the results of slice_mesh_ex(), keyed by a hash of the mesh, by the transformation, by the slicing Zs
+// and by the slicing parameters. Slicing the same mesh again, for example with a different infill or wall setting
+// by a CLI farm processing the same model with many profiles, then skips the slicing of the mesh.
+//
+// The slices are held in memory up to a memory limit, the least recently used slices are dropped first.
+// Optionally the slices are stored into a directory, from which they are loaded by later runs or by other processes.
+// The cache is disabled by default.
+class SliceCache
+{
+public:
+    struct Key
+    {
+        uint64_t                        mesh_hash { 0 };
+        Transform3d                     trafo { Transform3d::Identity() };
+        std::vector<float>              zs;
+        MeshSlicingParams::SlicingMode  mode { MeshSlicingParams::SlicingMode::Regular };
+        MeshSlicingParams::SlicingMode  mode_below { MeshSlicingParams::SlicingMode::Regular };
+        uint64_t                        slicing_mode_normal_below_layer { 0 };
+        float                           closing_radius { 0 };
+        float                           extra_offset { 0 };
+        double                          resolution { 0 };
+
+        Key() = default;
+        // mesh_hash is its_hash() of the mesh.
+        Key(uint64_t mesh_hash, const std::vector<float> &zs, const MeshSlicingParamsEx &params);
+
+        bool     operator==(const Key &rhs) const;
+        uint64_t hash() const;
+    };
+
+    static SliceCache& get_instance()
+    {
+        static SliceCache instance;
+        return instance;
+    }
+
+    SliceCache(SliceCache const&) = delete;
+    void operator=(SliceCache const&) = delete;
+
+    // Maximum size of the slices held in memory, 0 disables the in-memory cache.
+    void        set_max_memory(size_t bytes);
+    size_t      max_memory() const { std::lock_guard<std::mutex> lock(m_mutex); return m_max_memory; }
+    // Size of the slices held in memory.
+    size_t      memory() const { std::lock_guard<std::mutex> lock(m_mutex); return m_memory; }
+    // Directory to store the slices to and to load them from, empty disables the disk cache. UTF-8 encoded.
+    void        set_dir(const std::string &dir);
+    std::string dir() const { std::lock_guard<std::mutex> lock(m_mutex); return m_dir; }
+    bool        enabled() const { std::lock_guard<std::mutex> lock(m_mutex); return m_max_memory > 0 || ! m_dir.empty(); }
+
+    // Returns true and fills in slices if slices for the key are cached in memory or on disk.
+    bool        get(const Key &key, std::vector<ExPolygons> &slices);
+    void        put(const Key &key, const std::vector<ExPolygons> &slices);
+    // Drops the slices held in memory, the disk cache is left untouched.
+    void        clear();
+
+private:
+    SliceCache() = default;
+
+    struct KeyHash { size_t operator()(const Key &key) const { return size_t(key.hash()); } };
+    struct Entry
+    {
+        Key                     key;
+        std::vector<ExPolygons> slices;
+        size_t                  memory;
+    };
+    using Entries = std::list<Entry>;
+
+    void        insert_and_evict(Key key, std::vector<ExPolygons> slices);
+    std::string file_path(const Key &key) const;
+
+    mutable std::mutex                                        m_mutex;
+    size_t                                                    m_max_memory { 0 };
+    size_t                                                    m_memory { 0 };
+    std::string                                               m_dir;
+    // Most recently used first.
+    Entries                                                   m_entries;
+    std::unordered_map<Key, Entries::iterator, KeyHash>       m_map;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_SliceCache_hpp_
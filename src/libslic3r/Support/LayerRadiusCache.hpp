@@ -0,0 +1,290 @@
+#ifndef slic3r_LayerRadiusCache_hpp_
+#define slic3r_LayerRadiusCache_hpp_
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// Count the hits, misses and lock contentions of the caches. The counters are shared by all threads,
+// thus they slow down the lookups.
+//#define SLIC3R_LAYER_RADIUS_CACHE_STATS
+
+namespace Slic3r {
+
+// Cache of areas at a given layer for a given radius, for example of the collision or avoidance areas of tree supports.
+//
+// The cache is sharded by layers. An area is inserted under the lock of its layer only and the areas are looked up
+// without any locking: the areas of a layer are stored in blocks of radius buckets in the order of insertion,
+// a bucket is published by incrementing the number of buckets of its layer after the area was stored.
+// The buckets are never moved, thus the references to the cached areas stay valid until the cache is cleared.
+// The layers are allocated in chunks, which are never moved either.
+//
+// The number of radii cached per layer is low, thus the buckets are searched linearly.
+template<typename Radius, typename Area>
+class LayerRadiusCache
+{
+public:
+    struct Stats
+    {
+        size_t hits      { 0 };
+        size_t misses    { 0 };
+        // Number of insertions, which had to wait for another thread inserting into the same layer.
+        size_t contended { 0 };
+    };
+
+    LayerRadiusCache() = default;
+    ~LayerRadiusCache() { this->clear(); }
+
+    // Not thread safe.
+    LayerRadiusCache(LayerRadiusCache &&rhs) { *this = std::move(rhs); }
+    LayerRadiusCache& operator=(LayerRadiusCache &&rhs)
+    {
+        if (this != &rhs) {
+            this->clear();
+            for (size_t i = 0; i < MaxChunks; ++ i)
+                m_chunks[i].store(rhs.m_chunks[i].exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_num_layers.store(rhs.m_num_layers.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    LayerRadiusCache(const LayerRadiusCache&) = delete;
+    LayerRadiusCache& operator=(const LayerRadiusCache&) = delete;
+
+    // Area cached for the layer and radius, nullptr if not cached yet. Lock free.
+    const Area* find(size_t layer_idx, Radius radius) const
+    {
+        const Area *out = this->find_area(layer_idx, radius);
+        this->count(out != nullptr);
+        return out;
+    }
+
+    // Same as find() != nullptr, not counted by the statistics. Lock free.
+    bool contains(size_t layer_idx, Radius radius) const { return this->find_area(layer_idx, radius) != nullptr; }
+
+    // Area cached for the layer with the highest radius lower or equal to the radius. Lock free.
+    std::optional<std::pair<Radius, const Area*>> find_lower_bound(size_t layer_idx, Radius radius) const
+    {
+        std::optional<std::pair<Radius, const Area*>> out;
+        if (const Layer *layer = this->find_layer(layer_idx); layer)
+            layer->for_each([radius, &out](const Bucket &bucket) {
+                if (bucket.radius <= radius && (! out || bucket.radius > out->first))
+                    out = std::make_pair(bucket.radius, &bucket.area);
+                return false;
+            });
+        this->count(out.has_value());
+        return out;
+    }
+
+    // Calls fn(radius, area) for all areas cached for the layer in the order of insertion. Lock free.
+    template<typename Fn>
+    void for_each(size_t layer_idx, Fn &&fn) const
+    {
+        if (const Layer *layer = this->find_layer(layer_idx); layer)
+            layer->for_each([&fn](const Bucket &bucket) { fn(bucket.radius, bucket.area); return false; });
+    }
+
+    // Caches the area for the layer and radius. If an area is already cached for them, the new area is dropped.
+    // Returns the cached area. Locks the layer only.
+    const Area& insert(size_t layer_idx, Radius radius, Area &&area)
+    {
+        Layer                       &layer = this->allocate_layer(layer_idx);
+        std::unique_lock<std::mutex> lock(layer.mutex, std::try_to_lock);
+        if (! lock.owns_lock()) {
+#ifdef SLIC3R_LAYER_RADIUS_CACHE_STATS
+            m_contended.fetch_add(1, std::memory_order_relaxed);
+#endif // SLIC3R_LAYER_RADIUS_CACHE_STATS
+            lock.lock();
+        }
+        return layer.insert(radius, std::move(area));
+    }
+
+    // One more than the highest layer index with an area inserted.
+    size_t num_layers() const { return m_num_layers.load(std::memory_order_acquire); }
+
+    // Number of the cached areas.
+    size_t size() const
+    {
+        size_t out = 0;
+        for (size_t layer_idx = 0; layer_idx < this->num_layers(); ++ layer_idx)
+            if (const Layer *layer = this->find_layer(layer_idx); layer)
+                out += layer->size.load(std::memory_order_acquire);
+        return out;
+    }
+
+    Stats stats() const
+    {
+        Stats out;
+#ifdef SLIC3R_LAYER_RADIUS_CACHE_STATS
+        out.hits      = m_hits.load(std::memory_order_relaxed);
+        out.misses    = m_misses.load(std::memory_order_relaxed);
+        out.contended = m_contended.load(std::memory_order_relaxed);
+#endif // SLIC3R_LAYER_RADIUS_CACHE_STATS
+        return out;
+    }
+
+    // Not thread safe.
+    void clear()
+    {
+        for (std::atomic<Layer*> &chunk : m_chunks)
+            delete[] chunk.exchange(nullptr, std::memory_order_relaxed);
+        m_num_layers.store(0, std::memory_order_relaxed);
+    }
+
+    // Keeps just the area with the smallest radius of each layer. Not thread safe.
+    void retain_smallest_radius()
+    {
+        for (size_t layer_idx = 0; layer_idx < this->num_layers(); ++ layer_idx)
+            if (Layer *layer = this->find_layer(layer_idx); layer && layer->size.load(std::memory_order_relaxed) > 1) {
+                Bucket *smallest = nullptr;
+                layer->for_each([&smallest](const Bucket &bucket) {
+                    if (! smallest || bucket.radius < smallest->radius)
+                        smallest = const_cast<Bucket*>(&bucket);
+                    return false;
+                });
+                Bucket bucket = std::move(*smallest);
+                layer->clear();
+                layer->insert(bucket.radius, std::move(bucket.area));
+            }
+    }
+
+private:
+    static constexpr const size_t BucketsPerBlock = 8;
+    static constexpr const size_t LayersPerChunk  = 256;
+    static constexpr const size_t MaxChunks       = 1024;
+
+    struct Bucket
+    {
+        Radius radius;
+        Area   area;
+    };
+
+    struct Block
+    {
+        // Constructed in place when inserting.
+        std::array<std::optional<Bucket>, BucketsPerBlock> buckets;
+        std::atomic<Block*>                                 next { nullptr };
+    };
+
+    struct Layer
+    {
+        // Taken by the writers only.
+        std::mutex          mutex;
+        // Number of the published buckets.
+        std::atomic<size_t> size { 0 };
+        Block               first;
+
+        ~Layer() { this->clear(); }
+
+        // Calls fn(bucket) for the published buckets until fn returns true.
+        template<typename Fn>
+        void for_each(Fn &&fn) const
+        {
+            const size_t  n     = size.load(std::memory_order_acquire);
+            const Block  *block = &first;
+            for (size_t i = 0; i < n; ++ i) {
+                if (i > 0 && i % BucketsPerBlock == 0)
+                    block = block->next.load(std::memory_order_acquire);
+                if (fn(*block->buckets[i % BucketsPerBlock]))
+                    return;
+            }
+        }
+
+        // The caller holds the mutex.
+        const Area& insert(Radius radius, Area &&area)
+        {
+            const size_t n     = size.load(std::memory_order_relaxed);
+            Block       *block = &first;
+            for (size_t i = 0; i < n; ++ i) {
+                if (i > 0 && i % BucketsPerBlock == 0)
+                    block = block->next.load(std::memory_order_relaxed);
+                if (const Bucket &bucket = *block->buckets[i % BucketsPerBlock]; bucket.radius == radius)
+                    return bucket.area;
+            }
+            if (n > 0 && n % BucketsPerBlock == 0) {
+                Block *next = new Block();
+                block->next.store(next, std::memory_order_release);
+                block = next;
+            }
+            const Bucket &bucket = block->buckets[n % BucketsPerBlock].emplace(Bucket{ radius, std::move(area) });
+            // Publish the bucket to the readers.
+            size.store(n + 1, std::memory_order_release);
+            return bucket.area;
+        }
+
+        // Not thread safe.
+        void clear()
+        {
+            for (Block *block = first.next.exchange(nullptr, std::memory_order_relaxed); block;) {
+                Block *next = block->next.load(std::memory_order_relaxed);
+                delete block;
+                block = next;
+            }
+            for (std::optional<Bucket> &bucket : first.buckets)
+                bucket.reset();
+            size.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    const Layer* find_layer(size_t layer_idx) const
+    {
+        assert(layer_idx < LayersPerChunk * MaxChunks);
+        const Layer *chunk = m_chunks[layer_idx / LayersPerChunk].load(std::memory_order_acquire);
+        return chunk ? chunk + layer_idx % LayersPerChunk : nullptr;
+    }
+    Layer* find_layer(size_t layer_idx) { return const_cast<Layer*>(std::as_const(*this).find_layer(layer_idx)); }
+
+    Layer& allocate_layer(size_t layer_idx)
+    {
+        assert(layer_idx < LayersPerChunk * MaxChunks);
+        std::atomic<Layer*> &slot  = m_chunks[layer_idx / LayersPerChunk];
+        Layer               *chunk = slot.load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            Layer *new_chunk = new Layer[LayersPerChunk];
+            if (slot.compare_exchange_strong(chunk, new_chunk, std::memory_order_acq_rel, std::memory_order_acquire))
+                chunk = new_chunk;
+            else
+                // Allocated by another thread in the meantime.
+                delete[] new_chunk;
+        }
+        for (size_t num_layers = m_num_layers.load(std::memory_order_relaxed);
+             num_layers <= layer_idx && ! m_num_layers.compare_exchange_weak(num_layers, layer_idx + 1, std::memory_order_acq_rel, std::memory_order_relaxed);) ;
+        return chunk[layer_idx % LayersPerChunk];
+    }
+
+    const Area* find_area(size_t layer_idx, Radius radius) const
+    {
+        const Area *out = nullptr;
+        if (const Layer *layer = this->find_layer(layer_idx); layer)
+            layer->for_each([radius, &out](const Bucket &bucket) {
+                if (bucket.radius == radius)
+                    out = &bucket.area;
+                return out != nullptr;
+            });
+        return out;
+    }
+
+    void count([[maybe_unused]] bool hit) const
+    {
+#ifdef SLIC3R_LAYER_RADIUS_CACHE_STATS
+        (hit ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed);
+#endif // SLIC3R_LAYER_RADIUS_CACHE_STATS
+    }
+
+    // Chunks of LayersPerChunk layers, allocated on demand.
+    std::array<std::atomic<Layer*>, MaxChunks> m_chunks {};
+    std::atomic<size_t>                        m_num_layers { 0 };
+#ifdef SLIC3R_LAYER_RADIUS_CACHE_STATS
+    mutable std::atomic<size_t>                m_hits { 0 };
+    mutable std::atomic<size_t>                m_misses { 0 };
+    std::atomic<size_t>                        m_contended { 0 };
+#endif // SLIC3R_LAYER_RADIUS_CACHE_STATS
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_LayerRadiusCache_hpp_
@@ -868,23 +868,17 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
-{
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            m_data.reserve(next_highest_power_of_2(num_layers));
-        m_data.resize(num_layers, {});
-    }
-}
-
 // For debugging purposes, sorted by layer index, then by radius.
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
+    for (LayerIndex layer_idx = 0; layer_idx < LayerIndex(m_data.num_layers()); ++ layer_idx) {
+        const size_t first = out.size();
+        m_data.for_each(layer_idx, [layer_idx, &out](coord_t radius, const Polygons &polygons) {
+            out.emplace_back(std::make_pair(radius, layer_idx), polygons);
+        });
+        // The areas of a layer are cached in the order of insertion.
+        std::sort(out.begin() + first, out.end(), [](auto &l, auto &r) { return l.first.first < r.first.first; });
     }
     assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
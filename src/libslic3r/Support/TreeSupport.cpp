@@ -1,5 +1,6 @@
 #include <chrono>
 #include <math.h>
+#include <string_view>
 
 #include "format.hpp"
 #include "BuildVolume.hpp"
@@ -25,6 +26,7 @@
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
 
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 // #include <boost/log/core.hpp>
 // #include <boost/log/expressions.hpp>
@@ -34,6 +36,8 @@
 // #include <boost/log/utility/setup/common_attributes.hpp>
 // #include <boost/log/utility/setup/console.hpp>
 
+#include <ankerl/unordered_dense.h>
+
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
 #endif
@@ -667,9 +671,9 @@ void TreeSupport::detect_overhangs(bool check_support_necessity/* = false*/)
         return;
     }
 
-    // Clear and create Tree Support Layers
+    // Clear and create Tree Support Layers. The tree support data is kept if the object slices did not change,
+    // see PrintObject::alloc_tree_support_preview_cache().
     m_object->clear_support_layers();
-    m_object->clear_tree_support_preview_cache();
 
     const PrintObjectConfig& config = m_object->config();
     SupportType stype = support_type;
@@ -893,11 +897,48 @@ void TreeSupport::detect_overhangs(bool check_support_necessity/* = false*/)
     trim_tail_empty(enforcers);
     trim_tail_empty(blockers);
 
+    // Reuse the overhangs detected by the previous support generation for the layers, whose enforcers and blockers
+    // did not change, for example all the layers but those of a newly painted enforcer.
+    auto layer_polygons = [](const std::vector<Polygons> &polys, size_t layer_nr) -> const Polygons& {
+        static const Polygons empty;
+        return layer_nr < polys.size() ? polys[layer_nr] : empty;
+    };
+    size_t overhang_params_hash = 0;
+    boost::hash_combine(overhang_params_hash, int(stype));
+    boost::hash_combine(overhang_params_hash, enforce_support_layers);
+    boost::hash_combine(overhang_params_hash, extrusion_width);
+    boost::hash_combine(overhang_params_hash, threshold_rad);
+    boost::hash_combine(overhang_params_hash, config_detect_sharp_tails);
+    boost::hash_combine(overhang_params_hash, m_support_params.thresh_big_overhang);
+    std::vector<TreeSupportData::OverhangLayerCache> &overhang_cache = m_ts_data->overhang_cache;
+    if (m_ts_data->overhang_cache_params_hash != overhang_params_hash || overhang_cache.size() != m_object->layer_count())
+        overhang_cache.clear();
+    std::vector<double> layers_max_cantilever_dist(m_object->layer_count(), 0);
+    std::atomic<size_t> num_layers_reused { 0 };
+    std::atomic<bool>   detection_complete { true };
+
     tbb::parallel_for(tbb::blocked_range<size_t>(0, m_object->layer_count()),
         [&](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_nr = range.begin(); layer_nr < range.end(); layer_nr++) {
                 if (m_object->print()->canceled())
                     break;
+                if (layer_nr < overhang_cache.size()) {
+                    const TreeSupportData::OverhangLayerCache &cached = overhang_cache[layer_nr];
+                    if (cached.enforcers == layer_polygons(enforcers, layer_nr) && cached.blockers == layer_polygons(blockers, layer_nr)) {
+                        Layer *layer                        = m_object->get_layer(layer_nr);
+                        overhangs_all_layers[layer_nr]      = cached.overhangs;
+                        layer->sharp_tails                  = cached.sharp_tails;
+                        layer->sharp_tails_height           = cached.sharp_tails_height;
+                        layer->cantilevers                  = cached.cantilevers;
+                        layers_max_cantilever_dist[layer_nr] = cached.max_cantilever_dist;
+                        if (cached.has_sharp_tails)
+                            has_sharp_tails = true;
+                        if (! cached.cantilevers.empty())
+                            has_cantilever = true;
+                        ++ num_layers_reused;
+                        continue;
+                    }
+                }
                 // FIXME the param enforce_support_layers is not set yet
                 if (!(is_auto(stype) || (enforce_support_layers > 0 && layer_nr >= enforce_support_layers) || (layer_nr < enforcers.size() && !enforcers[layer_nr].empty())))
                     continue;
@@ -963,6 +1004,7 @@ void TreeSupport::detect_overhangs(bool check_support_necessity/* = false*/)
                     BOOST_LOG_TRIVIAL(info) << "detect_overhangs takes more than 30 secs, skip cantilever and sharp tails detection: layer_nr=" << layer_nr << " duration=" << duration;
                     config_detect_sharp_tails = false;
                     config_remove_small_overhangs = false;
+                    detection_complete = false;
                     continue;
                 }
                 if (is_auto(stype) && config_detect_sharp_tails)
@@ -1038,7 +1080,7 @@ void TreeSupport::detect_overhangs(bool check_support_necessity/* = false*/)
                     }
                     // is cantilever if the farmost point is larger than 3mm away from base or some contour is totally floating
                     if (is_cantilever) {
-                        max_cantilever_dist = std::max(max_cantilever_dist, dist_max);
+                        layers_max_cantilever_dist[layer_nr] = std::max(layers_max_cantilever_dist[layer_nr], dist_max);
                         layer->cantilevers.emplace_back(poly);
                         BOOST_LOG_TRIVIAL(debug) << "found a cantilever cluster. layer_nr=" << layer_nr << dist_max;
                         has_cantilever = true;
@@ -1048,7 +1090,33 @@ void TreeSupport::detect_overhangs(bool check_support_necessity/* = false*/)
         }
     ); // end tbb::parallel_for
 
+    for (double dist : layers_max_cantilever_dist)
+        max_cantilever_dist = std::max(max_cantilever_dist, dist);
     BOOST_LOG_TRIVIAL(info) << "max_cantilever_dist=" << max_cantilever_dist;
+    BOOST_LOG_TRIVIAL(info) << "detect_overhangs reused the overhangs of " << num_layers_reused << " of " << m_object->layer_count() << " layers";
+
+    // Keep the overhangs for the next support generation, unless the detection was cut short.
+    if (detection_complete && ! m_object->print()->canceled()) {
+        overhang_cache.resize(m_object->layer_count());
+        m_ts_data->overhang_cache_params_hash = overhang_params_hash;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_object->layer_count()),
+            [&](const tbb::blocked_range<size_t>& range) {
+                for (size_t layer_nr = range.begin(); layer_nr < range.end(); layer_nr++) {
+                    const Layer                         *layer  = m_object->get_layer(layer_nr);
+                    TreeSupportData::OverhangLayerCache &cached = overhang_cache[layer_nr];
+                    cached.enforcers          = layer_polygons(enforcers, layer_nr);
+                    cached.blockers           = layer_polygons(blockers, layer_nr);
+                    cached.overhangs          = overhangs_all_layers[layer_nr];
+                    cached.sharp_tails        = layer->sharp_tails;
+                    cached.sharp_tails_height = layer->sharp_tails_height;
+                    cached.cantilevers        = layer->cantilevers;
+                    cached.max_cantilever_dist = layers_max_cantilever_dist[layer_nr];
+                    // Sharp tails of the first layer do not count, see above.
+                    cached.has_sharp_tails    = layer->lower_layer != nullptr && ! layer->sharp_tails.empty();
+                }
+            });
+    } else
+        overhang_cache.clear();
     if (check_support_necessity)
         return;
 
@@ -3094,7 +3162,7 @@ void TreeSupport::drop_nodes()
                         node_parent = p_node->parent ? p_node : neighbour;
                     // Make sure the next pass doesn't drop down either of these (since that already happened).
                     node_parent->merged_neighbours.push_front(node_parent == p_node ? neighbour : p_node);
-                    const bool to_buildplate = !is_inside_ex(get_collision(0, obj_layer_nr_next), next_position);
+                    const bool to_buildplate = !m_ts_data->is_inside_collision(0, obj_layer_nr_next, next_position);
                     SupportNode* next_node = m_ts_data->create_node(next_position, node_parent->distance_to_top + 1, obj_layer_nr_next, node_parent->support_roof_layers_below - 1, to_buildplate, node_parent,
                         print_z_next, height_next);
                     get_max_move_dist(next_node);
@@ -3216,7 +3284,7 @@ void TreeSupport::drop_nodes()
                 }
 
                 //If the branch falls completely inside a collision area (the entire branch would be removed by the X/Y offset), delete it.
-                if (group_index > 0 && is_inside_ex(get_collision(0, obj_layer_nr), node.position))
+                if (group_index > 0 && m_ts_data->is_inside_collision(0, obj_layer_nr, node.position))
                 {
                     std::scoped_lock lock(m_ts_data->m_mutex);
                     const coordf_t branch_radius_node = get_radius(p_node);
@@ -3312,7 +3380,7 @@ void TreeSupport::drop_nodes()
                 // 1) line of node and to_outside is cut by contour (means supports may intersect with object)
                 // 2) it's impossible to move to build plate
                 if (is_line_cut_by_contour(node.position, to_outside) || dist2_to_outer > max_move_distance2 * SQ(obj_layer_nr) ||
-                    !is_inside_ex(avoidance_next, node.position)) {
+                    !m_ts_data->is_inside_avoidance(next_radius, obj_layer_nr_next, node.position)) {
                     // try move to outside of lower layer instead
                     Point candidate_vertex = node.position;
                     const coordf_t max_move_between_samples = max_move_distance + radius_sample_resolution + EPSILON; // 100 micron extra for rounding errors.
@@ -3435,6 +3503,12 @@ void TreeSupport::drop_nodes()
     }
 
     BOOST_LOG_TRIVIAL(debug) << "after m_avoidance_cache.size()=" << m_ts_data->m_avoidance_cache.size();
+#ifdef SLIC3R_LAYER_RADIUS_CACHE_STATS
+    for (const auto &[name, cache] : { std::make_pair("collision", &m_ts_data->m_collision_cache), std::make_pair("avoidance", &m_ts_data->m_avoidance_cache) }) {
+        const auto stats = cache->stats();
+        BOOST_LOG_TRIVIAL(debug) << name << " cache: hits=" << stats.hits << ", misses=" << stats.misses << ", contended insertions=" << stats.contended;
+    }
+#endif // SLIC3R_LAYER_RADIUS_CACHE_STATS
 }
 
 void TreeSupport::smooth_nodes()
@@ -4043,6 +4117,41 @@ void TreeSupport::insert_dropped_node(std::vector<SupportNode*>& nodes_layer, Su
     conflicting_node->support_roof_layers_below = std::max(conflicting_node->support_roof_layers_below, p_node->support_roof_layers_below);
 }
 
+static ExPolygon tree_support_machine_border(const PrintObject &object)
+{
+    ExPolygon m_machine_border;
+    //cal m_machine_border twice, this may happen before TreeSupport builds
+    m_machine_border.contour = get_bed_shape_with_excluded_area(object.print()->config());
+    Vec3d plate_offset       = object.print()->get_plate_origin();
+    // align with the centered object in current plate (may not be the 1st plate, so need to add the plate offset)
+    m_machine_border.translate(Point(scale_(plate_offset(0)), scale_(plate_offset(1))) - object.instances().front().shift);
+    return m_machine_border;
+}
+
+uint64_t TreeSupportData::calc_inputs_hash(const PrintObject &object, coordf_t xy_distance, coordf_t radius_sample_resolution)
+{
+    auto hash_points = [](const Points &points) -> uint64_t {
+        return ankerl::unordered_dense::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(Point)));
+    };
+    size_t seed = 0;
+    boost::hash_combine(seed, xy_distance);
+    boost::hash_combine(seed, radius_sample_resolution);
+    boost::hash_combine(seed, object.config().tree_support_branch_angle.value);
+    boost::hash_combine(seed, hash_points(tree_support_machine_border(object).contour.points));
+    boost::hash_combine(seed, object.layer_count());
+    for (const Layer *layer : object.layers()) {
+        boost::hash_combine(seed, layer->height);
+        boost::hash_combine(seed, layer->lslices.size());
+        for (const ExPolygon &expoly : layer->lslices) {
+            boost::hash_combine(seed, hash_points(expoly.contour.points));
+            for (const Polygon &hole : expoly.holes)
+                boost::hash_combine(seed, hash_points(hole.points));
+        }
+    }
+    return uint64_t(seed);
+}
+
 TreeSupportData::TreeSupportData(const PrintObject &object, coordf_t xy_distance, coordf_t radius_sample_resolution)
     : m_xy_distance(xy_distance), m_radius_sample_resolution(radius_sample_resolution)
 {
@@ -4052,13 +4161,7 @@ TreeSupportData::TreeSupportData(const PrintObject &object, coordf_t xy_distance
     m_layer_outlines.resize(object.layers().size());
     m_layer_outlines_below.resize(object.layer_count());
     ExPolygons machine_border;
-    ExPolygon  m_machine_border;
-
-    //cal m_machine_border twice, this may happen before TreeSupport builds
-    m_machine_border.contour = get_bed_shape_with_excluded_area(object.print()->config());
-    Vec3d plate_offset       = object.print()->get_plate_origin();
-    // align with the centered object in current plate (may not be the 1st plate, so need to add the plate offset)
-    m_machine_border.translate(Point(scale_(plate_offset(0)), scale_(plate_offset(1))) - object.instances().front().shift);
+    ExPolygon  m_machine_border = tree_support_machine_border(object);
 
     if (!m_machine_border.empty()) {
         Polygon hole(m_machine_border.contour);
@@ -4084,15 +4187,28 @@ TreeSupportData::TreeSupportData(const PrintObject &object, coordf_t xy_distance
             if (layer_nr % 10 == 0) m_layer_outlines_below[layer_nr] = union_ex_2(m_layer_outlines_below[layer_nr]);
         }
     }
+
+    if (g_config_tree_support_distance_field) {
+        // The fields cover the object and the thickest branches around it, the machine border only where it is close.
+        BoundingBox bbox;
+        for (const Layer *layer : object.layers())
+            bbox.merge(get_extents(layer->lslices));
+        if (bbox.defined) {
+            const coordf_t resolution = g_config_tree_support_distance_field_resolution;
+            bbox.offset(scale_(TreeSupport::MAX_BRANCH_RADIUS + m_xy_distance + 2. * resolution));
+            m_distance_field = TreeSupportDistanceField(m_layer_outlines, bbox, m_xy_distance, m_max_move_distances, resolution, TreeSupport::MAX_BRANCH_RADIUS);
+            BOOST_LOG_TRIVIAL(debug) << "tree support distance fields: " << m_distance_field.num_layers() << " layers, "
+                                     << m_distance_field.memory() / 1024 << " kB";
+        }
+    }
 }
 
 const ExPolygons& TreeSupportData::get_collision(coordf_t radius, size_t layer_nr) const
 {
     profiler.tic();
     radius = ceil_radius(radius);
-    RadiusLayerPair key{radius, layer_nr};
-    const auto it = m_collision_cache.find(key);
-    const ExPolygons& collision = it != m_collision_cache.end() ? it->second : calculate_collision(key);
+    const ExPolygons *cached = m_collision_cache.find(layer_nr, radius);
+    const ExPolygons& collision = cached ? *cached : calculate_collision({ radius, layer_nr });
     profiler.stage_add(STAGE_get_collision);
     return collision;
 }
@@ -4101,14 +4217,25 @@ const ExPolygons& TreeSupportData::get_avoidance(coordf_t radius, size_t layer_n
 {
     profiler.tic();
     radius = ceil_radius(radius);
-    RadiusLayerPair key{radius, layer_nr, recursions };
-    const auto it = m_avoidance_cache.find(key);
-    const ExPolygons& avoidance = it != m_avoidance_cache.end() ? it->second : calculate_avoidance(key);
+    const ExPolygons *cached = m_avoidance_cache.find(layer_nr, radius);
+    const ExPolygons& avoidance = cached ? *cached : calculate_avoidance({ radius, layer_nr, recursions });
 
     profiler.stage_add(STAGE_GET_AVOIDANCE);
     return avoidance;
 }
 
+bool TreeSupportData::is_inside_collision(coordf_t radius, size_t layer_nr, const Point &pt) const
+{
+    radius = ceil_radius(radius);
+    return m_distance_field.covers(radius) ? m_distance_field.collides(pt, radius, layer_nr) : is_inside_ex(get_collision(radius, layer_nr), pt);
+}
+
+bool TreeSupportData::is_inside_avoidance(coordf_t radius, size_t layer_nr, const Point &pt) const
+{
+    radius = ceil_radius(radius);
+    return m_distance_field.covers(radius) ? m_distance_field.in_avoidance(pt, radius, layer_nr) : is_inside_ex(get_avoidance(radius, layer_nr), pt);
+}
+
 Polygons TreeSupportData::get_contours(size_t layer_nr) const
 {
     Polygons contours;
@@ -4131,12 +4258,18 @@ Polygons TreeSupportData::get_contours_with_holes(size_t layer_nr) const
 
 SupportNode* TreeSupportData::create_node(const Point position, const int distance_to_top, const int obj_layer_nr, const int support_roof_layers_below, const bool to_buildplate, SupportNode* parent, coordf_t print_z_, coordf_t height_, coordf_t dist_mm_to_top_, coordf_t radius_)
 {
-    // this function may be called from multiple threads, need to lock
-    m_mutex.lock();
-    std::unique_ptr<SupportNode> node = std::make_unique<SupportNode>(position, distance_to_top, obj_layer_nr, support_roof_layers_below, to_buildplate, parent, print_z_, height_, dist_mm_to_top_, radius_);
-    SupportNode* raw_ptr = node.get();
-    contact_nodes.emplace_back(std::move(node));
-    m_mutex.unlock();
+    // this function may be called from multiple threads, each of them allocates from its own pool
+    boost::object_pool<SupportNode> &pool = m_node_pools.local();
+    // object_pool::construct() does not accept that many arguments.
+    SupportNode *raw_ptr = (pool.malloc)();
+    if (raw_ptr == nullptr)
+        throw std::bad_alloc();
+    try {
+        new (raw_ptr) SupportNode(position, distance_to_top, obj_layer_nr, support_roof_layers_below, to_buildplate, parent, print_z_, height_, dist_mm_to_top_, radius_);
+    } catch (...) {
+        (pool.free)(raw_ptr);
+        throw;
+    }
     if (parent)
         raw_ptr->movement = position - parent->position;
     return raw_ptr;
@@ -4144,8 +4277,7 @@ SupportNode* TreeSupportData::create_node(const Point position, const int distan
 
 void TreeSupportData::clear_nodes()
 {
-    tbb::spin_mutex::scoped_lock guard(m_mutex);
-    contact_nodes.clear();
+    m_node_pools.clear();
 }
 
 coordf_t TreeSupportData::ceil_radius(coordf_t radius) const
@@ -4164,17 +4296,21 @@ const ExPolygons& TreeSupportData::calculate_collision(const RadiusLayerPair& ke
 {
     assert(key.layer_nr < m_layer_outlines.size());
 
-    ExPolygons collision_areas = std::move(offset_ex(m_layer_outlines[key.layer_nr], scale_(key.radius+m_xy_distance)));
+    ExPolygons collision_areas = m_distance_field.covers(key.radius) ? m_distance_field.collision(key.radius, key.layer_nr) :
+                                                                       offset_ex(m_layer_outlines[key.layer_nr], scale_(key.radius+m_xy_distance));
     collision_areas = expolygons_simplify(collision_areas, scale_(m_radius_sample_resolution));
     // collision_areas.emplace_back(m_machine_border);
-    const auto ret = m_collision_cache.insert({ key, std::move(collision_areas) });
-    return ret.first->second;
+    return m_collision_cache.insert(key.layer_nr, key.radius, std::move(collision_areas));
 }
 
 const ExPolygons& TreeSupportData::calculate_avoidance(const RadiusLayerPair& key) const
 {
     const auto &radius = key.radius;
     const auto &layer_nr = key.layer_nr;
+    if (m_distance_field.covers(radius))
+        // The field of a layer already accounts for the layers below, no recursion.
+        return m_avoidance_cache.insert(layer_nr, radius, expolygons_simplify(m_distance_field.avoidance(radius, layer_nr), scale_(m_radius_sample_resolution)));
+
     ExPolygons avoidance_areas;
     if (layer_nr > 0) {
         // Avoidance for a given layer depends on all layers beneath it so could have very deep recursion depths if
@@ -4184,7 +4320,7 @@ const ExPolygons& TreeSupportData::calculate_avoidance(const RadiusLayerPair& ke
         // below our current one.
         constexpr auto max_recursion_depth = 100;
         // Check if we would exceed the recursion limit by trying to process this layer
-        if (layer_nr >= max_recursion_depth && m_avoidance_cache.find({radius, layer_nr - max_recursion_depth}) == m_avoidance_cache.end()) {
+        if (layer_nr >= max_recursion_depth && ! m_avoidance_cache.contains(layer_nr - max_recursion_depth, radius)) {
             // Force the calculation of the layer `max_recursion_depth` below our current one, ignoring the result.
             get_avoidance(radius, layer_nr - max_recursion_depth);
         }
@@ -4194,13 +4330,12 @@ const ExPolygons& TreeSupportData::calculate_avoidance(const RadiusLayerPair& ke
     const ExPolygons &collision       = get_collision(radius, layer_nr);
     avoidance_areas.insert(avoidance_areas.end(), collision.begin(), collision.end());
     avoidance_areas = std::move(union_ex(avoidance_areas));
-    auto ret = m_avoidance_cache.insert({key, std::move(avoidance_areas)});
-    //assert(ret.second);
+    const ExPolygons &ret = m_avoidance_cache.insert(layer_nr, radius, std::move(avoidance_areas));
     // BOOST_LOG_TRIVIAL(debug) << format("calculate_avoidance: radius=%.2f, layer_nr=%d, recursions=%d, avoidance_areas=%d", radius, layer_nr, key.recursions,
     //                                    avoidance_areas.size());
     // boost::log::core::get()->flush();
 
-    return ret.first->second;
+    return ret;
 }
 
 } //namespace Slic3r
@@ -4,6 +4,8 @@
 #include <forward_list>
 #include <unordered_set>
 #include "tbb/concurrent_unordered_map.h"
+#include "tbb/enumerable_thread_specific.h"
+#include <boost/pool/object_pool.hpp>
 #include "../ExPolygon.hpp"
 #include "../Point.hpp"
 #include "../Slicing.hpp"
@@ -11,7 +13,9 @@
 #include "../Flow.hpp"
 #include "../PrintConfig.hpp"
 #include "../Fill/Lightning/Generator.hpp"
+#include "LayerRadiusCache.hpp"
 #include "TreeModelVolumes.hpp"
+#include "TreeSupportDistanceField.hpp"
 #include "TreeSupport3D.hpp"
 
 #ifndef SQ
@@ -244,15 +248,59 @@ public:
      */
     const ExPolygons& get_avoidance(coordf_t radius, size_t layer_idx, int recursions=0) const;
 
+    /*!
+     * \brief Whether a node of radius \p radius at \p pt collides with the model,
+     * same as is_inside_ex(get_collision(radius, layer_idx), pt).
+     *
+     * Looked up in the distance fields without generating the collision areas if the fields are built.
+     */
+    bool is_inside_collision(coordf_t radius, size_t layer_idx, const Point &pt) const;
+
+    /*!
+     * \brief Whether a node of radius \p radius at \p pt can not reach the build plate,
+     * same as is_inside_ex(get_avoidance(radius, layer_idx), pt).
+     */
+    bool is_inside_avoidance(coordf_t radius, size_t layer_idx, const Point &pt) const;
+
     Polygons get_contours(size_t layer_nr) const;
     Polygons get_contours_with_holes(size_t layer_nr) const;
 
+    // Thread safe, the nodes are owned by TreeSupportData until clear_nodes() is called.
     SupportNode* create_node(const Point position, const int distance_to_top, const int obj_layer_nr, const int support_roof_layers_below, const bool to_buildplate, SupportNode* parent,
         coordf_t     print_z_, coordf_t height_, coordf_t dist_mm_to_top_ = 0, coordf_t radius_ = 0);
     void clear_nodes();
     std::vector<LayerHeightData> layer_heights;
 
-    std::vector<std::unique_ptr<SupportNode>> contact_nodes;
+    /*!
+     * \brief Hash of the inputs of the constructor, the object slices, the clearance, the branch angle and the machine border.
+     *
+     * The data is reused by the next support generation if the hash did not change, for example
+     * if just the support painting or the support parameters other than those changed.
+     */
+    static uint64_t calc_inputs_hash(const PrintObject &object, coordf_t xy_distance, coordf_t radius_sample_resolution);
+    uint64_t inputs_hash { 0 };
+
+    /*!
+     * \brief Results of the overhang detection of a layer by the previous support generation.
+     *
+     * The results of a layer depend on the layer and the two layers below it, which do not change while the data
+     * is reused, on the support enforcers and blockers of the layer and on the detection parameters.
+     * Thus they are reused for the layers, whose enforcers and blockers did not change.
+     */
+    struct OverhangLayerCache {
+        Polygons            enforcers;
+        Polygons            blockers;
+        ExPolygons          overhangs;
+        ExPolygons          sharp_tails;
+        std::vector<float>  sharp_tails_height;
+        ExPolygons          cantilevers;
+        double              max_cantilever_dist { 0 };
+        bool                has_sharp_tails { false };
+    };
+    // Hash of the detection parameters, which the cached layers were detected with.
+    uint64_t                         overhang_cache_params_hash { 0 };
+    std::vector<OverhangLayerCache>  overhang_cache;
+
     // ExPolygon                  m_machine_border;
 
 private:
@@ -265,16 +313,6 @@ private:
         int recursions;
 
     };
-    struct RadiusLayerPairEquality {
-        constexpr bool operator()(const RadiusLayerPair& _Left, const RadiusLayerPair& _Right) const {
-            return _Left.radius == _Right.radius && _Left.layer_nr == _Right.layer_nr;
-        }
-    };
-    struct RadiusLayerPairHash {
-        size_t operator()(const RadiusLayerPair& elem) const {
-            return std::hash<coord_t>()(elem.radius) ^ std::hash<coord_t>()(elem.layer_nr * 7919);
-        }
-    };
 
     /*!
      * \brief Round \p radius upwards to a multiple of m_radius_sample_resolution
@@ -301,6 +339,10 @@ private:
 
     tbb::spin_mutex  m_mutex;
 
+    // Nodes created by create_node(). Each thread allocates its nodes from its own pool without locking,
+    // the pools release the nodes in large blocks.
+    tbb::enumerable_thread_specific<boost::object_pool<SupportNode>> m_node_pools;
+
 public:
     bool is_slim = false;
     /*!
@@ -340,9 +382,20 @@ public:
      *
      * coconut: previously stl::unordered_map is used which seems problematic with tbb::parallel_for.
      * So we change to tbb::concurrent_unordered_map
+     *
+     * Now the caches are sharded by layers, the lookups are lock free.
+     */
+    mutable LayerRadiusCache<coordf_t, ExPolygons> m_collision_cache;
+    mutable LayerRadiusCache<coordf_t, ExPolygons> m_avoidance_cache;
+
+    /*!
+     * \brief Distance fields of the collision and avoidance areas of all radii,
+     * empty unless g_config_tree_support_distance_field is set.
+     *
+     * The collision and avoidance areas are thresholded from the fields instead of
+     * offsetting the layer outlines. The areas are still cached above.
      */
-    mutable tbb::concurrent_unordered_map<RadiusLayerPair, ExPolygons, RadiusLayerPairHash, RadiusLayerPairEquality> m_collision_cache;
-    mutable tbb::concurrent_unordered_map<RadiusLayerPair, ExPolygons, RadiusLayerPairHash, RadiusLayerPairEquality> m_avoidance_cache;
+    TreeSupportDistanceField m_distance_field;
 
     friend TreeSupport;
 };
@@ -418,6 +471,11 @@ public:
     std::map<const ExPolygon*, OverhangType> overhang_types;
     std::vector<std::pair<Vec3f, Vec3f>>      m_vertical_enforcer_points;
 
+    static constexpr coordf_t MAX_BRANCH_RADIUS = 10.0;
+    static constexpr coordf_t MIN_BRANCH_RADIUS = 0.4;
+    static constexpr coordf_t MAX_BRANCH_RADIUS_FIRST_LAYER = 12.0;
+    static constexpr coordf_t MIN_BRANCH_RADIUS_FIRST_LAYER = 2.0;
+
 private:
     /*!
      * \brief Generator for model collision, avoidance and internal guide volumes
@@ -439,10 +497,6 @@ private:
     std::vector< std::unordered_map<Line, bool, LineHash>> m_mst_line_x_layer_contour_caches;
     float    DO_NOT_MOVER_UNDER_MM = 0.0;
     coordf_t base_radius                        = 0.0;
-    const coordf_t MAX_BRANCH_RADIUS = 10.0;
-    const coordf_t MIN_BRANCH_RADIUS = 0.4;
-    const coordf_t MAX_BRANCH_RADIUS_FIRST_LAYER = 12.0;
-    const coordf_t MIN_BRANCH_RADIUS_FIRST_LAYER = 2.0;
     double diameter_angle_scale_factor = tan(5.0*M_PI/180.0);
     // minimum roof area (1 mm^2), area smaller than this value will not have interface
     const double minimum_roof_area{SQ(scaled<double>(1.))};
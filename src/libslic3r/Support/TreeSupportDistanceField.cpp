@@ -0,0 +1,333 @@
+#include "TreeSupportDistanceField.hpp"
+#include "../ClipperUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+namespace Slic3r {
+
+// Marks the grid samples inside of the outlines using the non-zero winding rule.
+static std::vector<uint8_t> rasterize(const ExPolygons &outlines, const Point &origin, double sample_distance, int width, int height)
+{
+    std::vector<uint8_t> mask(size_t(width) * size_t(height), 0);
+    // Crossings of the outline edges with the rows of samples: x and winding direction.
+    std::vector<std::vector<std::pair<double, int>>> rows(height);
+    auto add_polygon = [&](const Polygon &polygon) {
+        for (size_t i = 0; i < polygon.points.size(); ++ i) {
+            const Point &a = polygon.points[i];
+            const Point &b = polygon.points[i + 1 == polygon.points.size() ? 0 : i + 1];
+            if (a.y() == b.y())
+                continue;
+            const double ymin = double(std::min(a.y(), b.y())) - origin.y();
+            const double ymax = double(std::max(a.y(), b.y())) - origin.y();
+            const int    dir  = b.y() > a.y() ? 1 : -1;
+            for (int row = std::max(0, int(std::ceil(ymin / sample_distance))); row < height; ++ row) {
+                const double y = row * sample_distance;
+                if (y >= ymax)
+                    break;
+                // Half open [ymin, ymax) to count the vertices shared by two edges once.
+                const double t = (y + origin.y() - a.y()) / double(b.y() - a.y());
+                rows[row].emplace_back(a.x() + t * double(b.x() - a.x()) - origin.x(), dir);
+            }
+        }
+    };
+    for (const ExPolygon &expoly : outlines) {
+        add_polygon(expoly.contour);
+        for (const Polygon &hole : expoly.holes)
+            add_polygon(hole);
+    }
+    for (int row = 0; row < height; ++ row) {
+        std::vector<std::pair<double, int>> &crossings = rows[row];
+        std::sort(crossings.begin(), crossings.end());
+        int winding = 0;
+        for (size_t i = 0; i + 1 < crossings.size(); ++ i) {
+            winding += crossings[i].second;
+            if (winding != 0) {
+                int x0 = std::clamp(int(std::ceil(crossings[i].first / sample_distance)), 0, width);
+                int x1 = std::min(width - 1, int(std::ceil(crossings[i + 1].first / sample_distance)) - 1);
+                std::fill(mask.begin() + size_t(row) * width + x0, mask.begin() + size_t(row) * width + std::max(x0, x1 + 1), 1);
+            }
+        }
+    }
+    return mask;
+}
+
+static constexpr const float EDT_INF = 1e20f;
+
+// Squared distance transform of a sampled function f, P. Felzenszwalb and D. Huttenlocher,
+// Distance Transforms of Sampled Functions, 2012.
+static void distance_transform_1d(const float *f, int n, float *d, int *v, float *z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -EDT_INF;
+    z[1] = EDT_INF;
+    for (int q = 1; q < n; ++ q) {
+        // Intersection of the parabolas rooted at q and at v[i].
+        auto intersection = [f, q, v](int i) {
+            return ((f[q] + float(q) * float(q)) - (f[v[i]] + float(v[i]) * float(v[i]))) / (2.f * float(q - v[i]));
+        };
+        float s = intersection(k);
+        while (s <= z[k])
+            s = intersection(-- k);
+        ++ k;
+        v[k]     = q;
+        z[k]     = s;
+        z[k + 1] = EDT_INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++ q) {
+        while (z[k + 1] < float(q))
+            ++ k;
+        d[q] = float(q - v[k]) * float(q - v[k]) + f[v[k]];
+    }
+}
+
+// Squared distance of each sample to the nearest sample of the mask with the given value, in samples.
+static std::vector<float> distance_transform(const std::vector<uint8_t> &mask, uint8_t feature, int width, int height)
+{
+    std::vector<float> out(mask.size());
+    for (size_t i = 0; i < mask.size(); ++ i)
+        out[i] = mask[i] == feature ? 0.f : EDT_INF;
+    const int          n = std::max(width, height);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int>   v(n);
+    for (int x = 0; x < width; ++ x) {
+        for (int y = 0; y < height; ++ y)
+            f[y] = out[size_t(y) * width + x];
+        distance_transform_1d(f.data(), height, d.data(), v.data(), z.data());
+        for (int y = 0; y < height; ++ y)
+            out[size_t(y) * width + x] = d[y];
+    }
+    for (int y = 0; y < height; ++ y) {
+        float *row = out.data() + size_t(y) * width;
+        std::copy(row, row + width, f.begin());
+        distance_transform_1d(f.data(), width, row, v.data(), z.data());
+    }
+    return out;
+}
+
+TreeSupportDistanceField::TreeSupportDistanceField(const std::vector<ExPolygons> &layer_outlines, const BoundingBox &domain, coordf_t xy_distance,
+                                                   const std::vector<double> &max_move_distances, coordf_t resolution, coordf_t max_radius) :
+    m_origin(domain.min), m_resolution(resolution), m_max_radius(max_radius)
+{
+    assert(resolution > 0);
+    assert(max_move_distances.size() >= layer_outlines.size());
+    const double sample_distance = scale_(resolution);
+    const int    width           = int(std::ceil(double(domain.max.x() - domain.min.x()) / sample_distance)) + 1;
+    const int    height          = int(std::ceil(double(domain.max.y() - domain.min.y()) / sample_distance)) + 1;
+    // Samples at and above the clamp value are not stored.
+    const float  clamp           = float(max_radius + 2. * resolution);
+    // 1/32 of a sample distance, which leaves about 65535 / 32 samples of depth below zero.
+    const float  collision_step   = float(resolution / 32.);
+    const float  collision_offset = clamp - collision_step * float(std::numeric_limits<uint16_t>::max());
+    const float  avoidance_offset = float(-2. * resolution);
+    const float  avoidance_step   = (clamp - avoidance_offset) / float(std::numeric_limits<uint8_t>::max());
+
+    m_collision.assign(layer_outlines.size(), {});
+    m_avoidance.assign(layer_outlines.size(), {});
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layer_outlines.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+            if (layer_outlines[layer_idx].empty())
+                continue;
+            std::vector<uint8_t> mask          = rasterize(layer_outlines[layer_idx], m_origin, sample_distance, width, height);
+            std::vector<float>   dist_inside   = distance_transform(mask, 1, width, height);
+            std::vector<float>   dist_outside  = distance_transform(mask, 0, width, height);
+            std::vector<float>  &values        = dist_inside;
+            for (size_t i = 0; i < mask.size(); ++ i)
+                // The outline passes half way between the samples inside and the samples outside.
+                values[i] = (mask[i] ? 0.5f - std::sqrt(dist_outside[i]) : std::sqrt(dist_inside[i]) - 0.5f) * float(resolution) - float(xy_distance);
+            m_collision[layer_idx].assign(values, width, height, collision_offset, collision_step, clamp);
+        }
+    });
+
+    // Each layer depends on the layer below, the samples of a layer are processed in parallel.
+    std::vector<float> avoidance(size_t(width) * size_t(height), EDT_INF);
+    for (size_t layer_idx = 0; layer_idx < layer_outlines.size(); ++ layer_idx) {
+        const Field<uint16_t> &collision = m_collision[layer_idx];
+        const float            max_move  = layer_idx > 0 ? float(max_move_distances[layer_idx - 1]) : 0.f;
+        tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int> &range) {
+            for (int y = range.begin(); y < range.end(); ++ y)
+                for (int x = 0; x < width; ++ x) {
+                    float &value = avoidance[size_t(y) * width + x];
+                    value = std::min(collision.sample(x, y), value + max_move);
+                }
+        });
+        m_avoidance[layer_idx].assign(avoidance, width, height, avoidance_offset, avoidance_step, clamp);
+    }
+}
+
+size_t TreeSupportDistanceField::memory() const
+{
+    size_t out = 0;
+    for (const Field<uint16_t> &field : m_collision)
+        out += field.samples.capacity() * sizeof(uint16_t);
+    for (const Field<uint8_t> &field : m_avoidance)
+        out += field.samples.capacity() * sizeof(uint8_t);
+    return out;
+}
+
+template<typename Sample>
+float TreeSupportDistanceField::Field<Sample>::sample(int x, int y) const
+{
+    x -= x0;
+    y -= y0;
+    return offset + step * float(x < 0 || y < 0 || x >= width || y >= height ?
+        std::numeric_limits<Sample>::max() : samples[size_t(y) * width + x]);
+}
+
+template<typename Sample>
+float TreeSupportDistanceField::Field<Sample>::value(const Point &pt, const Point &origin, coordf_t resolution) const
+{
+    const double sample_distance = scale_(resolution);
+    const double fx = double(pt.x() - origin.x()) / sample_distance;
+    const double fy = double(pt.y() - origin.y()) / sample_distance;
+    const double ix = std::floor(fx);
+    const double iy = std::floor(fy);
+    if (ix < double(x0 - 1) || iy < double(y0 - 1) || ix >= double(x0 + width) || iy >= double(y0 + height))
+        // Not even interpolated from the stored samples.
+        return this->sample(x0 - 1, y0 - 1);
+    const int   x  = int(ix);
+    const int   y  = int(iy);
+    const float tx = float(fx - ix);
+    const float ty = float(fy - iy);
+    return (1.f - ty) * ((1.f - tx) * this->sample(x, y)     + tx * this->sample(x + 1, y)) +
+                  ty  * ((1.f - tx) * this->sample(x, y + 1) + tx * this->sample(x + 1, y + 1));
+}
+
+template<typename Sample>
+ExPolygons TreeSupportDistanceField::Field<Sample>::contours(coordf_t threshold, const Point &origin, coordf_t resolution) const
+{
+    if (samples.empty())
+        return {};
+
+    // Grid padded by a ring of the clamped samples, which are all above the threshold, thus the contours are closed.
+    const int    grid_width  = width + 2;
+    const int    grid_height = height + 2;
+    const float  t           = float(threshold);
+    // Classified by the quantized samples: offset + step * sample < t.
+    const int    sample_threshold = int(std::ceil((t - offset) / step));
+    std::vector<uint8_t> inside(size_t(grid_width) * size_t(grid_height), 0);
+    for (int y = 0; y < height; ++ y) {
+        const Sample *src = samples.data() + size_t(y) * width;
+        uint8_t      *dst = inside.data() + size_t(y + 1) * grid_width + 1;
+        for (int x = 0; x < width; ++ x)
+            dst[x] = int(src[x]) < sample_threshold;
+    }
+    auto grid_sample = [this, grid_width](size_t sample_idx) {
+        return this->sample(x0 - 1 + int(sample_idx % grid_width), y0 - 1 + int(sample_idx / grid_width));
+    };
+
+    // Edges of the grid: 2 * sample index for the edge to the right of a sample, 2 * sample index + 1 for the edge above it.
+    const double sample_distance = scale_(resolution);
+    auto         edge_point      = [&](uint32_t edge) {
+        const size_t sample_idx = edge / 2;
+        const bool   vertical   = edge & 1;
+        const float  a          = grid_sample(sample_idx);
+        const float  b          = grid_sample(sample_idx + (vertical ? grid_width : 1));
+        const double s          = double((t - a) / (b - a));
+        const int    x          = int(sample_idx % grid_width);
+        const int    y          = int(sample_idx / grid_width);
+        return Point(coord_t(std::round(origin.x() + (x0 - 1 + x + (vertical ? 0. : s)) * sample_distance)),
+                     coord_t(std::round(origin.y() + (y0 - 1 + y + (vertical ? s : 0.)) * sample_distance)));
+    };
+
+    // The contours run around the areas inside counter-clockwise. Each crossed edge starts a segment in one cell
+    // and ends a segment in the neighboring cell, next links the segments.
+    std::vector<int32_t>  next(2 * inside.size(), -1);
+    std::vector<uint32_t> starts;
+    for (int y = 0; y + 1 < grid_height; ++ y)
+        for (int x = 0; x + 1 < grid_width; ++ x) {
+            if (x + 8 <= grid_width) {
+                // Skip the 7 cells between 8 samples of two rows, if all of them are inside or all are outside.
+                uint64_t below, above;
+                memcpy(&below, inside.data() + size_t(y) * grid_width + x, 8);
+                memcpy(&above, inside.data() + size_t(y + 1) * grid_width + x, 8);
+                if (below == above && (below == 0 || below == 0x0101010101010101ull)) {
+                    x += 6;
+                    continue;
+                }
+            }
+            // Corners and edges of the cell counter-clockwise from the bottom left, edge i runs from corner i to corner i + 1.
+            const size_t corners[4] = { size_t(y) * grid_width + x, size_t(y) * grid_width + x + 1, size_t(y + 1) * grid_width + x + 1, size_t(y + 1) * grid_width + x };
+            const bool   in[4]      = { bool(inside[corners[0]]), bool(inside[corners[1]]), bool(inside[corners[2]]), bool(inside[corners[3]]) };
+            if (in[0] == in[1] && in[1] == in[2] && in[2] == in[3])
+                continue;
+            const uint32_t edges[4] = { uint32_t(2 * corners[0]), uint32_t(2 * corners[1] + 1), uint32_t(2 * corners[3]), uint32_t(2 * corners[0] + 1) };
+            if (in[0] == in[2] && in[1] == in[3]) {
+                // Saddle, decided by the value at the center of the cell.
+                const bool center_inside = 0.25f * (grid_sample(corners[0]) + grid_sample(corners[1]) + grid_sample(corners[2]) + grid_sample(corners[3])) < t;
+                for (int i = in[0] ? 0 : 1; i < 4; i += 2) {
+                    // Connected: around the corner outside, separated: around the corner inside.
+                    next[edges[i]] = int32_t(edges[center_inside ? (i + 1) % 4 : (i + 3) % 4]);
+                    starts.emplace_back(edges[i]);
+                }
+            } else {
+                int start = -1, end = -1;
+                for (int i = 0; i < 4; ++ i)
+                    if (in[i] && ! in[(i + 1) % 4])
+                        start = i;
+                    else if (! in[i] && in[(i + 1) % 4])
+                        end = i;
+                next[edges[start]] = int32_t(edges[end]);
+                starts.emplace_back(edges[start]);
+            }
+        }
+
+    Polygons polygons;
+    for (uint32_t first : starts)
+        if (next[first] != -1) {
+            Polygon polygon;
+            for (uint32_t edge = first; next[edge] != -1;) {
+                polygon.points.emplace_back(edge_point(edge));
+                edge = uint32_t(std::exchange(next[edge], -1));
+            }
+            polygon.douglas_peucker(SCALED_EPSILON);
+            if (polygon.size() >= 3)
+                polygons.emplace_back(std::move(polygon));
+        }
+    // Holes run clockwise.
+    return union_ex(polygons);
+}
+
+template<typename Sample>
+void TreeSupportDistanceField::Field<Sample>::assign(const std::vector<float> &values, int grid_width, int grid_height, float offset_, float step_, float clamp)
+{
+    offset = offset_;
+    step   = step_;
+    int xmin = grid_width, ymin = grid_height, xmax = -1, ymax = -1;
+    for (int y = 0; y < grid_height; ++ y)
+        for (int x = 0; x < grid_width; ++ x)
+            if (values[size_t(y) * grid_width + x] < clamp) {
+                xmin = std::min(xmin, x);
+                xmax = std::max(xmax, x);
+                ymin = std::min(ymin, y);
+                ymax = std::max(ymax, y);
+            }
+    samples.clear();
+    if (xmax < xmin) {
+        x0 = y0 = width = height = 0;
+        return;
+    }
+    x0     = xmin;
+    y0     = ymin;
+    width  = xmax - xmin + 1;
+    height = ymax - ymin + 1;
+    samples.reserve(size_t(width) * size_t(height));
+    const float max_sample = float(std::numeric_limits<Sample>::max());
+    for (int y = ymin; y <= ymax; ++ y)
+        for (int x = xmin; x <= xmax; ++ x)
+            samples.emplace_back(Sample(std::clamp(std::round((values[size_t(y) * grid_width + x] - offset) / step), 0.f, max_sample)));
+}
+
+template struct TreeSupportDistanceField::Field<uint8_t>;
+template struct TreeSupportDistanceField::Field<uint16_t>;
+
+} // namespace Slic3r
@@ -0,0 +1,99 @@
+#ifndef slic3r_TreeSupportDistanceField_hpp_
+#define slic3r_TreeSupportDistanceField_hpp_
+
+#include "../libslic3r.h"
+#include "../BoundingBox.hpp"
+#include "../ExPolygon.hpp"
+#include "../Point.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Slic3r {
+
+// Collision and avoidance areas of the tree supports for any branch radius, answered from signed distance fields
+// of the layer outlines rasterized once, instead of offsetting the outlines for each radius.
+//
+// The collision field of a layer is the signed distance to its outlines minus the XY distance, thus the collision area
+// of a branch with radius r is the area where the field is below r. The avoidance of a layer is the collision of the layer
+// and the avoidance of the layer below shrunk by the maximum move distance, its field is therefore
+//
+//     avoidance[layer] = min(collision[layer], avoidance[layer - 1] + max_move_distance[layer - 1])
+//
+// which is thresholded the same way. Shrinking a thresholded field by adding a constant is exact for a distance field
+// and a close approximation for the minimum of the shifted distance fields, corners are rounded instead of mitered.
+//
+// The fields are sampled on a grid of the given resolution covering the domain bounding box, outlines outside
+// of the domain (the machine border) are only considered where they reach into the domain. Only radii up to max_radius
+// are answered, the fields are clamped above. Samples are stored quantized and each layer only stores the bounding box
+// of its samples below the clamp. The fields are immutable once built, thus all queries are thread safe.
+class TreeSupportDistanceField
+{
+public:
+    TreeSupportDistanceField() = default;
+    // layer_outlines:     outlines of the object layers, scaled.
+    // domain:             area, which the fields cover, scaled.
+    // max_move_distances: shrinking of the avoidance per layer, in mm.
+    // xy_distance, resolution, max_radius: in mm.
+    TreeSupportDistanceField(const std::vector<ExPolygons> &layer_outlines, const BoundingBox &domain, coordf_t xy_distance,
+                             const std::vector<double> &max_move_distances, coordf_t resolution, coordf_t max_radius);
+
+    bool        empty() const { return m_collision.empty(); }
+    size_t      num_layers() const { return m_collision.size(); }
+    coordf_t    resolution() const { return m_resolution; }
+    // Largest radius answered, in mm.
+    coordf_t    max_radius() const { return m_max_radius; }
+    bool        covers(coordf_t radius) const { return ! this->empty() && radius <= m_max_radius; }
+
+    // Would a branch of the radius (in mm) centered at the point collide with the layer outlines?
+    bool        collides(const Point &pt, coordf_t radius, size_t layer_idx) const
+        { return m_collision[layer_idx].value(pt, m_origin, m_resolution) < radius; }
+    // Would a branch of the radius (in mm) centered at the point be unable to reach the build plate?
+    bool        in_avoidance(const Point &pt, coordf_t radius, size_t layer_idx) const
+        { return m_avoidance[layer_idx].value(pt, m_origin, m_resolution) < radius; }
+
+    // Areas, which the centers of branches of the radius (in mm) have to avoid, scaled.
+    ExPolygons  collision(coordf_t radius, size_t layer_idx) const
+        { return m_collision[layer_idx].contours(radius, m_origin, m_resolution); }
+    ExPolygons  avoidance(coordf_t radius, size_t layer_idx) const
+        { return m_avoidance[layer_idx].contours(radius, m_origin, m_resolution); }
+
+    // Memory held by the fields, in bytes.
+    size_t      memory() const;
+
+private:
+    // Samples of a layer inside its bounding box [x0, x0 + width) x [y0, y0 + height) of grid indices.
+    // The samples outside of the bounding box are clamped.
+    template<typename Sample>
+    struct Field
+    {
+        int                 x0 { 0 };
+        int                 y0 { 0 };
+        int                 width { 0 };
+        int                 height { 0 };
+        // Sample value = offset + step * sample.
+        float               offset { 0 };
+        float               step { 1 };
+        std::vector<Sample> samples;
+
+        float      sample(int x, int y) const;
+        // Bilinear interpolation at a scaled point.
+        float      value(const Point &pt, const Point &origin, coordf_t resolution) const;
+        // Marching squares of the area below the threshold.
+        ExPolygons contours(coordf_t threshold, const Point &origin, coordf_t resolution) const;
+        // Stores the samples of a width x height grid below the clamp value.
+        void       assign(const std::vector<float> &values, int width, int height, float offset, float step, float clamp);
+    };
+
+    // The collision is stored in 16 bits to keep the depth inside of the outlines, which the avoidance of the layers
+    // above is shrunk into. Only the avoidance below max_radius is ever thresholded, 8 bits are enough.
+    std::vector<Field<uint16_t>> m_collision;
+    std::vector<Field<uint8_t>>  m_avoidance;
+    Point                        m_origin { 0, 0 };
+    coordf_t                     m_resolution { 0 };
+    coordf_t                     m_max_radius { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_TreeSupportDistanceField_hpp_
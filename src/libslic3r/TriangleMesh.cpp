@@ -21,8 +21,10 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <string_view>
 #include <type_traits>
 
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
@@ -30,6 +32,8 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include <ankerl/unordered_dense.h>
+
 #include <assert.h>
 
 namespace Slic3r {
@@ -643,6 +647,19 @@ static inline std::vector<Vec3i> its_face_edge_ids_impl(const indexed_triangle_s
     return out;
 }
 
+uint64_t its_hash(const indexed_triangle_set &its)
+{
+    auto hash_bytes = [](const void *data, size_t size) -> uint64_t {
+        return ankerl::unordered_dense::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(data), size));
+    };
+    size_t seed = 0;
+    boost::hash_combine(seed, its.vertices.size());
+    boost::hash_combine(seed, hash_bytes(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex)));
+    boost::hash_combine(seed, its.indices.size());
+    boost::hash_combine(seed, hash_bytes(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices)));
+    return uint64_t(seed);
+}
+
 std::vector<Vec3i> its_face_edge_ids(const indexed_triangle_set &its)
 {
     return its_face_edge_ids_impl(its, [](const uint32_t){ return true; }, [](){});
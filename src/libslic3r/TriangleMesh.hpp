@@ -188,6 +188,10 @@ private:
     std::vector<size_t>     m_vertex_faces_all;
 };
 
+// 64bit hash of the vertices and indices of the mesh. Meshes with the same hash are considered identical,
+// for example by the SliceCache.
+uint64_t its_hash(const indexed_triangle_set &its);
+
 // Map from a face edge to a unique edge identifier or -1 if no neighbor exists.
 // Two neighbor faces share a unique edge identifier even if they are flipped.
 // Used for chaining slice lines into polygons.
@@ -8,8 +8,11 @@
 #include "MeshBoolean.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <deque>
+#include <memory>
+#include <numeric>
 #include <queue>
 #include <mutex>
 #include <utility>
@@ -17,6 +20,21 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+// Kernels intersecting batches of facets with slicing planes, see slice_facet_batch().
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SLIC3R_SLICE_FACET_AVX2
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #define SLIC3R_TARGET_AVX2
+    #else
+        #define SLIC3R_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SLIC3R_SLICE_FACET_NEON
+    #include <arm_neon.h>
+#endif
 
 #ifndef NDEBUG
 //    #define EXPENSIVE_DEBUG_CHECKS
@@ -472,41 +490,228 @@ static FacetSliceType slice_facet_for_cut_mesh(
     return FacetSliceType::NoSlice;
 }
 
-template<typename TransformVertex>
-void slice_facet_at_zs(
-    // Scaled or unscaled vertices. transform_vertex_fn may scale zs.
-    const std::vector<Vec3f>                         &mesh_vertices,
-    const TransformVertex                            &transform_vertex_fn,
-    const stl_triangle_vertex_indices                &indices,
-    const Vec3i                                      &edge_ids,
-    // Scaled or unscaled zs. If vertices have their zs scaled or transform_vertex_fn scales them, then zs have to be scaled as well.
-    const std::vector<float>                         &zs,
-    std::vector<IntersectionLines>                   &lines,
-    std::array<std::mutex, 64>                       &lines_mutex)
+// Batch of facets paired with slicing planes in a structure of arrays layout, intersected by slice_facet_batch().
+// The kernels handle the general case of slice_facet(), where the plane crosses two edges of a facet and no vertex lies on the plane,
+// they flag the other pairs to be sliced by slice_facet().
+struct FacetPlaneBatch
 {
-    stl_vertex vertices[3] { transform_vertex_fn(mesh_vertices[indices(0)]), transform_vertex_fn(mesh_vertices[indices(1)]), transform_vertex_fn(mesh_vertices[indices(2)]) };
+    static constexpr const int     capacity = 256;
+    // Result of a pair to be sliced by slice_facet().
+    static constexpr const uint8_t special  = 0xff;
+
+    int     size { 0 };
+    // Edge k of a facet connects its vertices k and (k + 1) % 3. The end points a, b of an edge are sorted by their vertex indices
+    // the same way slice_facet() sorts them to calculate the same intersection. XY scaled, Z scaled or unscaled (same as slice_z).
+    double  ax[3][capacity], ay[3][capacity], az[3][capacity];
+    double  bx[3][capacity], by[3][capacity], bz[3][capacity];
+    double  slice_z[capacity];
+    int     face_idx[capacity];
+    int     layer[capacity];
+    int     idx_vertex_lowest[capacity];
+    // Output: Intersections of the facet edges with the plane rounded to integers, valid for the edges crossing the plane.
+    double  px[3][capacity], py[3][capacity];
+    // Output: Bit mask of the edges crossing the plane, zero if the facet does not cross the plane, or special.
+    uint8_t result[capacity];
+};
 
-    // find facet extents
-    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
-    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
+static void slice_facet_batch_scalar(FacetPlaneBatch &batch, int begin, int end)
+{
+    for (int i = begin; i < end; ++ i) {
+        const double slice_z  = batch.slice_z[i];
+        uint8_t      crossing = 0;
+        bool         special  = false;
+        for (int k = 0; k < 3; ++ k) {
+            const double az = batch.az[k][i];
+            const double bz = batch.bz[k][i];
+            if (az == slice_z || bz == slice_z)
+                special = true;
+            else if ((az < slice_z && bz > slice_z) || (bz < slice_z && az > slice_z)) {
+                // The same expressions as in slice_facet() to round the same way.
+                const double t = (slice_z - bz) / (az - bz);
+                if (t <= 0. || t >= 1.)
+                    // Intersection snapped to a vertex.
+                    special = true;
+                batch.px[k][i] = floor(batch.bx[k][i] + (batch.ax[k][i] - batch.bx[k][i]) * t + 0.5);
+                batch.py[k][i] = floor(batch.by[k][i] + (batch.ay[k][i] - batch.by[k][i]) * t + 0.5);
+                crossing |= uint8_t(1 << k);
+            }
+        }
+        batch.result[i] = special ? FacetPlaneBatch::special : crossing;
+    }
+}
 
-    // find layer extents
-    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
-    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
-    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
-
-    for (auto it = min_layer; it != max_layer; ++ it) {
-        IntersectionLine il;
-        // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-        if (min_z != max_z && slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
-            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
-            size_t slice_id = it - zs.begin();
-            boost::lock_guard<std::mutex> l(lines_mutex[slice_id % lines_mutex.size()]);
-            lines[slice_id].emplace_back(il);
+#ifdef SLIC3R_SLICE_FACET_AVX2
+// Four pairs at a time. Only the add, subtract, multiply and divide instructions are used, never a fused multiply-add,
+// so that the intersections are rounded the same way as by slice_facet().
+SLIC3R_TARGET_AVX2 static void slice_facet_batch_avx2(FacetPlaneBatch &batch, int begin, int end)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one  = _mm256_set1_pd(1.);
+    const __m256d half = _mm256_set1_pd(0.5);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m256d slice_z = _mm256_loadu_pd(batch.slice_z + i);
+        int special  = 0;
+        int crossing[3];
+        for (int k = 0; k < 3; ++ k) {
+            const __m256d az    = _mm256_loadu_pd(batch.az[k] + i);
+            const __m256d bz    = _mm256_loadu_pd(batch.bz[k] + i);
+            const __m256d on    = _mm256_or_pd(_mm256_cmp_pd(az, slice_z, _CMP_EQ_OQ), _mm256_cmp_pd(bz, slice_z, _CMP_EQ_OQ));
+            const __m256d cross = _mm256_or_pd(
+                _mm256_and_pd(_mm256_cmp_pd(az, slice_z, _CMP_LT_OQ), _mm256_cmp_pd(bz, slice_z, _CMP_GT_OQ)),
+                _mm256_and_pd(_mm256_cmp_pd(bz, slice_z, _CMP_LT_OQ), _mm256_cmp_pd(az, slice_z, _CMP_GT_OQ)));
+            // Division by zero for horizontal edges, which do not cross the plane and which are masked out.
+            const __m256d t     = _mm256_div_pd(_mm256_sub_pd(slice_z, bz), _mm256_sub_pd(az, bz));
+            const __m256d snap  = _mm256_and_pd(cross, _mm256_or_pd(_mm256_cmp_pd(t, zero, _CMP_LE_OQ), _mm256_cmp_pd(t, one, _CMP_GE_OQ)));
+            special    |= _mm256_movemask_pd(_mm256_or_pd(on, snap));
+            crossing[k] = _mm256_movemask_pd(cross);
+            const __m256d ax = _mm256_loadu_pd(batch.ax[k] + i);
+            const __m256d bx = _mm256_loadu_pd(batch.bx[k] + i);
+            const __m256d ay = _mm256_loadu_pd(batch.ay[k] + i);
+            const __m256d by = _mm256_loadu_pd(batch.by[k] + i);
+            _mm256_storeu_pd(batch.px[k] + i, _mm256_floor_pd(_mm256_add_pd(_mm256_add_pd(bx, _mm256_mul_pd(_mm256_sub_pd(ax, bx), t)), half)));
+            _mm256_storeu_pd(batch.py[k] + i, _mm256_floor_pd(_mm256_add_pd(_mm256_add_pd(by, _mm256_mul_pd(_mm256_sub_pd(ay, by), t)), half)));
+        }
+        for (int lane = 0; lane < 4; ++ lane)
+            batch.result[i + lane] = (special >> lane) & 1 ? FacetPlaneBatch::special :
+                uint8_t(((crossing[0] >> lane) & 1) | (((crossing[1] >> lane) & 1) << 1) | (((crossing[2] >> lane) & 1) << 2));
+    }
+    slice_facet_batch_scalar(batch, i, end);
+}
+
+#endif // SLIC3R_SLICE_FACET_AVX2
+
+#ifdef SLIC3R_SLICE_FACET_NEON
+// Two pairs at a time, see slice_facet_batch_avx2().
+static void slice_facet_batch_neon(FacetPlaneBatch &batch, int begin, int end)
+{
+    const float64x2_t zero = vdupq_n_f64(0.);
+    const float64x2_t one  = vdupq_n_f64(1.);
+    const float64x2_t half = vdupq_n_f64(0.5);
+    int i = begin;
+    for (; i + 2 <= end; i += 2) {
+        const float64x2_t slice_z = vld1q_f64(batch.slice_z + i);
+        uint64x2_t        special = vdupq_n_u64(0);
+        uint64x2_t        crossing[3];
+        for (int k = 0; k < 3; ++ k) {
+            const float64x2_t az    = vld1q_f64(batch.az[k] + i);
+            const float64x2_t bz    = vld1q_f64(batch.bz[k] + i);
+            const uint64x2_t  on    = vorrq_u64(vceqq_f64(az, slice_z), vceqq_f64(bz, slice_z));
+            const uint64x2_t  cross = vorrq_u64(
+                vandq_u64(vcltq_f64(az, slice_z), vcgtq_f64(bz, slice_z)),
+                vandq_u64(vcltq_f64(bz, slice_z), vcgtq_f64(az, slice_z)));
+            const float64x2_t t     = vdivq_f64(vsubq_f64(slice_z, bz), vsubq_f64(az, bz));
+            const uint64x2_t  snap  = vandq_u64(cross, vorrq_u64(vcleq_f64(t, zero), vcgeq_f64(t, one)));
+            special     = vorrq_u64(special, vorrq_u64(on, snap));
+            crossing[k] = cross;
+            const float64x2_t ax = vld1q_f64(batch.ax[k] + i);
+            const float64x2_t bx = vld1q_f64(batch.bx[k] + i);
+            const float64x2_t ay = vld1q_f64(batch.ay[k] + i);
+            const float64x2_t by = vld1q_f64(batch.by[k] + i);
+            vst1q_f64(batch.px[k] + i, vrndmq_f64(vaddq_f64(vaddq_f64(bx, vmulq_f64(vsubq_f64(ax, bx), t)), half)));
+            vst1q_f64(batch.py[k] + i, vrndmq_f64(vaddq_f64(vaddq_f64(by, vmulq_f64(vsubq_f64(ay, by), t)), half)));
+        }
+        auto result = [](uint64_t special_lane, uint64_t crossing0, uint64_t crossing1, uint64_t crossing2) {
+            return special_lane ? FacetPlaneBatch::special : uint8_t((crossing0 & 1) | ((crossing1 & 1) << 1) | ((crossing2 & 1) << 2));
+        };
+        batch.result[i]     = result(vgetq_lane_u64(special, 0), vgetq_lane_u64(crossing[0], 0), vgetq_lane_u64(crossing[1], 0), vgetq_lane_u64(crossing[2], 0));
+        batch.result[i + 1] = result(vgetq_lane_u64(special, 1), vgetq_lane_u64(crossing[0], 1), vgetq_lane_u64(crossing[1], 1), vgetq_lane_u64(crossing[2], 1));
+    }
+    slice_facet_batch_scalar(batch, i, end);
+}
+#endif // SLIC3R_SLICE_FACET_NEON
+
+static SliceFacetKernel best_slice_facet_kernel()
+{
+#if defined(SLIC3R_SLICE_FACET_AVX2)
+    if (cpu_supports_avx2())
+        return SliceFacetKernel::AVX2;
+#elif defined(SLIC3R_SLICE_FACET_NEON)
+    // NEON is mandatory on aarch64.
+    return SliceFacetKernel::NEON;
+#endif
+    return SliceFacetKernel::Scalar;
+}
+
+static std::atomic<SliceFacetKernel> s_slice_facet_kernel { best_slice_facet_kernel() };
+
+SliceFacetKernel slice_facet_kernel()
+{
+    return s_slice_facet_kernel.load(std::memory_order_relaxed);
+}
+
+bool set_slice_facet_kernel(SliceFacetKernel kernel)
+{
+    bool supported = kernel == SliceFacetKernel::Scalar;
+#if defined(SLIC3R_SLICE_FACET_AVX2)
+    supported |= kernel == SliceFacetKernel::AVX2 && cpu_supports_avx2();
+#elif defined(SLIC3R_SLICE_FACET_NEON)
+    supported |= kernel == SliceFacetKernel::NEON;
+#endif
+    if (supported)
+        s_slice_facet_kernel.store(kernel, std::memory_order_relaxed);
+    return supported;
+}
+
+// Intersect the facets of the batch with their planes, emit the intersection lines into their layers in the order of the batch,
+// then clear the batch.
+template<typename TransformVertex>
+static void slice_facet_batch(
+    FacetPlaneBatch                                 &batch,
+    const std::vector<stl_vertex>                   &vertices,
+    const TransformVertex                           &transform_vertex_fn,
+    const std::vector<stl_triangle_vertex_indices>  &indices,
+    const std::vector<Vec3i>                        &face_edge_ids,
+    const std::vector<float>                        &zs,
+    std::vector<IntersectionLines>                  &lines)
+{
+    switch (slice_facet_kernel()) {
+#ifdef SLIC3R_SLICE_FACET_AVX2
+    case SliceFacetKernel::AVX2: slice_facet_batch_avx2(batch, 0, batch.size); break;
+#endif
+#ifdef SLIC3R_SLICE_FACET_NEON
+    case SliceFacetKernel::NEON: slice_facet_batch_neon(batch, 0, batch.size); break;
+#endif
+    default:                     slice_facet_batch_scalar(batch, 0, batch.size); break;
+    }
+
+    for (int i = 0; i < batch.size; ++ i) {
+        const uint8_t result = batch.result[i];
+        if (result == 0)
+            continue;
+        const int    face_idx = batch.face_idx[i];
+        const int    layer    = batch.layer[i];
+        const Vec3i &edge_ids = face_edge_ids[face_idx];
+        if (result == FacetPlaneBatch::special) {
+            // A vertex lies on the plane or an intersection snapped to a vertex.
+            const stl_triangle_vertex_indices &face = indices[face_idx];
+            stl_vertex       facet_vertices[3] { transform_vertex_fn(vertices[face(0)]), transform_vertex_fn(vertices[face(1)]), transform_vertex_fn(vertices[face(2)]) };
+            IntersectionLine il;
+            if (slice_facet(zs[layer], facet_vertices, face, edge_ids, batch.idx_vertex_lowest[i], false, il) == FacetSliceType::Slicing) {
+                assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                lines[layer].emplace_back(il);
+            }
+        } else {
+            // Two edges cross the plane. slice_facet() visits the edges starting with the edge at the lowest vertex,
+            // the intersection line starts at the second intersection found.
+            assert(result == 3 || result == 5 || result == 6);
+            const int lowest = batch.idx_vertex_lowest[i];
+            const int other  = result == 3 ? 2 : result == 5 ? 1 : 0;
+            const int first  = other == lowest ? next_idx_modulo(lowest, 3) : lowest;
+            const int second = other == prev_idx_modulo(lowest, 3) ? next_idx_modulo(lowest, 3) : prev_idx_modulo(lowest, 3);
+            IntersectionLine &il = lines[layer].emplace_back();
+            il.a         = Point(coord_t(batch.px[second][i]), coord_t(batch.py[second][i]));
+            il.b         = Point(coord_t(batch.px[first][i]), coord_t(batch.py[first][i]));
+            il.edge_a_id = edge_ids(second);
+            il.edge_b_id = edge_ids(first);
         }
     }
+    batch.size = 0;
 }
 
+// Slicing is layer major: The facets are sorted into blocks of consecutive layers they span,
+// then each block of layers is sliced by a single task without any locking,
+// producing the intersection lines of a layer ordered by the facet index.
 template<typename TransformVertex, typename ThrowOnCancel>
 static inline std::vector<IntersectionLines> slice_make_lines(
     const std::vector<stl_vertex>                   &vertices,
@@ -517,14 +722,97 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     const ThrowOnCancel                              throw_on_cancel_fn)
 {
     std::vector<IntersectionLines>  lines(zs.size(), IntersectionLines());
-    std::array<std::mutex, 64>      lines_mutex;
+    if (zs.empty() || indices.empty())
+        return lines;
+
+    // 1) Find the range of layers [first, second) crossed by each facet.
+    std::vector<std::pair<int, int>> face_layers(indices.size());
     tbb::parallel_for(
         tbb::blocked_range<int>(0, int(indices.size())),
-        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
+        [&vertices, &transform_vertex_fn, &indices, &zs, &face_layers, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
             for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
                 if ((face_idx & 0x0ffff) == 0)
                     throw_on_cancel_fn();
-                slice_facet_at_zs(vertices, transform_vertex_fn, indices[face_idx], face_edge_ids[face_idx], zs, lines, lines_mutex);
+                const stl_triangle_vertex_indices &face = indices[face_idx];
+                const float z0    = transform_vertex_fn(vertices[face(0)]).z();
+                const float z1    = transform_vertex_fn(vertices[face(1)]).z();
+                const float z2    = transform_vertex_fn(vertices[face(2)]).z();
+                const float min_z = fminf(z0, fminf(z1, z2));
+                const float max_z = fmaxf(z0, fmaxf(z1, z2));
+                // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
+                if (min_z == max_z) {
+                    face_layers[face_idx] = { 0, 0 };
+                } else {
+                    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
+                    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
+                    face_layers[face_idx] = { int(min_layer - zs.begin()), int(max_layer - zs.begin()) };
+                }
+            }
+        });
+
+    // 2) Sort the facets into blocks of layers. A facet spanning multiple blocks is assigned to each of them.
+    const int num_blocks       = std::min(int(zs.size()), 16 * std::max(1, tbb::this_task_arena::max_concurrency()));
+    const int layers_per_block = (int(zs.size()) + num_blocks - 1) / num_blocks;
+    std::vector<size_t> block_offsets(num_blocks + 1, 0);
+    for (const std::pair<int, int> &fl : face_layers)
+        if (fl.first < fl.second)
+            for (int block = fl.first / layers_per_block; block <= (fl.second - 1) / layers_per_block; ++ block)
+                ++ block_offsets[block + 1];
+    std::partial_sum(block_offsets.begin(), block_offsets.end(), block_offsets.begin());
+    std::vector<int> block_faces(block_offsets.back());
+    {
+        std::vector<size_t> cursor(block_offsets.begin(), block_offsets.end() - 1);
+        for (int face_idx = 0; face_idx < int(face_layers.size()); ++ face_idx) {
+            const std::pair<int, int> &fl = face_layers[face_idx];
+            if (fl.first < fl.second)
+                for (int block = fl.first / layers_per_block; block <= (fl.second - 1) / layers_per_block; ++ block)
+                    block_faces[cursor[block] ++] = face_idx;
+        }
+    }
+    throw_on_cancel_fn();
+
+    // 3) Slice the blocks of layers in parallel, each task owns its layers. The facets are paired with the layers they span
+    //    and intersected in batches, see slice_facet_batch().
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, num_blocks, 1),
+        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &face_layers, &block_offsets, &block_faces, layers_per_block, &lines, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
+            auto batch = std::make_unique<FacetPlaneBatch>();
+            for (int block = range.begin(); block < range.end(); ++ block) {
+                const int layer_begin = block * layers_per_block;
+                const int layer_end   = std::min(int(zs.size()), layer_begin + layers_per_block);
+                for (size_t i = block_offsets[block]; i < block_offsets[block + 1]; ++ i) {
+                    if ((i & 0x0ffff) == 0)
+                        throw_on_cancel_fn();
+                    const int                          face_idx = block_faces[i];
+                    const std::pair<int, int>         &fl       = face_layers[face_idx];
+                    const stl_triangle_vertex_indices &face     = indices[face_idx];
+                    const stl_vertex facet_vertices[3] { transform_vertex_fn(vertices[face(0)]), transform_vertex_fn(vertices[face(1)]), transform_vertex_fn(vertices[face(2)]) };
+                    const float      min_z             = fminf(facet_vertices[0].z(), fminf(facet_vertices[1].z(), facet_vertices[2].z()));
+                    const int        idx_vertex_lowest = (facet_vertices[1].z() == min_z) ? 1 : ((facet_vertices[2].z() == min_z) ? 2 : 0);
+                    for (int layer = std::max(fl.first, layer_begin); layer < std::min(fl.second, layer_end); ++ layer) {
+                        if (batch->size == FacetPlaneBatch::capacity)
+                            slice_facet_batch(*batch, vertices, transform_vertex_fn, indices, face_edge_ids, zs, lines);
+                        const int j = batch->size ++;
+                        for (int k = 0; k < 3; ++ k) {
+                            int ia = k;
+                            int ib = next_idx_modulo(k, 3);
+                            if (face(ia) > face(ib))
+                                std::swap(ia, ib);
+                            batch->ax[k][j] = facet_vertices[ia].x();
+                            batch->ay[k][j] = facet_vertices[ia].y();
+                            batch->az[k][j] = facet_vertices[ia].z();
+                            batch->bx[k][j] = facet_vertices[ib].x();
+                            batch->by[k][j] = facet_vertices[ib].y();
+                            batch->bz[k][j] = facet_vertices[ib].z();
+                        }
+                        batch->slice_z[j]           = zs[layer];
+                        batch->face_idx[j]          = face_idx;
+                        batch->layer[j]             = layer;
+                        batch->idx_vertex_lowest[j] = idx_vertex_lowest;
+                    }
+                }
+                if (batch->size > 0)
+                    slice_facet_batch(*batch, vertices, transform_vertex_fn, indices, face_edge_ids, zs, lines);
             }
         }
     );
@@ -1877,7 +2165,11 @@ std::vector<Polygons> slice_mesh(
         // Instead of edge identifiers, one shall use a sorted pair of edge vertex indices.
         // However facets_edges assigns a single edge ID to two triangles only, thus when factoring facets_edges out, one will have
         // to make sure that no code relies on it.
-        std::vector<Vec3i> face_edge_ids = its_face_edge_ids(mesh);
+        std::vector<Vec3i>        face_edge_ids_local;
+        if (params.face_edge_ids == nullptr)
+            face_edge_ids_local = its_face_edge_ids(mesh);
+        const std::vector<Vec3i> &face_edge_ids = params.face_edge_ids ? *params.face_edge_ids : face_edge_ids_local;
+        assert(face_edge_ids.size() == mesh.indices.size());
         if (zs.size() <= 1) {
             // It likely is not worthwile to copy the vertices. Apply the transformation in place.
             if (is_identity(params.trafo)) {
@@ -33,6 +33,9 @@ struct MeshSlicingParams
     SlicingMode   mode_below { SlicingMode::Regular };
     // Transforming faces during the slicing.
     Transform3d   trafo { Transform3d::Identity() };
+    // Optional its_face_edge_ids() of the mesh to be sliced, for example cached with the mesh of a ModelVolume.
+    // If null, the edge IDs are calculated by slice_mesh().
+    const std::vector<Vec3i> *face_edge_ids { nullptr };
 };
 
 struct MeshSlicingParamsEx : public MeshSlicingParams
@@ -94,6 +97,18 @@ inline std::vector<ExPolygons>  slice_mesh_ex(
     return slice_mesh_ex(mesh, zs, params, throw_on_cancel);
 }
 
+// Instruction set of the kernel intersecting batches of facets with slicing planes, used by slice_mesh().
+// All the kernels produce the same slices, the fastest kernel supported by the CPU is selected at startup.
+enum class SliceFacetKernel {
+    Scalar,
+    AVX2,
+    NEON,
+};
+
+SliceFacetKernel slice_facet_kernel();
+// Select a kernel for testing and benchmarking. Returns false and keeps the active kernel if the CPU does not support it.
+bool             set_slice_facet_kernel(SliceFacetKernel kernel);
+
 // Slice a triangle set with a set of Z slabs (thick layers).
 // The effect is similar to producing the usual top / bottom layers from a sliced mesh by 
 // subtracting layer[i] from layer[i - 1] for the top surfaces resp.
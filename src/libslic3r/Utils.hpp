@@ -90,6 +90,9 @@ extern std::string log_memory_info(bool ignore_loglevel = false);
 extern void disable_multi_threading();
 // Returns the size of physical memory (RAM) in bytes.
 extern size_t total_physical_memory();
+// Does the CPU support AVX2 instructions and does the OS save the YMM registers?
+// Always false on other than x86 platforms.
+extern bool cpu_supports_avx2();
 
 // Set a path with GUI resource files.
 void set_var_dir(const std::string &path);
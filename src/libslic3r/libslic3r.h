@@ -90,6 +90,10 @@ static constexpr double WIPE_TOWER_MARGIN_AFTER_SLICING = 0.2;
 //BBS: some global const config which user can not change, but developer can
 static constexpr bool g_config_support_sharp_tails = true;
 static constexpr float g_config_tree_support_collision_resolution = 0.2;
+// Answer the collision and avoidance queries of the tree supports from distance fields of the layer outlines sampled
+// at this resolution (mm) instead of offsetting the outlines for each branch radius, see TreeSupportDistanceField.
+static constexpr bool g_config_tree_support_distance_field = false;
+static constexpr float g_config_tree_support_distance_field_resolution = 0.2;
 
 // Write slices as SVG images into out directory during the 2D processing of the slices.
 // #define SLIC3R_DEBUG_SLICE_PROCESSING
@@ -18,7 +18,9 @@
 // Print now includes tbb, and tbb includes Windows. This breaks compilation of wxWidgets if included before wx.
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SLAPrint.hpp"
+#include "libslic3r/AppConfig.hpp"
 #include "libslic3r/Utils.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Format/SL1.hpp"
 #include "libslic3r/Thread.hpp"
@@ -28,6 +30,7 @@
 #include <stdexcept>
 #include <cctype>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/format/format_fwd.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/log/trivial.hpp>
@@ -197,6 +200,9 @@ void BackgroundSlicingProcess::process_fff()
     assert(m_print == m_fff_print);
     PresetBundle &preset_bundle = *wxGetApp().preset_bundle;
     m_fff_print->set_BBL_Printer(preset_bundle.printers.get_edited_preset().is_bbl_vendor_preset(&preset_bundle));
+    // Copy the unchanged layers of the last export of this plate, for example when a pause was inserted.
+    const std::string gcode_layer_cache_size = wxGetApp().app_config->get("gcode_layer_cache_size");
+    m_fff_print->set_gcode_layer_cache_size(gcode_layer_cache_size.empty() ? 0 : size_t(std::max(0, std::atoi(gcode_layer_cache_size.c_str()))) << 20);
 	//BBS: add the logic to process from an existed gcode file
 	if (m_print->finished()) {
 		BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(" %1%: skip slicing, to process previous gcode file")%__LINE__;
@@ -787,13 +793,24 @@ void BackgroundSlicingProcess::export_gcode()
 	//FIXME localize the messages
 	std::string error_message;
 	int copy_ret_val = CopyFileResult::SUCCESS;
-	try
-	{
-		copy_ret_val = copy_file(output_path, export_path, error_message, m_export_path_on_removable_media);
-	}
-	catch (...)
-	{
-		throw Slic3r::ExportError(_utf8(L("Unknown error when export G-code.")));
+	// The binary G-code is selected by the extension of the export path.
+	const bool binary_gcode = boost::iends_with(export_path, ".bgcode");
+	if (binary_gcode) {
+		try {
+			BinaryGCode::convert_ascii_to_binary(output_path, export_path);
+		} catch (const std::exception &ex) {
+			BOOST_LOG_TRIVIAL(error) << "Failed to convert " << output_path << " to binary G-code " << export_path << ": " << ex.what();
+			throw Slic3r::ExportError((boost::format(_utf8(L("Failed to save gcode file.\nError message: %1%.\nSource file %2%."))) % ex.what() % output_path).str());
+		}
+	} else {
+		try
+		{
+			copy_ret_val = copy_file(output_path, export_path, error_message, m_export_path_on_removable_media);
+		}
+		catch (...)
+		{
+			throw Slic3r::ExportError(_utf8(L("Unknown error when export G-code.")));
+		}
 	}
 	switch (copy_ret_val) {
 	case CopyFileResult::SUCCESS: break; // no error
@@ -826,7 +843,8 @@ void BackgroundSlicingProcess::export_gcode()
 	wxQueueEvent(GUI::wxGetApp().mainframe->m_plater, evt);
 
 	// BBS: to be checked. Whether use export_path or output_path.
-	gcode_add_line_number(export_path, m_fff_print->full_print_config());
+	if (! binary_gcode)
+		gcode_add_line_number(export_path, m_fff_print->full_print_config());
 
 }
 
@@ -797,6 +797,7 @@ static const FileWildcards file_wildcards_by_type[FT_SIZE] = {
     /* FT_3MF */     { "3MF files"sv,       { ".3mf"sv } },
     /* FT_GCODE_3MF */ {"Gcode 3MF files"sv, {".gcode.3mf"sv}},
     /* FT_GCODE */   { "G-code files"sv,    { ".gcode"sv } },
+    /* FT_BGCODE */  { "Binary G-code files"sv, { ".bgcode"sv } },
 #ifdef __APPLE__
     /* FT_MODEL */
     {"Supported files"sv, {".3mf"sv, ".stl"sv, ".oltp"sv, ".stp"sv, ".step"sv, ".svg"sv, ".amf"sv, ".obj"sv, ".usd"sv, ".usda"sv, ".usdc"sv, ".usdz"sv, ".abc"sv, ".ply"sv}},
@@ -4196,7 +4197,7 @@ void GUI_App::load_gcode(wxWindow* parent, wxString& input_file) const
     wxFileDialog dialog(parent ? parent : GetTopWindow(),
         _L("Choose one file (gcode/.gco/.g/.ngc/ngc):"),
         app_config->get_last_dir(), "",
-        file_wildcards(FT_GCODE), wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+        file_wildcards(FT_GCODE) + "|" + file_wildcards(FT_BGCODE), wxFD_OPEN | wxFD_FILE_MUST_EXIST);
 
     if (dialog.ShowModal() == wxID_OK)
         input_file = dialog.GetPath();
@@ -6960,7 +6961,7 @@ void GUI_App::MacOpenFiles(const wxArrayString &fileNames)
     std::vector<wxString>    non_gcode_files;
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ", open files, size " << fileNames.size();
     for (const auto& filename : fileNames) {
-        if (is_gcode_file(into_u8(filename)))
+        if (is_gcode_file(into_u8(filename)) || boost::iends_with(into_u8(filename), ".bgcode"))
             gcode_files.emplace_back(filename);
         else {
             files.emplace_back(into_u8(filename));
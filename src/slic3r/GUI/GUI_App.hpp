@@ -102,6 +102,7 @@ enum FileType
     FT_3MF,
     FT_GCODE_3MF,
     FT_GCODE,
+    FT_BGCODE,
     FT_MODEL,
     FT_PROJECT,
     FT_GALLERY,
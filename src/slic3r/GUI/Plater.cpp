@@ -12494,7 +12494,7 @@ void Plater::load_gcode(const wxString& filename)
 {
     BOOST_LOG_TRIVIAL(trace) << __FUNCTION__ << __LINE__ << " entry and filename: " << filename;
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__;
-    if (! is_gcode_file(into_u8(filename))
+    if ((! is_gcode_file(into_u8(filename)) && ! boost::iends_with(into_u8(filename), ".bgcode"))
         || (m_last_loaded_gcode == filename && m_only_gcode)
         )
         return;
@@ -12526,6 +12526,7 @@ void Plater::load_gcode(const wxString& filename)
     // process gcode
     GCodeProcessor processor;
     processor.init_filament_maps_and_nozzle_type_when_import_only_gcode();
+    processor.enable_parallel_parsing(true);
     try
     {
         processor.process_file(filename.ToUTF8().data());
@@ -13904,7 +13905,7 @@ void Plater::export_gcode(bool prefer_removable)
         wxFileDialog dlg(this, (printer_technology() == ptFFF) ? _L("Save G-code file as:") : _L("Save SLA file as:"),
             start_dir,
             from_path(default_output_file.filename()),
-            GUI::file_wildcards((printer_technology() == ptFFF) ? FT_GCODE : FT_SL1, ext),
+            (printer_technology() == ptFFF) ? GUI::file_wildcards(FT_GCODE, ext) + "|" + GUI::file_wildcards(FT_BGCODE) : GUI::file_wildcards(FT_SL1, ext),
             wxFD_SAVE | wxFD_OVERWRITE_PROMPT
         );
         if (dlg.ShowModal() == wxID_OK) {
@@ -13920,6 +13921,9 @@ void Plater::export_gcode(bool prefer_removable)
                     break;
                 }
             }
+            // The binary G-code is exported by the extension of the output path, see BackgroundSlicingProcess::export_gcode().
+            if (! output_path.empty() && printer_technology() == ptFFF && dlg.GetFilterIndex() == 1 && ! boost::iends_with(output_path.string(), ".bgcode"))
+                output_path.replace_extension(".bgcode");
         }
     }
 
@@ -0,0 +1,119 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/GCode/ConflictChecker.hpp"
+
+#include "test_data.hpp"
+
+using namespace Slic3r;
+using namespace Slic3r::Test;
+
+// Single layer of a single square perimeter.
+static ExtrusionLayers square_layers(const Point &min, coord_t size)
+{
+    ExtrusionLayer layer;
+    layer.layer    = nullptr;
+    layer.bottom_z = 0.f;
+    layer.height   = 0.2f;
+    ExtrusionPath path(erPerimeter, 0.05, 0.45f, 0.2f);
+    path.polyline = Polyline({ min, min + Point(size, 0), min + Point(size, size), min + Point(0, size), min });
+    layer.paths.emplace_back(std::move(path));
+    ExtrusionLayers layers;
+    layers.push_back(std::move(layer));
+    return layers;
+}
+
+// Wipe tower of a square outer wall up to 20 mm, centered at center.
+static FakeWipeTower square_wipe_tower(const Vec2d &center, double size)
+{
+    FakeWipeTower wipe_tower;
+    wipe_tower.set_fake_extrusion_data(Vec2f::Zero(), float(size), 20.f, 0.2f, float(size), 0.f, Vec2d::Zero());
+    const Point min = scaled(Vec2d(center - Vec2d(0.5 * size, 0.5 * size)));
+    const Point max = scaled(Vec2d(center + Vec2d(0.5 * size, 0.5 * size)));
+    for (int i = 1; i <= 100; ++ i)
+        wipe_tower.outer_wall[0.2f * float(i)] = { Polyline({ min, Point(max.x(), min.y()), max, Point(min.x(), max.y()), min }) };
+    return wipe_tower;
+}
+
+SCENARIO("ConflictChecker: line intersections", "[ConflictChecker]") {
+    const int obj1 = 0, obj2 = 0;
+    GIVEN("Two crossing lines") {
+        LineWithIDs lines { { Line({ 0, 0 }, { scaled(10.), scaled(10.) }), &obj1, erPerimeter }, { Line({ 0, scaled(10.) }, { scaled(10.), 0 }), &obj2, erPerimeter } };
+        THEN("they conflict if they belong to different objects") {
+            REQUIRE(ConflictChecker::find_inter_of_lines(lines).has_value());
+        }
+        THEN("they do not conflict if they belong to the same object") {
+            lines[1]._id = &obj1;
+            REQUIRE(! ConflictChecker::find_inter_of_lines(lines).has_value());
+        }
+    }
+    GIVEN("Two squares of different objects") {
+        LinesBucketQueue queue;
+        queue.line_buckets.reserve(2);
+        queue.emplace_back_bucket(square_layers({ 0, 0 }, scaled(10.)), &obj1, { 0, 0 });
+        WHEN("the squares are apart") {
+            queue.emplace_back_bucket(square_layers({ scaled(20.), 0 }, scaled(10.)), &obj2, { 0, 0 });
+            THEN("no line is left by the broad phase") {
+                REQUIRE(ConflictChecker::lines_of_overlapping_objs(queue.getCurRanges()).empty());
+            }
+        }
+        WHEN("the squares overlap") {
+            queue.emplace_back_bucket(square_layers({ scaled(5.), scaled(5.) }, scaled(10.)), &obj2, { 0, 0 });
+            LineWithIDs lines = ConflictChecker::lines_of_overlapping_objs(queue.getCurRanges());
+            THEN("only the lines inside the common bounding box are left") {
+                REQUIRE(lines.size() == 4);
+            }
+            THEN("the overlapping lines conflict") {
+                REQUIRE(ConflictChecker::find_inter_of_lines(lines).has_value());
+            }
+        }
+    }
+}
+
+SCENARIO("ConflictChecker: plate of many objects", "[ConflictChecker][benchmark]") {
+    GIVEN("36 arranged cubes") {
+        TriangleMesh cube = mesh(TestMesh::cube_20x20x20);
+        cube.scale(0.5f);
+        std::vector<TriangleMesh> meshes(36, cube);
+        Slic3r::Print print;
+        Slic3r::Model model;
+        init_print(std::move(meshes), print, model, DynamicPrintConfig::full_print_config());
+        print.process();
+        WHEN("the plate is checked for conflicts") {
+            auto result = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {});
+            THEN("no conflict is found") {
+                REQUIRE(! result.has_value());
+            }
+        }
+    }
+}
+
+SCENARIO("ConflictChecker: objects and a wipe tower", "[ConflictChecker]") {
+    GIVEN("Two arranged cubes") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        init_print({ TestMesh::cube_20x20x20, TestMesh::cube_20x20x20 }, print, model, DynamicPrintConfig::full_print_config());
+        print.process();
+        const Vec2d corner = unscaled(print.objects().front()->instances().front().shift) + Vec2d(10., 10.);
+        WHEN("the wipe tower is placed apart from the cubes") {
+            BoundingBoxf bbox;
+            for (const PrintObject *object : print.objects())
+                bbox.merge(unscaled(object->instances().front().shift));
+            const FakeWipeTower wipe_tower = square_wipe_tower(bbox.max + Vec2d(50., 50.), 10.);
+            THEN("no conflict is found") {
+                REQUIRE(! ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), &wipe_tower).has_value());
+            }
+        }
+        WHEN("the wipe tower overlaps a corner of a cube") {
+            const FakeWipeTower wipe_tower = square_wipe_tower(corner, 10.);
+            ConflictResultOpt result = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), &wipe_tower);
+            THEN("the wipe tower conflicts with the cube at the first layer") {
+                REQUIRE(result.has_value());
+                REQUIRE(result->_objName1 == "WipeTower");
+                REQUIRE(result->_obj2 == print.objects().front());
+                REQUIRE(result->_height < 0.1f);
+            }
+        }
+    }
+}
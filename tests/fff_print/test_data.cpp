@@ -215,6 +215,8 @@ void init_print(std::vector<TriangleMesh> &&meshes, Slic3r::Print &print, Slic3r
 		print.auto_assign_extruders(mo);
     }
 
+	// The G-code is generated relative to the origin of the plate, which is otherwise set by the plate owning the print.
+	print.set_plate_origin(Vec3d::Zero());
 	print.apply(model, config);
     print.validate();
     print.set_status_silent();
@@ -282,7 +284,7 @@ void init_and_process_print(std::initializer_list<TriangleMesh> meshes, Slic3r::
 
 std::string gcode(Print & print)
 {
-	boost::filesystem::path temp = boost::filesystem::unique_path();
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
     print.set_status_silent();
     print.process();
     print.export_gcode(temp.string(), nullptr, nullptr);
@@ -1,14 +1,25 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <numeric>
 #include <sstream>
 
+#include <tbb/task_arena.h>
+
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillAdaptive.hpp"
+#include "libslic3r/Fill/FillCache.hpp"
+#include "libslic3r/Fill/FillGyroid.hpp"
+#include "libslic3r/Fill/FillLightning.hpp"
+#include "libslic3r/Fill/Lightning/Generator.hpp"
+#include "libslic3r/Fill/Lightning/TreeNode.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/Layer.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SVG.hpp"
+#include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/libslic3r.h"
 
 #include "test_data.hpp"
@@ -190,6 +201,239 @@ TEST_CASE("Fill: Pattern Path Length", "[Fill]") {
     }
 }
 
+TEST_CASE("Fill: Gyroid waves are shared by surfaces of the same size", "[Fill]") {
+    std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipGyroid));
+    // Compensate the gyroid correction angle, so that the surfaces are not rotated.
+    filler->angle = float(PI / 4.);
+    filler->spacing = 0.5;
+    filler->z = 1.2;
+    FillParams fill_params;
+    fill_params.density = 0.2f;
+
+    Slic3r::ExPolygon square({ Point::new_scale(0, 0), Point::new_scale(30, 0), Point::new_scale(30, 30), Point::new_scale(0, 30) });
+    Slic3r::Surface surface(stInternal, square);
+    Slic3r::Polylines paths = filler->fill_surface(&surface, fill_params);
+    REQUIRE(! paths.empty());
+
+    // Shift the square by a multiple of the gyroid period, the shifted square is filled with the cached waves.
+    coord_t distance = coord_t(scale_(filler->spacing) / (fill_params.density * FillGyroid::DensityAdjust));
+    Point   shift(3 * coord_t(2. * PI * distance), coord_t(2. * PI * distance));
+    Slic3r::Surface shifted_surface(stInternal, square);
+    shifted_surface.expolygon.translate(shift);
+    Slic3r::Polylines shifted_paths = filler->fill_surface(&shifted_surface, fill_params);
+
+    REQUIRE(shifted_paths.size() == paths.size());
+    REQUIRE(total_length(shifted_paths) == Approx(total_length(paths)));
+    REQUIRE(diff_pl(shifted_paths, offset(shifted_surface.expolygon, float(SCALED_EPSILON * 10))).empty());
+}
+
+TEST_CASE("Fill: Cached infill of the same surface", "[Fill]") {
+    FillCache &cache = FillCache::get_instance();
+    cache.clear();
+    cache.set_max_memory(16 << 20);
+
+    std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipRectilinear));
+    Slic3r::ExPolygon square({ Point::new_scale(0, 0), Point::new_scale(30, 0), Point::new_scale(30, 30), Point::new_scale(0, 30) });
+    filler->set_bounding_box(get_extents(square));
+    filler->angle = float(PI / 4.);
+    filler->spacing = 0.5;
+    filler->layer_id = 3;
+    filler->z = 1.;
+    FillParams fill_params;
+    fill_params.density = 0.2f;
+    fill_params.flow = Flow(0.5f, 0.2f, 0.4f);
+    fill_params.extrusion_role = erInternalInfill;
+    fill_params.using_internal_flow = true;
+    Slic3r::Surface surface(stInternal, square);
+
+    FillCache::Key key(ipRectilinear, *filler, fill_params, surface);
+    ExtrusionEntityCollection fills;
+    REQUIRE(! cache.get(key, fills.entities));
+    filler->fill_surface_extrusion(&surface, fill_params, fills.entities);
+    REQUIRE(! fills.entities.empty());
+    cache.put(key, fills.entities, 0);
+    REQUIRE(cache.memory() > 0);
+
+    SECTION("The same surface is cloned from the cache") {
+        ExtrusionEntityCollection cached;
+        REQUIRE(cache.get(FillCache::Key(ipRectilinear, *filler, fill_params, surface), cached.entities));
+        REQUIRE(cached.entities.size() == fills.entities.size());
+        REQUIRE(cached.as_polylines() == fills.as_polylines());
+    }
+    SECTION("A shifted surface is not cached") {
+        Slic3r::Surface shifted_surface(surface);
+        shifted_surface.expolygon.translate(Point::new_scale(1, 0));
+        ExtrusionEntityCollection cached;
+        REQUIRE(! cache.get(FillCache::Key(ipRectilinear, *filler, fill_params, shifted_surface), cached.entities));
+    }
+    SECTION("A different layer is not cached") {
+        filler->z = 1.2;
+        ExtrusionEntityCollection cached;
+        REQUIRE(! cache.get(FillCache::Key(ipRectilinear, *filler, fill_params, surface), cached.entities));
+    }
+    SECTION("Disabling the cache drops the infill") {
+        cache.set_max_memory(0);
+        REQUIRE(cache.memory() == 0);
+        ExtrusionEntityCollection cached;
+        REQUIRE(! cache.get(key, cached.entities));
+    }
+
+    cache.set_max_memory(0);
+}
+
+TEST_CASE("Fill: Adaptive cubic octree is reused if built from the same mesh", "[Fill]") {
+    indexed_triangle_set mesh = its_make_cube(20., 20., 20.);
+    its_transform(mesh, Transform3d(FillAdaptive::transform_to_octree()));
+    FillAdaptive::OctreePtr octree = FillAdaptive::build_octree(mesh, {}, 2., false);
+    REQUIRE(octree);
+
+    auto fill_length = [](FillAdaptive::Octree *octree) {
+        std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipAdaptiveCubic));
+        filler->adapt_fill_octree = octree;
+        filler->spacing = 0.5;
+        filler->z = 10.;
+        FillParams fill_params;
+        fill_params.density = 0.2f;
+        Slic3r::Surface surface(stInternal, ExPolygon({ Point::new_scale(0, 0), Point::new_scale(20, 0), Point::new_scale(20, 20), Point::new_scale(0, 20) }));
+        return total_length(filler->fill_surface(&surface, fill_params));
+    };
+    const double length = fill_length(octree.get());
+    REQUIRE(length > 0);
+
+    SECTION("The same mesh and line spacing reuse the octree") {
+        const FillAdaptive::Octree *previous = octree.get();
+        octree = FillAdaptive::build_octree(mesh, {}, 2., false, std::move(octree));
+        REQUIRE(octree.get() == previous);
+        REQUIRE(fill_length(octree.get()) == Approx(length));
+    }
+    SECTION("A denser octree is built for a smaller line spacing") {
+        octree = FillAdaptive::build_octree(mesh, {}, 1., false, std::move(octree));
+        REQUIRE(octree);
+        REQUIRE(fill_length(octree.get()) > length);
+    }
+}
+
+// Sparse infill areas of the layers the Lightning trees are grown in.
+static std::vector<Polygons> lightning_infill_areas(const PrintObject &object)
+{
+    std::vector<Polygons> infill_areas(object.layers().size());
+    for (size_t layer_id = 0; layer_id < infill_areas.size(); ++ layer_id)
+        for (const LayerRegion *layerm : object.get_layer(int(layer_id))->regions())
+            for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
+                    append(infill_areas[layer_id], to_polygons(surface.expolygon));
+    return infill_areas;
+}
+
+// Branches of the trees of a layer in the order of the trees and of their nodes.
+// The trees are compared by their branches, as Layer::convertToLines() starts the polylines at randomly chosen children.
+static Lines lightning_branches(const FillLightning::Layer &layer)
+{
+    Lines branches;
+    for (const FillLightning::NodeSPtr &root : layer.tree_roots)
+        root->visitBranches([&branches](const Point &from, const Point &to) { branches.emplace_back(from, to); });
+    return branches;
+}
+
+static std::vector<Lines> lightning_branches(const FillLightning::Generator &generator, size_t num_layers)
+{
+    std::vector<Lines> branches;
+    for (size_t layer_id = 0; layer_id < num_layers; ++ layer_id)
+        branches.emplace_back(lightning_branches(generator.getTreesForLayer(layer_id)));
+    return branches;
+}
+
+// Lightning trees grown over the whole layers one layer after another, as the generator did before growing the islands of a layer in parallel.
+static std::vector<Lines> lightning_branches_serial(const PrintObject &object, const std::vector<Polygons> &infill_areas, const std::vector<Polygons> &overhangs)
+{
+    const PrintRegionConfig &region_config   = object.shared_regions()->all_regions.front()->config();
+    const double             layer_thickness = scaled<double>(object.config().layer_height.value);
+    const coord_t supporting_radius      = coord_t(scaled<float>(region_config.sparse_infill_line_width.value)) * 100 / region_config.sparse_infill_density.value;
+    const coord_t wall_supporting_radius = coord_t(layer_thickness * std::tan(M_PI / 4));
+    const coord_t prune_length           = wall_supporting_radius;
+    const coord_t straightening_distance = wall_supporting_radius;
+
+    std::vector<FillLightning::Layer> layers(infill_areas.size());
+    const size_t   top_layer_id = infill_areas.size() - 1;
+    EdgeGrid::Grid outlines_locator(get_extents(infill_areas[top_layer_id]).inflated(SCALED_EPSILON));
+    outlines_locator.create(infill_areas[top_layer_id], FillLightning::locator_cell_size);
+    for (int layer_id = int(top_layer_id); layer_id >= 0; -- layer_id) {
+        FillLightning::Layer &layer         = layers[layer_id];
+        const Polygons       &outlines      = infill_areas[layer_id];
+        const BoundingBox     outlines_bbox = get_extents(outlines);
+        std::vector<FillLightning::NodeSPtr> to_be_reconnected_tree_roots = layer.tree_roots;
+        layer.generateNewTrees(overhangs[layer_id], outlines, outlines_bbox, outlines_locator, supporting_radius, wall_supporting_radius, []() {});
+        layer.reconnectRoots(to_be_reconnected_tree_roots, outlines, outlines_bbox, outlines_locator, supporting_radius, wall_supporting_radius);
+        if (layer_id == 0)
+            break;
+        const Polygons &below_outlines      = infill_areas[layer_id - 1];
+        BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
+        if (const BoundingBox &outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
+            below_outlines_bbox.merge(outlines_locator_bbox);
+        if (! layer.tree_roots.empty())
+            below_outlines_bbox.merge(get_extents(layer.tree_roots).inflated(SCALED_EPSILON));
+        outlines_locator.set_bbox(below_outlines_bbox);
+        outlines_locator.create(below_outlines, FillLightning::locator_cell_size);
+        for (FillLightning::NodeSPtr &tree : layer.tree_roots)
+            tree->propagateToNextLayer(layers[layer_id - 1].tree_roots, below_outlines, outlines_locator, prune_length, straightening_distance, FillLightning::locator_cell_size / 2);
+    }
+
+    std::vector<Lines> branches;
+    for (const FillLightning::Layer &layer : layers)
+        branches.emplace_back(lightning_branches(layer));
+    return branches;
+}
+
+SCENARIO("Fill: Lightning trees of the islands of a layer", "[Fill]") {
+    auto lightning_print = [](Print &print, Model &model, TriangleMesh &&mesh) {
+        Slic3r::Test::init_print({ std::move(mesh) }, print, model, {
+            { "sparse_infill_pattern", "lightning" },
+            { "sparse_infill_density", "15%" }
+        });
+        print.process();
+    };
+    GIVEN("A cube with a single infill island per layer") {
+        Print print;
+        Model model;
+        lightning_print(print, model, make_cube(20., 20., 20.));
+        const PrintObject &object = *print.objects().front();
+        THEN("the trees are the same as grown over the whole layers") {
+            const std::vector<Polygons> infill_areas = lightning_infill_areas(object);
+            FillLightning::GeneratorPtr generator    = FillLightning::build_generator(object, []() {});
+            const std::vector<Lines>    branches     = lightning_branches(*generator, infill_areas.size());
+            REQUIRE(std::any_of(branches.begin(), branches.end(), [](const Lines &layer_branches) { return ! layer_branches.empty(); }));
+            REQUIRE(branches == lightning_branches_serial(object, infill_areas, generator->Overhangs()));
+        }
+    }
+    GIVEN("Three separate cubes of different heights forming a single object, the first two of them 2mm apart") {
+        TriangleMesh mesh = make_cube(20., 20., 20.);
+        for (int i = 1; i < 3; ++ i) {
+            TriangleMesh cube = make_cube(20., 20., 20. - 2. * i);
+            cube.translate(30.f * float(i) - 8.f, 0.f, 0.f);
+            mesh.merge(cube);
+        }
+        Print print;
+        Model model;
+        lightning_print(print, model, std::move(mesh));
+        const PrintObject &object = *print.objects().front();
+        THEN("the trees do not depend on the number of threads") {
+            const std::vector<Polygons> infill_areas = lightning_infill_areas(object);
+            REQUIRE(union_ex(infill_areas[infill_areas.size() / 2]).size() == 3);
+            std::vector<Lines> branches_single_thread;
+            tbb::task_arena(1).execute([&]() { branches_single_thread = lightning_branches(*FillLightning::build_generator(object, []() {}), infill_areas.size()); });
+            std::vector<Lines> branches_many_threads;
+            tbb::task_arena(4).execute([&]() { branches_many_threads = lightning_branches(*FillLightning::build_generator(object, []() {}), infill_areas.size()); });
+            REQUIRE(branches_single_thread == branches_many_threads);
+            REQUIRE(branches_single_thread == lightning_branches(*FillLightning::build_generator(object, []() {}), infill_areas.size()));
+        }
+        THEN("the trees are the same as grown over the whole layers") {
+            const std::vector<Polygons> infill_areas = lightning_infill_areas(object);
+            FillLightning::GeneratorPtr generator    = FillLightning::build_generator(object, []() {});
+            REQUIRE(lightning_branches(*generator, infill_areas.size()) == lightning_branches_serial(object, infill_areas, generator->Overhangs()));
+        }
+    }
+}
+
 /*
 {
     my $collection = Slic3r::Polyline::Collection->new(
@@ -94,3 +94,31 @@ SCENARIO("set_speed emits values with fixed-point output.", "[GCodeWriter]") {
         }
     }
 }
+
+SCENARIO("GCodeFormatter emits axes rounded to their fixed-point precision.", "[GCodeWriter]") {
+
+    GIVEN("GCodeG1Formatter instance") {
+        WHEN("XY coordinates below one and negative values are emitted") {
+            GCodeG1Formatter w;
+            w.emit_xy(Vec2d(0.5, -0.25));
+            THEN("The zero integer part is not written") {
+                REQUIRE_THAT(w.string(), Catch::Equals("G1 X.5 Y-.25\n"));
+            }
+        }
+        WHEN("Values are rounded to the XYZF precision") {
+            GCodeG1Formatter w;
+            w.emit_xyz(Vec3d(123.45678, -10.0004, 0.0004));
+            THEN("Trailing zeros and values rounded to zero are written as integers") {
+                REQUIRE_THAT(w.string(), Catch::Equals("G1 X123.457 Y-10 Z0\n"));
+            }
+        }
+        WHEN("Extrusion is emitted") {
+            GCodeG1Formatter w;
+            w.emit_e(-0.001234);
+            w.emit_f(1800.);
+            THEN("E is written with the E precision") {
+                REQUIRE_THAT(w.string(), Catch::Equals("G1 E-.00123 F1800\n"));
+            }
+        }
+    }
+}
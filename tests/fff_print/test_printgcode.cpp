@@ -1,7 +1,9 @@
 #include <catch2/catch.hpp>
 
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/GCode.hpp"
 #include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/Layer.hpp"
 
 #include "test_data.hpp"
 
@@ -269,3 +271,91 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+SCENARIO("PrintGCode releases the layers after export", "[PrintGCode]") {
+    GIVEN("A print of two cubes") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::cube_20x20x20 }, print, model, {
+            { "layer_height",                   0.2 },
+            { "initial_layer_print_height",     0.2 }
+            });
+        const std::string reference = Slic3r::Test::gcode(print);
+        WHEN("the layers are released after export") {
+            print.set_release_layers_after_export(true);
+            const std::string released = Slic3r::Test::gcode(print);
+            THEN("the same G-code is exported") {
+                REQUIRE(released == reference);
+            }
+            THEN("no extrusions are left in the layers") {
+                for (const PrintObject *object : print.objects())
+                    for (const Layer *layer : object->layers())
+                        REQUIRE(! layer->has_extrusions());
+            }
+            THEN("the layer islands are kept") {
+                for (const PrintObject *object : print.objects())
+                    REQUIRE(! object->get_layer(0)->lslices.empty());
+            }
+            THEN("exporting again slices the objects again") {
+                print.set_release_layers_after_export(false);
+                REQUIRE(Slic3r::Test::gcode(print) == reference);
+                for (const PrintObject *object : print.objects())
+                    REQUIRE(object->get_layer(0)->has_extrusions());
+            }
+        }
+    }
+    GIVEN("A print of two objects with overhangs, which travels are lifted by the overhangs they cross") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::overhang, TestMesh::overhang }, print, model, {
+            { "layer_height",                   0.2 },
+            { "initial_layer_print_height",     0.2 },
+            { "z_hop",                          "0.4" },
+            { "z_hop_types",                    "Auto Lift" }
+            });
+        const std::string reference = Slic3r::Test::gcode(print);
+        WHEN("the layers are released after export") {
+            print.set_release_layers_after_export(true);
+            THEN("the same G-code is exported") {
+                REQUIRE(Slic3r::Test::gcode(print) == reference);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode copies the unchanged layers of the last export", "[PrintGCode]") {
+    GIVEN("A print of two cubes exported with the layer cache enabled") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::cube_20x20x20 }, print, model, {
+            { "layer_height",                   0.2 },
+            { "initial_layer_print_height",     0.2 }
+            });
+        print.set_gcode_layer_cache_size(size_t(64) << 20);
+        Slic3r::Test::gcode(print);
+        REQUIRE(print.gcode_layer_cache()->memory() > 0);
+        WHEN("a custom G-code is inserted at the upper half of the print") {
+            model.plates_custom_gcodes[model.curr_plate_index].gcodes.push_back({ 15., CustomGCode::Custom, 1, "", "M117 layer cache" });
+            print.apply(model, print.full_print_config());
+            const std::string cached = Slic3r::Test::gcode(print);
+            THEN("the layers below the custom G-code are copied") {
+                REQUIRE(print.gcode_layer_cache()->num_reused_layers() > 0);
+                REQUIRE(cached.find("M117 layer cache") != std::string::npos);
+            }
+            THEN("the G-code is the same as exported without the cache") {
+                print.set_gcode_layer_cache_size(0);
+                REQUIRE(cached == Slic3r::Test::gcode(print));
+            }
+        }
+        WHEN("the memory limit of the layer cache is lowered") {
+            const std::string reference = Slic3r::Test::gcode(print);
+            const size_t      max_memory = print.gcode_layer_cache()->memory() / 2;
+            print.set_gcode_layer_cache_size(max_memory);
+            const std::string cached = Slic3r::Test::gcode(print);
+            THEN("the cached G-code and the saved states of the generator fit the limit") {
+                REQUIRE(print.gcode_layer_cache()->memory() <= max_memory);
+                REQUIRE(cached == reference);
+            }
+        }
+    }
+}
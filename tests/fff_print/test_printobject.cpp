@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
 
@@ -87,3 +88,52 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+SCENARIO("PrintObject: slicing a mirrored volume", "[PrintObject]") {
+    // An object with L shaped layers, which are not symmetric about the YZ plane.
+    TriangleMesh mesh = make_cube(20., 5., 10.);
+    mesh.merge(make_cube(5., 20., 10.));
+    // Slices of the layers, moved to the origin.
+    auto layer_slices = [](const PrintObject &object) {
+        std::vector<ExPolygons> out;
+        for (const Layer *layer : object.layers()) {
+            ExPolygons slices = layer->lslices;
+            const BoundingBox bbox = get_extents(slices);
+            for (ExPolygon &expoly : slices)
+                expoly.translate(- bbox.min);
+            out.emplace_back(std::move(slices));
+        }
+        return out;
+    };
+    GIVEN("An object with its volume mirrored by the volume transformation") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ mesh }, print, model, DynamicPrintConfig::full_print_config());
+        model.objects.front()->volumes.front()->set_mirror(Vec3d(-1., 1., 1.));
+        print.apply(model, print.full_print_config());
+        print.process();
+        WHEN("compared with the mesh mirrored in advance") {
+            TriangleMesh mirrored = mesh;
+            mirrored.mirror_x();
+            Slic3r::Print print_mirrored;
+            Slic3r::Test::init_and_process_print({ mirrored }, print_mirrored, DynamicPrintConfig::full_print_config());
+            const std::vector<ExPolygons> slices          = layer_slices(*print.objects().front());
+            const std::vector<ExPolygons> slices_mirrored = layer_slices(*print_mirrored.objects().front());
+            THEN("the layers are the same") {
+                REQUIRE(slices.size() == slices_mirrored.size());
+                for (size_t i = 0; i < slices.size(); ++ i) {
+                    REQUIRE(slices[i].size() == slices_mirrored[i].size());
+                    REQUIRE(area(diff_ex(slices[i], slices_mirrored[i])) < scaled<double>(0.1) * scaled<double>(0.1));
+                    REQUIRE(area(diff_ex(slices_mirrored[i], slices[i])) < scaled<double>(0.1) * scaled<double>(0.1));
+                }
+            }
+            THEN("the layers differ from the layers of the original mesh") {
+                Slic3r::Print print_original;
+                Slic3r::Test::init_and_process_print({ mesh }, print_original, DynamicPrintConfig::full_print_config());
+                const std::vector<ExPolygons> slices_original = layer_slices(*print_original.objects().front());
+                REQUIRE(slices_original.size() == slices.size());
+                REQUIRE(area(diff_ex(slices_original.back(), slices.back())) > scaled<double>(1.) * scaled<double>(1.));
+            }
+        }
+    }
+}
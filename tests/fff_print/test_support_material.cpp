@@ -2,6 +2,7 @@
 
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/TriangleSelector.hpp"
 
 #include "test_data.hpp" // get access to init_print, etc
 
@@ -12,7 +13,7 @@ TEST_CASE("SupportMaterial: Three raft layers created", "[SupportMaterial]")
 {
 	Slic3r::Print print;
 	Slic3r::Test::init_and_process_print({ TestMesh::cube_20x20x20 }, print, {
-		{ "support_material", 1 },
+		{ "enable_support",   1 },
 		{ "raft_layers",      3 }
 		});
     REQUIRE(print.objects().front()->support_layers().size() == 3);
@@ -29,7 +30,7 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
 	{
         ConstSupportLayerPtrsAdaptor support_layers = print.objects().front()->support_layers();
 
-		first_support_layer_height_ok = support_layers.front()->print_z == print.config().first_layer_height.value;
+		first_support_layer_height_ok = support_layers.front()->print_z == print.config().initial_layer_print_height.value;
 
 		layer_height_minimum_ok = true;
 		layer_height_maximum_ok = true;
@@ -74,10 +75,10 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
         WHEN("First layer height = 0.4") {
 			Slic3r::Print print;
 			Slic3r::Test::init_and_process_print({ mesh }, print, {
-				{ "support_material",	1 },
+				{ "enable_support",		1 },
 				{ "layer_height",		0.2 },
-				{ "first_layer_height", 0.4 },
-                { "dont_support_bridges", false },
+				{ "initial_layer_print_height", 0.4 },
+                { "bridge_no_support", false },
 			});
 			bool a, b, c, d;
             check(print, a, b, c, d);
@@ -89,10 +90,10 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
         WHEN("Layer height = 0.2 and, first layer height = 0.3") {
 			Slic3r::Print print;
 			Slic3r::Test::init_and_process_print({ mesh }, print, {
-				{ "support_material",	1 },
+				{ "enable_support",		1 },
 				{ "layer_height",		0.2 },
-				{ "first_layer_height", 0.3 },
-                { "dont_support_bridges", false },
+				{ "initial_layer_print_height", 0.3 },
+                { "bridge_no_support", false },
             });
             bool a, b, c, d;
             check(print, a, b, c, d);
@@ -104,10 +105,10 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
         WHEN("Layer height = nozzle_diameter[0]") {
 			Slic3r::Print print;
 			Slic3r::Test::init_and_process_print({ mesh }, print, {
-				{ "support_material",	1 },
+				{ "enable_support",		1 },
 				{ "layer_height",		0.2 },
-				{ "first_layer_height", 0.3 },
-                { "dont_support_bridges", false },
+				{ "initial_layer_print_height", 0.3 },
+                { "bridge_no_support", false },
             });
             bool a, b, c, d;
             check(print, a, b, c, d);
@@ -236,3 +237,80 @@ SCENARIO("SupportMaterial: Checking bridge speed", "[SupportMaterial]")
 }
 
 #endif
+
+// Pillar with two ledges, the bottoms of which are overhangs at 8 mm and 16 mm above the bed.
+static TriangleMesh pillar_with_ledges()
+{
+    TriangleMesh mesh = make_cube(10., 10., 20.);
+    TriangleMesh ledge = make_cube(15., 10., 2.);
+    ledge.translate(5.f, 0.f, 8.f);
+    mesh.merge(ledge);
+    ledge.translate(-15.f, 0.f, 8.f);
+    mesh.merge(ledge);
+    return mesh;
+}
+
+// Paint the downward facing facets of the ledges at the given heights above the bottom of the volume as support enforcers.
+static void paint_support_enforcers(ModelVolume &volume, std::initializer_list<float> heights)
+{
+    const TriangleMesh &mesh = volume.mesh();
+    const float         min_z = mesh.bounding_box().min.z();
+    TriangleSelector    selector(mesh);
+    for (int facet_idx = 0; facet_idx < int(mesh.its.indices.size()); ++ facet_idx) {
+        const stl_triangle_vertex_indices &facet = mesh.its.indices[facet_idx];
+        const Vec3f a = mesh.its.vertices[facet(0)], b = mesh.its.vertices[facet(1)], c = mesh.its.vertices[facet(2)];
+        if ((b - a).cross(c - a).normalized().z() > -0.9f)
+            continue;
+        for (float height : heights)
+            if (std::abs(a.z() - min_z - height) < EPSILON)
+                selector.set_facet(facet_idx, EnforcerBlockerType::ENFORCER);
+    }
+    volume.supported_facets.set(selector);
+}
+
+// Print z and the length of the support extrusions of each support layer.
+static std::vector<std::pair<coordf_t, double>> support_extrusions(const PrintObject &object)
+{
+    std::vector<std::pair<coordf_t, double>> out;
+    for (const SupportLayer *layer : object.support_layers()) {
+        double length = 0.;
+        for (const ExtrusionEntity *entity : layer->support_fills.flatten().entities)
+            length += entity->length();
+        out.emplace_back(layer->print_z, length);
+    }
+    return out;
+}
+
+SCENARIO("SupportMaterial: tree supports regenerated after a change of the support painting", "[SupportMaterial]")
+{
+    GIVEN("A pillar with two ledges, the lower of which is painted with support enforcers") {
+        std::initializer_list<ConfigBase::SetDeserializeItem> config_items {
+            { "enable_support",  1 },
+            { "support_type",    "tree(manual)" },
+            { "support_style",   "tree_hybrid" },
+            { "layer_height",    0.2 },
+            { "initial_layer_print_height", 0.2 }
+        };
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ pillar_with_ledges() }, print, model, config_items);
+        ModelVolume &volume = *model.objects.front()->volumes.front();
+        paint_support_enforcers(volume, { 8.f });
+        print.apply(model, print.full_print_config());
+        print.process();
+        const auto lower_only = support_extrusions(*print.objects().front());
+        WHEN("the upper ledge is painted as well and the supports are generated again") {
+            paint_support_enforcers(volume, { 8.f, 16.f });
+            print.apply(model, print.full_print_config());
+            print.process();
+            const auto regenerated = support_extrusions(*print.objects().front());
+            THEN("the supports are the same as generated from scratch") {
+                Slic3r::Print print_from_scratch;
+                print_from_scratch.apply(model, print.full_print_config());
+                print_from_scratch.process();
+                REQUIRE(regenerated != lower_only);
+                REQUIRE(regenerated == support_extrusions(*print_from_scratch.objects().front()));
+            }
+        }
+    }
+}
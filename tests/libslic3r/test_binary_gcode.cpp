@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/Exception.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
+
+#include <sstream>
+
+using namespace Slic3r;
+
+namespace {
+
+std::string temp_path(const char *pattern)
+{
+    return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(pattern)).string();
+}
+
+// G-code shaped like the output of GCode::do_export(), long enough to be split into several G-code blocks.
+std::string write_test_gcode()
+{
+    std::string path = temp_path("binarygcode-%%%%-%%%%.gcode");
+    boost::nowide::ofstream out(path, std::ios::binary);
+    out << "; HEADER_BLOCK_START\n; " << header_slic3r_generated() << "\n; total layer number: 100\n; HEADER_BLOCK_END\n\n";
+    out << "; CONFIG_BLOCK_START\n; layer_height = 0.2\n; nozzle_diameter = 0.4,0.4\n; wall_loops = 2\n; CONFIG_BLOCK_END\n\n";
+    out << "; THUMBNAIL_BLOCK_START\n; thumbnail begin 2x2 12\n; iVBORw0KGgoA\n; thumbnail end\n; THUMBNAIL_BLOCK_END\n\n";
+    out << "; EXECUTABLE_BLOCK_START\n";
+    for (int i = 0; i < 200000; ++ i)
+        out << "G1 X" << (i % 200) << ".125 Y" << (i % 170) << ".5 E.03125" << (i % 7 == 0 ? "\r\n" : "\n");
+    // Last line without a new line.
+    out << "; EXECUTABLE_BLOCK_END";
+    return path;
+}
+
+std::string read_file(const std::string &path)
+{
+    boost::nowide::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+} // namespace
+
+SCENARIO("Binary G-code round trip", "[BinaryGCode]") {
+    GIVEN("A text G-code") {
+        const std::string src = write_test_gcode();
+        for (BinaryGCode::ECompressionType compression : { BinaryGCode::ECompressionType::None, BinaryGCode::ECompressionType::Deflate }) {
+            WHEN("converted to binary and back, compression " + std::to_string(int(compression))) {
+                const std::string bin = temp_path("binarygcode-%%%%-%%%%.bgcode");
+                const std::string dst = temp_path("binarygcode-%%%%-%%%%.gcode");
+                BinaryGCode::convert_ascii_to_binary(src, bin, compression);
+                BinaryGCode::convert_binary_to_ascii(bin, dst);
+                THEN("the binary file is recognized") {
+                    REQUIRE(BinaryGCode::is_binary_gcode_file(bin));
+                    REQUIRE(! BinaryGCode::is_binary_gcode_file(src));
+                }
+                THEN("the text G-code is restored byte for byte") {
+                    REQUIRE(read_file(dst) == read_file(src));
+                }
+                if (compression == BinaryGCode::ECompressionType::None) {
+                    THEN("the metadata and the thumbnail are stored in their blocks in the order of the specification") {
+                        const std::string data = read_file(bin);
+                        const size_t file_metadata    = data.find("Producer=" + header_slic3r_generated());
+                        const size_t printer_metadata = data.find("nozzle_diameter=0.4,0.4");
+                        const size_t thumbnail        = data.find("\x89PNG");
+                        const size_t print_metadata   = data.find("total layer number=100");
+                        const size_t slicer_metadata  = data.find("wall_loops=2");
+                        const size_t gcode            = data.find("; EXECUTABLE_BLOCK_START");
+                        REQUIRE(file_metadata < printer_metadata);
+                        REQUIRE(printer_metadata < thumbnail);
+                        REQUIRE(thumbnail < print_metadata);
+                        REQUIRE(print_metadata < slicer_metadata);
+                        REQUIRE(slicer_metadata < gcode);
+                        REQUIRE(gcode != std::string::npos);
+                    }
+                    THEN("the G-code blocks do not repeat the header, the configuration and the thumbnail") {
+                        const std::string data = read_file(bin);
+                        REQUIRE(data.find("HEADER_BLOCK_START") == std::string::npos);
+                        REQUIRE(data.find("CONFIG_BLOCK_START") == std::string::npos);
+                        REQUIRE(data.find("thumbnail begin") == std::string::npos);
+                        REQUIRE(data.find("iVBORw0KGgoA") == std::string::npos);
+                    }
+                }
+                if (compression == BinaryGCode::ECompressionType::Deflate) {
+                    THEN("the binary file is smaller") {
+                        REQUIRE(boost::filesystem::file_size(bin) < boost::filesystem::file_size(src) / 2);
+                    }
+                }
+                boost::filesystem::remove(bin);
+                boost::filesystem::remove(dst);
+            }
+        }
+        boost::filesystem::remove(src);
+    }
+    GIVEN("A corrupted binary G-code") {
+        const std::string src = write_test_gcode();
+        const std::string bin = temp_path("binarygcode-%%%%-%%%%.bgcode");
+        const std::string dst = temp_path("binarygcode-%%%%-%%%%.gcode");
+        BinaryGCode::convert_ascii_to_binary(src, bin);
+        std::string data = read_file(bin);
+        data[data.size() / 2] ^= 0x55;
+        {
+            boost::nowide::ofstream out(bin, std::ios::binary);
+            out << data;
+        }
+        THEN("the conversion to text fails") {
+            REQUIRE_THROWS_AS(BinaryGCode::convert_binary_to_ascii(bin, dst), Slic3r::RuntimeError);
+            REQUIRE(! boost::filesystem::exists(dst));
+        }
+        boost::filesystem::remove(src);
+        boost::filesystem::remove(bin);
+    }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+using namespace Slic3r;
+
+using ArcInterpolationPoints = GCodeProcessorResult::ArcInterpolationPoints;
+
+TEST_CASE("Arc interpolation points of a move", "[GCodeProcessor]") {
+    const std::vector<Vec3f> points { Vec3f(1.f, 2.f, 3.f), Vec3f(4.f, 5.f, 6.f), Vec3f(7.f, 8.f, 9.f) };
+    auto same_points = [&points](const ArcInterpolationPoints &arc) {
+        return arc.size() == points.size() && std::equal(arc.begin(), arc.end(), points.begin());
+    };
+
+    SECTION("Empty") {
+        ArcInterpolationPoints arc;
+        REQUIRE(arc.empty());
+        REQUIRE(arc.size() == 0);
+        REQUIRE(arc.begin() == arc.end());
+        REQUIRE(ArcInterpolationPoints(std::vector<Vec3f>()).empty());
+    }
+    SECTION("Copy") {
+        ArcInterpolationPoints arc(points);
+        REQUIRE(same_points(arc));
+        ArcInterpolationPoints copy(arc);
+        REQUIRE(same_points(copy));
+        REQUIRE(copy.begin() != arc.begin());
+        ArcInterpolationPoints assigned;
+        assigned = arc;
+        REQUIRE(same_points(assigned));
+        assigned = ArcInterpolationPoints();
+        REQUIRE(assigned.empty());
+        REQUIRE(same_points(arc));
+    }
+    SECTION("Move") {
+        ArcInterpolationPoints arc(points);
+        const Vec3f *data = arc.begin();
+        ArcInterpolationPoints moved(std::move(arc));
+        REQUIRE(moved.begin() == data);
+        REQUIRE(same_points(moved));
+        ArcInterpolationPoints assigned;
+        assigned = std::move(moved);
+        REQUIRE(assigned.begin() == data);
+        REQUIRE(same_points(assigned));
+    }
+}
+
+TEST_CASE("Arc interpolation points are stored with arc moves only", "[GCodeProcessor]") {
+    const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gcodeprocessor-%%%%-%%%%.gcode")).string();
+    {
+        boost::nowide::ofstream out(path, std::ios::binary);
+        out << "G90\nM83\nG1 Z0.2 F600\nG1 X10 Y10 F3000\n"
+               "G2 X30 Y10 I10 J0 E1\n"
+               "G1 X40 Y10 E0.5\n"
+               "G1 X40 Y20\n";
+    }
+    GCodeProcessor processor;
+    processor.apply_config(PrintConfig::defaults());
+    processor.process_file(path);
+    boost::filesystem::remove(path);
+
+    const std::vector<GCodeProcessorResult::MoveVertex> &moves = processor.get_result().moves;
+    auto arc = std::find_if(moves.begin(), moves.end(), [](const GCodeProcessorResult::MoveVertex &move) { return move.is_arc_move(); });
+    REQUIRE(arc != moves.end());
+    REQUIRE(arc->is_arc_move_with_interpolation_points());
+    // The points of the half circle lie on the circle around (20, 10).
+    for (const Vec3f &pt : arc->interpolation_points)
+        REQUIRE((pt.head<2>() - Vec2f(20.f, 10.f)).norm() == Approx(10.f).epsilon(0.001));
+    REQUIRE(arc + 1 != moves.end());
+    for (auto it = arc + 1; it != moves.end(); ++ it) {
+        REQUIRE(! it->is_arc_move());
+        REQUIRE(it->interpolation_points.empty());
+    }
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <type_traits>
+
+#include "libslic3r/GCodeReader.hpp"
+
+using namespace Slic3r;
+
+namespace {
+
+struct ParsedGCode
+{
+    std::vector<std::string> lines;
+    std::vector<Vec3f>       positions;
+    std::vector<size_t>      lines_ends;
+};
+
+// Write a G-code long enough to be split into many chunks, mixing line terminators, line numbers and comments.
+std::string write_test_gcode()
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gcodereader-%%%%-%%%%.gcode");
+    boost::nowide::ofstream out(path.string(), std::ios::binary);
+    for (int i = 0; i < 200000; ++ i) {
+        switch (i % 6) {
+        case 0:  out << "G1 X" << (i % 200) << ".125 Y" << (i % 170) << ".5 E0.03125"; break;
+        case 1:  out << "; comment " << i; break;
+        case 2:  break;
+        case 3:  out << "N" << i << " G0 Z" << (i % 10) << ".2 F3000"; break;
+        case 4:  out << "G92 E0"; break;
+        default: out << "  M106 S255 ;fan"; break;
+        }
+        out << (i % 7 == 0 ? "\r\n" : i % 13 == 0 ? "\r" : "\n");
+    }
+    // Last line without a new line.
+    out << "G1 X1 Y2";
+    return path.string();
+}
+
+ParsedGCode parse(const std::string &path, bool parallel)
+{
+    ParsedGCode out;
+    GCodeReader reader;
+    auto callback = [&out](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+        out.lines.emplace_back(line.raw());
+        out.positions.emplace_back(reader.x(), reader.y(), reader.z());
+    };
+    if (parallel)
+        reader.parse_file_parallel(path, callback, out.lines_ends);
+    else
+        reader.parse_file(path, callback, out.lines_ends);
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("Parallel G-code parsing matches the serial parser", "[GCodeReader]") {
+    std::string path = write_test_gcode();
+    ParsedGCode serial   = parse(path, false);
+    ParsedGCode parallel = parse(path, true);
+    boost::filesystem::remove(path);
+
+    REQUIRE(! serial.lines.empty());
+    REQUIRE(serial.lines == parallel.lines);
+    REQUIRE(serial.positions == parallel.positions);
+    REQUIRE(serial.lines_ends == parallel.lines_ends);
+}
+
+// std::vector<GCodeLine> moves the lines when growing only if moving them does not throw.
+static_assert(std::is_nothrow_move_constructible<GCodeReader::GCodeLine>::value, "GCodeLine move constructor has to be noexcept");
+static_assert(std::is_nothrow_move_assignable<GCodeReader::GCodeLine>::value, "GCodeLine move assignment has to be noexcept");
+
+TEST_CASE("Modified G-code line keeps its own copy of the text", "[GCodeReader]") {
+    GCodeReader reader;
+    std::vector<GCodeReader::GCodeLine> lines;
+    {
+        std::string buffer = "G1 X10 Y20 E0.5\nG1 Z0.4\n";
+        reader.parse_buffer(buffer, [&lines](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+            GCodeReader::GCodeLine modified(line);
+            modified.set(reader, Z, 1.f);
+            lines.emplace_back(std::move(modified));
+        });
+    }
+    REQUIRE(lines.size() == 2);
+    // The buffer has been released, the lines reference their own storage.
+    REQUIRE(lines.front().raw() == "G1 Z1.000 X10 Y20 E0.5");
+    REQUIRE(lines.back().raw() == "G1 Z1.000");
+    REQUIRE(lines.back().cmd() == "G1");
+    REQUIRE(lines.back().has_z());
+}
@@ -322,15 +322,23 @@ SCENARIO("Path chaining", "[Geometry]") {
 			{ {8266122, 14250611}, {6244813, 17751595} },
 			{ {12177955, 9886741}, {10703348, 11491900} } 
 		};
-		Polylines chained = chain_polylines(polylines);
-		THEN("Chained taking the shortest path") {
-			double connection_length = 0.;
+		auto connection_length = [](const Polylines &chained) {
+			double length = 0.;
 			for (size_t i = 1; i < chained.size(); ++i) {
 				const Polyline &pl1 = chained[i - 1];
 				const Polyline &pl2 = chained[i];
-				connection_length += (pl2.first_point() - pl1.last_point()).cast<double>().norm();
+				length += (pl2.first_point() - pl1.last_point()).cast<double>().norm();
 			}
-			REQUIRE(connection_length < 85206000.);
+			return length;
+		};
+		Polylines chained = chain_polylines(polylines);
+		THEN("Chained taking the shortest path") {
+			REQUIRE(connection_length(chained) < 85206000.);
+		}
+		THEN("Improved by two exchanges on request only") {
+			Polylines improved = chain_polylines(polylines, nullptr, true);
+			REQUIRE(improved.size() == polylines.size());
+			REQUIRE(connection_length(improved) < connection_length(chained));
 		}
 	}
 	GIVEN("Loop pieces") {
@@ -355,6 +363,79 @@ SCENARIO("Path chaining", "[Geometry]") {
 			}
 		}
 	}
+	GIVEN("Many short segments in a random order") {
+		// Enough segments to be chained by tiles.
+		Polylines polylines;
+		std::vector<size_t> order(101 * 101);
+		for (size_t i = 0; i < order.size(); ++ i)
+			order[i] = (i * 7919) % order.size();
+		for (size_t i : order) {
+			Point p(coord_t(i % 101) * scale_(1.), coord_t(i / 101) * scale_(1.));
+			polylines.emplace_back(p, p + Point(scale_(0.5), (i & 1) ? scale_(0.5) : 0));
+		}
+		auto connection_length = [](const Polylines &polylines) {
+			double length = 0.;
+			for (size_t i = 1; i < polylines.size(); ++ i)
+				length += (polylines[i].first_point() - polylines[i - 1].last_point()).cast<double>().norm();
+			return length;
+		};
+		auto same_segments = [](Polylines a, Polylines b) {
+			auto normalize = [](Polylines &polylines) {
+				for (Polyline &pl : polylines)
+					if (pl.last_point() < pl.first_point())
+						pl.reverse();
+				std::sort(polylines.begin(), polylines.end(), [](const Polyline &l, const Polyline &r) { return l.first_point() < r.first_point(); });
+			};
+			normalize(a);
+			normalize(b);
+			return a == b;
+		};
+		WHEN("Chained as polylines") {
+			Point start(0, 0);
+			Polylines chained = chain_polylines(polylines, &start);
+			THEN("All the segments are chained") {
+				REQUIRE(same_segments(chained, polylines));
+			}
+			THEN("Chained starting near the start point") {
+				REQUIRE((chained.front().first_point() - start).cast<double>().norm() < scale_(2.));
+			}
+			THEN("The connections are short") {
+				// The segments are 0.5mm long on a 1mm grid, a random order would connect them by tens of millimeters.
+				REQUIRE(connection_length(chained) < scale_(1.) * double(polylines.size()));
+			}
+		}
+		WHEN("Chained as extrusion entities") {
+			ExtrusionEntitiesPtr entities;
+			for (size_t i = 0; i < polylines.size(); ++ i) {
+				entities.emplace_back(new ExtrusionPath(erGapFill, 0.1, 0.4f, 0.2f));
+				static_cast<ExtrusionPath*>(entities.back())->polyline = polylines[i];
+				if ((i % 3) == 0)
+					// Keep the direction of some of the segments.
+					entities.back()->set_reverse();
+			}
+			chain_and_reorder_extrusion_entities(entities);
+			Polylines chained;
+			for (ExtrusionEntity *ee : entities)
+				chained.emplace_back(static_cast<ExtrusionPath*>(ee)->polyline);
+			THEN("All the segments are chained") {
+				REQUIRE(same_segments(chained, polylines));
+			}
+			THEN("Segments, which could not be reversed, are not reversed") {
+				size_t num_reversed = 0;
+				for (const ExtrusionEntity *ee : entities)
+					if (! ee->can_reverse()) {
+						const Polyline &pl = static_cast<const ExtrusionPath*>(ee)->polyline;
+						num_reversed += std::find(polylines.begin(), polylines.end(), pl) == polylines.end();
+					}
+				REQUIRE(num_reversed == 0);
+			}
+			THEN("The connections are short") {
+				REQUIRE(connection_length(chained) < scale_(1.) * double(polylines.size()));
+			}
+			for (ExtrusionEntity *ee : entities)
+				delete ee;
+		}
+	}
 }
 
 SCENARIO("Line distances", "[Geometry]"){
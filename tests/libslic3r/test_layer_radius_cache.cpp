@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+
+#include <tbb/parallel_for.h>
+
+#include "libslic3r/Polygon.hpp"
+#include "libslic3r/Support/LayerRadiusCache.hpp"
+
+using namespace Slic3r;
+
+static Polygons square(coord_t size)
+{
+    return { Polygon({ { 0, 0 }, { size, 0 }, { size, size }, { 0, size } }) };
+}
+
+TEST_CASE("Layer radius cache", "[LayerRadiusCache]") {
+    LayerRadiusCache<coord_t, Polygons> cache;
+    REQUIRE(cache.find(3, 10) == nullptr);
+    REQUIRE(cache.num_layers() == 0);
+
+    // More radii than fit into a single block of buckets, inserted out of order.
+    for (coord_t radius : { 50, 10, 30, 20, 90, 70, 60, 40, 80, 100 })
+        cache.insert(3, radius, square(radius));
+    REQUIRE(cache.num_layers() == 4);
+    REQUIRE(cache.size() == 10);
+
+    SECTION("Areas are found by layer and radius") {
+        const Polygons *area = cache.find(3, 90);
+        REQUIRE(area != nullptr);
+        REQUIRE(*area == square(90));
+        REQUIRE(cache.find(3, 15) == nullptr);
+        REQUIRE(cache.find(2, 90) == nullptr);
+        REQUIRE(cache.find(1000, 90) == nullptr);
+    }
+    SECTION("Inserting an area for a cached radius keeps the cached area") {
+        const Polygons *area = cache.find(3, 20);
+        REQUIRE(&cache.insert(3, 20, square(1)) == area);
+        REQUIRE(*cache.find(3, 20) == square(20));
+        REQUIRE(cache.size() == 10);
+    }
+    SECTION("Lower bound is the highest cached radius not exceeding the radius") {
+        auto lower = cache.find_lower_bound(3, 75);
+        REQUIRE(lower);
+        REQUIRE(lower->first == 70);
+        REQUIRE(*lower->second == square(70));
+        REQUIRE(cache.find_lower_bound(3, 80)->first == 80);
+        REQUIRE(! cache.find_lower_bound(3, 5));
+    }
+    SECTION("Only the smallest radius is retained") {
+        cache.retain_smallest_radius();
+        REQUIRE(cache.size() == 1);
+        REQUIRE(*cache.find(3, 10) == square(10));
+        REQUIRE(cache.find(3, 20) == nullptr);
+    }
+    SECTION("Clearing drops all layers") {
+        cache.clear();
+        REQUIRE(cache.num_layers() == 0);
+        REQUIRE(cache.find(3, 10) == nullptr);
+    }
+}
+
+TEST_CASE("Layer radius cache filled in parallel", "[LayerRadiusCache]") {
+    LayerRadiusCache<coord_t, Polygons> cache;
+    constexpr size_t num_layers = 1000;
+    constexpr coord_t num_radii = 20;
+    // Each area is inserted by several threads, while the other threads look up the areas of the same layers.
+    // Catch assertions are not thread safe.
+    std::atomic<bool> valid { true };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers * num_radii * 4), [&cache, &valid](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            const size_t  layer_idx = (i / 4) % num_layers;
+            const coord_t radius    = coord_t(i / 4 / num_layers + 1);
+            if (const Polygons *area = cache.find(layer_idx, radius); area && *area != square(radius))
+                valid = false;
+            if (cache.insert(layer_idx, radius, square(radius)) != square(radius))
+                valid = false;
+        }
+    });
+    REQUIRE(valid);
+    REQUIRE(cache.num_layers() == num_layers);
+    REQUIRE(cache.size() == num_layers * num_radii);
+    for (size_t layer_idx = 0; layer_idx < num_layers; ++ layer_idx)
+        for (coord_t radius = 1; radius <= num_radii; ++ radius)
+            REQUIRE(*cache.find(layer_idx, radius) == square(radius));
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/RayPacketBVH.hpp>
+
+using namespace Slic3r;
+
+static std::vector<Vec3f> random_directions(size_t count)
+{
+    std::mt19937                          rng(0);
+    std::normal_distribution<float>       normal;
+    std::vector<Vec3f>                    out;
+    for (size_t i = 0; i < count; ++ i)
+        out.emplace_back(Vec3f(normal(rng), normal(rng), normal(rng)).normalized());
+    return out;
+}
+
+TEST_CASE("Ray packets hit the same triangles as single rays", "[RayPacketBVH]") {
+    indexed_triangle_set its = its_make_sphere(10., PI / 45.);
+    its_merge(its, its_make_cube(4., 4., 30.));
+    const RayPacketBVH bvh(its);
+    REQUIRE(! bvh.empty());
+    const auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+
+    // Rays from a point inside of the sphere next to the cube, a point inside of the cube and a point outside of both.
+    const std::vector<Vec3f> directions = random_directions(400);
+    for (const Vec3f &origin : { Vec3f(-5.f, 1.f, 2.f), Vec3f(2.f, 2.f, 15.f), Vec3f(30.f, 0.5f, 0.5f) }) {
+        size_t num_hits = 0;
+        for (size_t begin = 0; begin < directions.size(); begin += RayPacketBVH::PacketSize) {
+            RayPacketBVH::Packet packet;
+            for (size_t i = begin; i < std::min(directions.size(), begin + RayPacketBVH::PacketSize); ++ i)
+                packet.push_back(origin, directions[i]);
+            int   ids[RayPacketBVH::PacketSize];
+            float ts[RayPacketBVH::PacketSize];
+            bvh.first_hits(packet, ids, ts);
+            for (size_t i = 0; i < packet.size; ++ i) {
+                igl::Hit hit;
+                if (AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, Vec3d(origin.cast<double>()),
+                        Vec3d(directions[begin + i].cast<double>()), hit)) {
+                    REQUIRE(ids[i] != -1);
+                    REQUIRE(ts[i] == Approx(hit.t).epsilon(1e-4));
+                    ++ num_hits;
+                } else
+                    REQUIRE(ids[i] == -1);
+            }
+        }
+        // All the rays from inside hit, some of the rays from outside.
+        REQUIRE(num_hits > 0);
+    }
+
+    SECTION("All hits") {
+        // Through the sphere and along the cube.
+        RayPacketBVH::Packet packet;
+        packet.push_back(Vec3f(0.f, 0.f, -30.f), Vec3f(0.01f, 0.02f, 1.f));
+        packet.push_back(Vec3f(-30.f, 1.f, 0.5f), Vec3f(1.f, 0.f, 0.f));
+        packet.push_back(Vec3f(-30.f, 1.f, 40.f), Vec3f(1.f, 0.f, 0.f));
+        std::vector<RayPacketBVH::Hit> hits;
+        bvh.all_hits(packet, hits);
+        for (int ray = 0; ray < int(packet.size); ++ ray) {
+            std::vector<igl::Hit> reference;
+            AABBTreeIndirect::intersect_ray_all_hits(its.vertices, its.indices, tree, Vec3d(packet.ray_origin(ray).cast<double>()),
+                Vec3d(packet.ray_dir(ray).cast<double>()), reference);
+            std::vector<float> ts;
+            for (const RayPacketBVH::Hit &hit : hits)
+                if (hit.ray == ray)
+                    ts.emplace_back(hit.t);
+            std::sort(ts.begin(), ts.end());
+            REQUIRE(ts.size() == reference.size());
+            for (size_t i = 0; i < ts.size(); ++ i)
+                REQUIRE(ts[i] == Approx(reference[i].t).epsilon(1e-4));
+        }
+        REQUIRE(std::count_if(hits.begin(), hits.end(), [](const auto &hit) { return hit.ray == 0; }) == 4);
+        REQUIRE(std::count_if(hits.begin(), hits.end(), [](const auto &hit) { return hit.ray == 2; }) == 0);
+    }
+}
+
+TEST_CASE("Ray packet kernels return the same hits", "[RayPacketBVH]") {
+    const indexed_triangle_set its = its_make_sphere(10., PI / 90.);
+    const RayPacketBVH         bvh(its);
+    const RayPacketKernel      active = ray_packet_kernel();
+    const std::vector<Vec3f>   directions = random_directions(1000);
+
+    auto trace = [&bvh, &directions]() {
+        std::vector<int>   ids(directions.size());
+        std::vector<float> ts(directions.size());
+        for (size_t begin = 0; begin < directions.size(); begin += RayPacketBVH::PacketSize) {
+            RayPacketBVH::Packet packet;
+            // Rays from the surface of the sphere, some of them leave the sphere without any hit.
+            for (size_t i = begin; i < std::min(directions.size(), begin + RayPacketBVH::PacketSize); ++ i)
+                packet.push_back(9.9f * directions[begin], directions[i]);
+            bvh.first_hits(packet, ids.data() + begin, ts.data() + begin);
+        }
+        return std::make_pair(ids, ts);
+    };
+
+    REQUIRE(set_ray_packet_kernel(RayPacketKernel::Scalar));
+    const auto scalar = trace();
+    for (RayPacketKernel kernel : { RayPacketKernel::SSE, RayPacketKernel::AVX2, RayPacketKernel::NEON })
+        if (set_ray_packet_kernel(kernel)) {
+            const auto hits = trace();
+            REQUIRE(hits.first == scalar.first);
+            for (size_t i = 0; i < directions.size(); ++ i)
+                REQUIRE(hits.second[i] == Approx(scalar.second[i]));
+        }
+    set_ray_packet_kernel(active);
+}
@@ -0,0 +1,130 @@
+#include <catch2/catch.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include "libslic3r/Model.hpp"
+#include "libslic3r/SliceCache.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+using namespace Slic3r;
+
+static std::vector<float> layer_zs(float layer_height)
+{
+    std::vector<float> zs;
+    for (float z = 0.5f * layer_height; z < 20.f; z += layer_height)
+        zs.emplace_back(z);
+    return zs;
+}
+
+static bool same_slices(const std::vector<ExPolygons> &a, const std::vector<ExPolygons> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++ i)
+        if (a[i] != b[i])
+            return false;
+    return true;
+}
+
+TEST_CASE("Mesh hash", "[SliceCache]") {
+    indexed_triangle_set cube = its_make_cube(20., 20., 20.);
+    indexed_triangle_set moved = cube;
+    for (stl_vertex &v : moved.vertices)
+        v.z() += 1.f;
+    REQUIRE(its_hash(cube) == its_hash(its_make_cube(20., 20., 20.)));
+    REQUIRE(its_hash(cube) != its_hash(moved));
+}
+
+TEST_CASE("Mesh hash of a volume modified in place", "[SliceCache]") {
+    Model        model;
+    ModelObject *object = model.add_object();
+    // Keep the cube off center, so that centering modifies the mesh.
+    ModelVolume *volume = object->add_volume(TriangleMesh(its_make_cube(20., 20., 20.)), ModelVolumeType::MODEL_PART, false);
+    const uint64_t hash = volume->mesh_hash();
+    REQUIRE(hash == its_hash(volume->mesh().its));
+
+    volume->center_geometry_after_creation();
+    REQUIRE(volume->mesh_hash() != hash);
+    REQUIRE(volume->mesh_hash() == its_hash(volume->mesh().its));
+
+    const uint64_t centered_hash = volume->mesh_hash();
+    volume->scale_geometry_after_creation(Vec3f(2.f, 1.f, 1.f));
+    REQUIRE(volume->mesh_hash() != centered_hash);
+    REQUIRE(volume->mesh_hash() == its_hash(volume->mesh().its));
+}
+
+TEST_CASE("Slice cache", "[SliceCache]") {
+    const indexed_triangle_set its    = its_make_sphere(10., PI / 36.);
+    const uint64_t             hash   = its_hash(its);
+    MeshSlicingParamsEx        params;
+    params.trafo = Transform3d(Eigen::Translation3d(10., 10., 10.));
+    const std::vector<float>   zs     = layer_zs(0.2f);
+    const std::vector<ExPolygons> slices = slice_mesh_ex(its, zs, params);
+    const SliceCache::Key      key(hash, zs, params);
+
+    SliceCache &cache = SliceCache::get_instance();
+    cache.clear();
+    std::vector<ExPolygons> cached;
+
+    SECTION("Disabled cache keeps nothing") {
+        cache.put(key, slices);
+        REQUIRE(! cache.get(key, cached));
+    }
+
+    SECTION("In-memory cache") {
+        cache.set_max_memory(size_t(64) << 20);
+        REQUIRE(! cache.get(key, cached));
+        cache.put(key, slices);
+        REQUIRE(cache.get(key, cached));
+        REQUIRE(same_slices(cached, slices));
+
+        // Any change of the Zs or of the slicing parameters is a miss.
+        REQUIRE(! cache.get(SliceCache::Key(hash, layer_zs(0.1f), params), cached));
+        MeshSlicingParamsEx params2 { params };
+        params2.closing_radius = 0.1f;
+        REQUIRE(! cache.get(SliceCache::Key(hash, zs, params2), cached));
+        params2 = params;
+        params2.trafo = Transform3d(Eigen::Translation3d(10., 10., 11.));
+        REQUIRE(! cache.get(SliceCache::Key(hash, zs, params2), cached));
+
+        // Shrinking the cache below the size of the slices evicts them.
+        cache.set_max_memory(cache.memory() - 1);
+        REQUIRE(! cache.get(key, cached));
+        REQUIRE(cache.memory() == 0);
+    }
+
+    SECTION("Least recently used slices are evicted first") {
+        cache.set_max_memory(size_t(64) << 20);
+        const SliceCache::Key key2(hash + 1, zs, params);
+        const SliceCache::Key key3(hash + 2, zs, params);
+        cache.put(key, slices);
+        cache.put(key2, slices);
+        const size_t entry_memory = cache.memory() / 2;
+        // Make space for two entries only, then touch the first one.
+        cache.set_max_memory(2 * entry_memory);
+        REQUIRE(cache.get(key, cached));
+        cache.put(key3, slices);
+        REQUIRE(cache.get(key, cached));
+        REQUIRE(! cache.get(key2, cached));
+        REQUIRE(cache.get(key3, cached));
+    }
+
+    SECTION("Disk cache") {
+        const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slice_cache_%%%%-%%%%");
+        cache.set_dir(dir.string());
+        REQUIRE(! cache.get(key, cached));
+        cache.put(key, slices);
+        REQUIRE(cache.get(key, cached));
+        REQUIRE(same_slices(cached, slices));
+        REQUIRE(! cache.get(SliceCache::Key(hash, layer_zs(0.1f), params), cached));
+        // The temporary file was renamed to the cache file.
+        for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(dir))
+            REQUIRE(entry.path().extension() == ".slices");
+        cache.set_dir(std::string());
+        REQUIRE(! cache.get(key, cached));
+        boost::filesystem::remove_all(dir);
+    }
+
+    cache.set_max_memory(0);
+    cache.set_dir(std::string());
+}
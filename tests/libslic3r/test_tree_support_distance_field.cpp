@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/ExPolygon.hpp"
+#include "libslic3r/Support/TreeSupportDistanceField.hpp"
+
+using namespace Slic3r;
+
+static ExPolygon square_mm(double x0, double y0, double size)
+{
+    return ExPolygon(Polygon({ Point::new_scale(x0, y0), Point::new_scale(x0 + size, y0), Point::new_scale(x0 + size, y0 + size), Point::new_scale(x0, y0 + size) }));
+}
+
+static double area_mm2(const ExPolygons &expolys)
+{
+    double out = 0;
+    for (const ExPolygon &expoly : expolys)
+        out += expoly.area();
+    return out * SCALING_FACTOR * SCALING_FACTOR;
+}
+
+TEST_CASE("Tree support distance field", "[TreeSupportDistanceField]") {
+    // A 10mm square and a 10mm square with a 4mm square hole on the first layer, nothing above.
+    ExPolygon square = square_mm(0, 0, 10);
+    ExPolygon holed  = square_mm(30, 0, 10);
+    holed.holes.emplace_back(square_mm(33, 3, 4).contour);
+    holed.holes.back().reverse();
+    const size_t            num_layers  = 40;
+    std::vector<ExPolygons> outlines(num_layers);
+    outlines.front()                    = { square, holed };
+    const std::vector<double> max_moves(num_layers, 0.2);
+    const coordf_t          xy_distance = 0.5;
+    const coordf_t          max_radius  = 5.;
+    BoundingBox             domain      = get_extents(outlines.front());
+    domain.offset(scale_(max_radius + xy_distance + 1.));
+    TreeSupportDistanceField field(outlines, domain, xy_distance, max_moves, 0.1, max_radius);
+
+    REQUIRE(field.num_layers() == num_layers);
+    REQUIRE(field.covers(max_radius));
+    REQUIRE(! field.covers(max_radius + 1.));
+
+    SECTION("Collision is the outline offset by the radius and the XY distance") {
+        // Offset by 1.5mm with rounded corners, the hole shrunk by 1.5mm to 1mm x 1mm.
+        const double offset_area = 13. * 13. - (4. - M_PI) * 1.5 * 1.5;
+        ExPolygons   collision   = field.collision(1., 0);
+        REQUIRE(collision.size() == 2);
+        REQUIRE(collision.front().holes.size() + collision.back().holes.size() == 1);
+        REQUIRE(area_mm2(collision) == Approx(2. * offset_area - 1.).epsilon(0.02));
+        REQUIRE(field.collides(Point::new_scale(11.4, 5.), 1., 0));
+        REQUIRE(! field.collides(Point::new_scale(11.6, 5.), 1., 0));
+        REQUIRE(field.collides(Point::new_scale(35., 5.6), 1., 0));
+        REQUIRE(! field.collides(Point::new_scale(35., 5.), 1., 0));
+        // The hole closes for thicker branches.
+        collision = field.collision(1.6, 0);
+        REQUIRE(collision.size() == 2);
+        REQUIRE(collision.front().holes.empty());
+        REQUIRE(collision.back().holes.empty());
+        REQUIRE(field.collision(1., 1).empty());
+        REQUIRE(! field.collides(Point::new_scale(5., 5.), max_radius, 1));
+    }
+
+    SECTION("Avoidance shrinks by the maximum move distance per layer") {
+        // 1.5mm - 5 * 0.2mm.
+        REQUIRE(field.in_avoidance(Point::new_scale(10.4, 5.), 1., 5));
+        REQUIRE(! field.in_avoidance(Point::new_scale(10.6, 5.), 1., 5));
+        REQUIRE(field.in_avoidance(Point::new_scale(5., 5.), 1., 5));
+        // 1.5mm - 20 * 0.2mm = 2.5mm inside of the outline.
+        ExPolygons avoidance = field.avoidance(1., 20);
+        REQUIRE(avoidance.size() == 1);
+        REQUIRE(area_mm2(avoidance) == Approx(5. * 5.).epsilon(0.05));
+        REQUIRE(field.in_avoidance(Point::new_scale(5., 5.), 1., 20));
+        REQUIRE(! field.in_avoidance(Point::new_scale(2., 5.), 1., 20));
+        // Thicker branches are pushed further out.
+        REQUIRE(field.in_avoidance(Point::new_scale(2., 5.), 2., 20));
+        // Shrunk to nothing.
+        REQUIRE(field.avoidance(1., num_layers - 1).empty());
+        REQUIRE(! field.in_avoidance(Point::new_scale(5., 5.), 1., num_layers - 1));
+    }
+}
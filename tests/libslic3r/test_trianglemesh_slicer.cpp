@@ -0,0 +1,69 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+
+using namespace Slic3r;
+
+static double total_area(const Polygons &polygons)
+{
+    double area = 0.;
+    for (const Polygon &polygon : polygons)
+        area += polygon.area();
+    return area;
+}
+
+TEST_CASE("Slicing a large mesh at many layers", "[TriangleMeshSlicer]") {
+    // About 0.5M triangles.
+    const indexed_triangle_set its = its_make_sphere(10., PI / 360.);
+    std::vector<float> zs;
+    for (float z = -9.95f; z < 10.f; z += 0.1f)
+        zs.emplace_back(z);
+    MeshSlicingParams params;
+
+    std::vector<Polygons> layers = slice_mesh(its, zs, params);
+    REQUIRE(layers.size() == zs.size());
+
+    SECTION("Layers match slicing by a single plane") {
+        for (size_t i = 0; i < zs.size(); i += 7) {
+            Polygons single = slice_mesh(its, zs[i], params);
+            REQUIRE(layers[i].size() == single.size());
+            REQUIRE(total_area(layers[i]) == Approx(total_area(single)));
+        }
+    }
+
+    SECTION("Precalculated edge IDs produce the same layers") {
+        std::vector<Vec3i> face_edge_ids = its_face_edge_ids(its);
+        params.face_edge_ids = &face_edge_ids;
+        std::vector<Polygons> layers2 = slice_mesh(its, zs, params);
+        REQUIRE(layers2.size() == layers.size());
+        for (size_t i = 0; i < zs.size(); ++ i)
+            REQUIRE(layers2[i] == layers[i]);
+    }
+}
+
+TEST_CASE("Slicing kernels produce the same layers", "[TriangleMeshSlicer]") {
+    indexed_triangle_set its = its_make_sphere(10., PI / 90.);
+    its_merge(its, its_make_cube(5., 5., 30.));
+    // Planes through the vertices of the cube and general planes.
+    std::vector<float> zs { 0.f, 5.f };
+    for (float z = -9.95f; z < 10.f; z += 0.1f)
+        zs.emplace_back(z);
+    zs.emplace_back(30.f);
+    std::sort(zs.begin(), zs.end());
+    MeshSlicingParams params;
+    params.trafo = Transform3d(Eigen::AngleAxisd(0.3, Vec3d::UnitX()));
+
+    const SliceFacetKernel active = slice_facet_kernel();
+    REQUIRE(set_slice_facet_kernel(SliceFacetKernel::Scalar));
+    const std::vector<Polygons> layers_scalar = slice_mesh(its, zs, params);
+    const std::vector<Polygons> layers_scalar_identity = slice_mesh(its, zs, MeshSlicingParams{});
+    for (SliceFacetKernel kernel : { SliceFacetKernel::AVX2, SliceFacetKernel::NEON })
+        if (set_slice_facet_kernel(kernel)) {
+            REQUIRE(slice_mesh(its, zs, params) == layers_scalar);
+            REQUIRE(slice_mesh(its, zs, MeshSlicingParams{}) == layers_scalar_identity);
+        }
+    set_slice_facet_kernel(active);
+}